@@ -0,0 +1,142 @@
+/*
+ * Copyright 2024 Gary R. Van Sickle (grvs@users.sourceforge.net).
+ *
+ * This file is part of grvslib.
+ *
+ * grvslib is free software: you can redistribute it and/or modify it under the
+ * terms of version 3 of the GNU General Public License as published by the Free
+ * Software Foundation.
+ *
+ * grvslib is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * grvslib.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file Compares reader throughput of atomic_snapshot against std::atomic<std::shared_ptr> and a mutex-guarded
+ *       std::shared_ptr, with a writer publishing a new version every millisecond.
+ */
+
+// Std C++
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Ours.
+#include <grvslib/concurrency/atomic_snapshot.h>
+#include "bench_common.h"
+
+using namespace grvslib::bench;
+
+namespace
+{
+
+struct Config
+{
+	std::uint64_t m_version;
+	double m_values[14];
+};
+
+constexpr std::uint64_t c_reads_per_thread = 2'000'000;
+
+/// Runs @p num_readers threads each doing c_reads_per_thread reads, with a writer updating concurrently.
+template<typename Holder>
+void run(const std::string& name, int num_readers)
+{
+	Holder holder;
+	std::atomic<bool> done {false};
+	std::thread writer([&](){
+		std::uint64_t v = 1;
+		while(!done.load(std::memory_order_relaxed))
+		{
+			holder.write(Config{v++, {}});
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+	});
+
+	std::vector<std::thread> readers;
+	auto start = std::chrono::steady_clock::now();
+	for(int i = 0; i < num_readers; ++i)
+	{
+		readers.emplace_back([&](){
+			std::uint64_t sum = 0;
+			for(std::uint64_t j = 0; j < c_reads_per_thread; ++j)
+			{
+				sum += holder.read();
+			}
+			do_not_optimize(sum);
+		});
+	}
+	for(auto& t : readers)
+	{
+		t.join();
+	}
+	auto end = std::chrono::steady_clock::now();
+	done = true;
+	writer.join();
+
+	// Per-read latency as seen by one reader.
+	double ns = std::chrono::duration<double, std::nano>(end - start).count() / static_cast<double>(c_reads_per_thread);
+	report(name + ", " + std::to_string(num_readers) + " readers", ns);
+}
+
+struct snapshot_holder
+{
+	atomic_snapshot<Config> m_holder {Config{0, {}}};
+	std::uint64_t read() { return m_holder.load()->m_version; }
+	void write(const Config& c) { m_holder.store(c); }
+};
+
+#if __cpp_lib_atomic_shared_ptr >= 201711L
+struct atomic_shared_ptr_holder
+{
+	std::atomic<std::shared_ptr<const Config>> m_holder {std::make_shared<const Config>(Config{0, {}})};
+	std::uint64_t read() { return m_holder.load()->m_version; }
+	void write(const Config& c) { m_holder.store(std::make_shared<const Config>(c)); }
+};
+#endif
+
+struct mutex_shared_ptr_holder
+{
+	std::mutex m_mutex;
+	std::shared_ptr<const Config> m_holder {std::make_shared<const Config>(Config{0, {}})};
+	std::uint64_t read()
+	{
+		std::shared_ptr<const Config> p;
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			p = m_holder;
+		}
+		return p->m_version;
+	}
+	void write(const Config& c)
+	{
+		auto p = std::make_shared<const Config>(c);
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_holder.swap(p);
+	}
+};
+
+}
+
+int main()
+{
+	const int max_readers = std::thread::hardware_concurrency() > 1 ? static_cast<int>(std::thread::hardware_concurrency()) : 1;
+	for(int n = 1; n <= max_readers; n *= 2)
+	{
+		run<snapshot_holder>("atomic_snapshot::load()", n);
+#if __cpp_lib_atomic_shared_ptr >= 201711L
+		run<atomic_shared_ptr_holder>("std::atomic<std::shared_ptr>::load()", n);
+#endif
+		run<mutex_shared_ptr_holder>("mutex + std::shared_ptr copy", n);
+	}
+	return 0;
+}
@@ -0,0 +1,123 @@
+/*
+ * Copyright 2024 Gary R. Van Sickle (grvs@users.sourceforge.net).
+ *
+ * This file is part of grvslib.
+ *
+ * grvslib is free software: you can redistribute it and/or modify it under the
+ * terms of version 3 of the GNU General Public License as published by the Free
+ * Software Foundation.
+ *
+ * grvslib is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * grvslib.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file Throughput of a fixed amount of per-block work split over 1..N block_pipeline stages.
+ *
+ * The total work per block stays the same as the stage count goes up, so on an idle machine with enough cores the
+ * time per block should fall roughly as 1/stages until the handoff cost or the core count catches up with it.
+ */
+
+// Std C++
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <thread>
+
+// Ours.
+#include <grvslib/concurrency/block_pipeline.h>
+#include "bench_common.h"
+
+using namespace grvslib::bench;
+
+namespace
+{
+
+constexpr std::size_t c_block_samples = 256;
+constexpr std::uint64_t c_num_blocks = 20'000;
+/// One-pole lowpass passes per block, split evenly over the stages.
+constexpr int c_total_passes = 64;
+
+void run(int num_stages)
+{
+	const int num_cpus = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+	block_pipeline::options opts;
+	opts.m_block_samples = c_block_samples;
+	for(int i = 0; i < num_stages; ++i)
+	{
+		opts.m_stage_cpus.push_back(i % num_cpus);
+	}
+	if(num_stages >= num_cpus)
+	{
+		// Oversubscribed: a spinning stage would only be holding up the one it's waiting for.
+		opts.m_spin_iterations = 0;
+	}
+	block_pipeline pipeline(opts);
+
+	const int passes = c_total_passes / num_stages;
+	for(int i = 0; i < num_stages; ++i)
+	{
+		pipeline.add_stage([passes, state = 0.0f](const block_pipeline::block& in, block_pipeline::block& out) mutable {
+			out.m_samples = in.m_samples;
+			for(int p = 0; p < passes; ++p)
+			{
+				for(auto& s : out.m_samples)
+				{
+					state += 0.1f * (s - state);
+					s = state;
+				}
+			}
+		});
+	}
+	pipeline.start();
+
+	auto start = std::chrono::steady_clock::now();
+	std::uint64_t num_in {0}, num_out {0};
+	while(num_out < c_num_blocks)
+	{
+		bool idle = true;
+		if(num_in < c_num_blocks)
+		{
+			if(auto* b = pipeline.try_reserve_input(); b != nullptr)
+			{
+				std::fill(b->m_samples.begin(), b->m_samples.end(), static_cast<float>(num_in & 1));
+				pipeline.commit_input();
+				++num_in;
+				idle = false;
+			}
+		}
+		if(const auto* b = pipeline.try_front_output(); b != nullptr)
+		{
+			do_not_optimize(b->m_samples[0]);
+			pipeline.pop_output();
+			++num_out;
+			idle = false;
+		}
+		if(idle)
+		{
+			// Don't starve the stages if we're sharing a core with one.
+			std::this_thread::yield();
+		}
+	}
+	auto end = std::chrono::steady_clock::now();
+	pipeline.stop();
+
+	report("block_pipeline, " + std::to_string(num_stages) + " stages, ns per block",
+		   std::chrono::duration<double, std::nano>(end - start).count() / c_num_blocks);
+}
+
+}
+
+int main()
+{
+	for(int n = 1; n <= 8; n *= 2)
+	{
+		run(n);
+	}
+	return 0;
+}
@@ -0,0 +1,93 @@
+/*
+ * Copyright 2024 Gary R. Van Sickle (grvs@users.sourceforge.net).
+ *
+ * This file is part of grvslib.
+ *
+ * grvslib is free software: you can redistribute it and/or modify it under the
+ * terms of version 3 of the GNU General Public License as published by the Free
+ * Software Foundation.
+ *
+ * grvslib is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * grvslib.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file Compares a store-and-load of a 4 KB payload in which one 16-byte field changed, through
+ *       atomic_notifying_parameter (copies everything twice) and field_tracking_parameter (copies the one field).
+ */
+
+// Std C++
+#include <array>
+#include <cstdint>
+
+// Ours.
+#include <grvslib/concurrency/realtime.h>
+#include <grvslib/concurrency/field_tracking_parameter.h>
+#include "bench_common.h"
+
+using namespace grvslib::bench;
+
+namespace
+{
+
+constexpr std::uint64_t c_iterations = 2'000'000;
+
+struct eq_band
+{
+	float m_frequency;
+	float m_gain;
+	float m_q;
+	float m_type;
+};
+
+/// 256 bands, 4 KB.
+using eq_bands = std::array<eq_band, 256>;
+
+void bench_whole_payload()
+{
+	atomic_notifying_parameter<eq_bands> param;
+	eq_bands writer {}, reader {};
+	report("atomic_notifying_parameter, whole 4 KB", ns_per_op(c_iterations, [&](std::uint64_t i){
+		writer[100].m_gain = static_cast<float>(i);
+		param.store_and_set(writer);
+		param.load_and_clear_if_set(&reader);
+		do_not_optimize(reader);
+	}));
+}
+
+void bench_store_field()
+{
+	field_tracking_parameter<eq_bands> param;
+	eq_bands reader {};
+	report("field_tracking_parameter, store_field()", ns_per_op(c_iterations, [&](std::uint64_t i){
+		param.store_field<100>(eq_band{1000.0f, static_cast<float>(i), 0.707f, 0.0f});
+		param.load_and_clear_if_set(&reader);
+		do_not_optimize(reader);
+	}));
+}
+
+void bench_store_and_diff()
+{
+	field_tracking_parameter<eq_bands> param;
+	eq_bands writer {}, reader {};
+	report("field_tracking_parameter, store_and_set() with diff", ns_per_op(c_iterations, [&](std::uint64_t i){
+		writer[100].m_gain = static_cast<float>(i);
+		param.store_and_set(writer);
+		param.load_and_clear_if_set(&reader);
+		do_not_optimize(reader);
+	}));
+}
+
+}
+
+int main()
+{
+	bench_whole_payload();
+	bench_store_field();
+	bench_store_and_diff();
+	return 0;
+}
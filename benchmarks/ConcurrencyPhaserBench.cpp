@@ -0,0 +1,84 @@
+/*
+ * Copyright 2024 Gary R. Van Sickle (grvs@users.sourceforge.net).
+ *
+ * This file is part of grvslib.
+ *
+ * grvslib is free software: you can redistribute it and/or modify it under the
+ * terms of version 3 of the GNU General Public License as published by the Free
+ * Software Foundation.
+ *
+ * grvslib is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * grvslib.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file Time per phase of spin_phaser versus std::barrier, with no work between phases.
+ */
+
+// Std C++
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+#if __has_include(<barrier>)
+#include <barrier>
+#endif
+
+// Ours.
+#include <grvslib/concurrency/realtime.h>
+#include "bench_common.h"
+
+using namespace grvslib::bench;
+
+namespace
+{
+
+constexpr int c_num_phases = 100'000;
+
+template<typename ArriveAndWait>
+void run(const std::string& name, int num_threads, ArriveAndWait arrive_and_wait)
+{
+	std::vector<std::thread> threads;
+	auto start = std::chrono::steady_clock::now();
+	for(int t = 0; t < num_threads; ++t)
+	{
+		threads.emplace_back([&, t](){
+			for(int i = 0; i < c_num_phases; ++i)
+			{
+				arrive_and_wait(t);
+			}
+		});
+	}
+	for(auto& t : threads)
+	{
+		t.join();
+	}
+	auto end = std::chrono::steady_clock::now();
+	report(name + ", " + std::to_string(num_threads) + " threads",
+		   std::chrono::duration<double, std::nano>(end - start).count() / c_num_phases);
+}
+
+}
+
+int main()
+{
+	const int max_threads = std::max(2, static_cast<int>(std::thread::hardware_concurrency()));
+	for(int n = 2; n <= max_threads; n *= 2)
+	{
+#if __cpp_lib_atomic_wait >= 201907L
+		spin_phaser phaser(n);
+		run("spin_phaser::arrive_and_wait()", n, [&](int t){ phaser.arrive_and_wait(t); });
+#endif
+#if __cpp_lib_barrier >= 201907L
+		std::barrier barrier(n);
+		run("std::barrier::arrive_and_wait()", n, [&](int){ barrier.arrive_and_wait(); });
+#endif
+	}
+	return 0;
+}
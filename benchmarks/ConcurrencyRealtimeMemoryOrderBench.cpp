@@ -0,0 +1,151 @@
+/*
+ * Copyright 2024 Gary R. Van Sickle (grvs@users.sourceforge.net).
+ *
+ * This file is part of grvslib.
+ *
+ * grvslib is free software: you can redistribute it and/or modify it under the
+ * terms of version 3 of the GNU General Public License as published by the Free
+ * Software Foundation.
+ *
+ * grvslib is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * grvslib.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file Compares the cost of atomic_notifying_parameter operations under the acquire/release and the seq_cst
+ *       memory-order policies.
+ */
+
+// Std C++
+#include <atomic>
+#include <cstdint>
+#include <thread>
+
+// Ours.
+#include <grvslib/concurrency/realtime.h>
+#include "bench_common.h"
+
+using namespace grvslib::bench;
+
+namespace
+{
+
+constexpr std::uint64_t c_iterations = 20'000'000;
+
+struct SmallStruct
+{
+	float m_freq;
+	float m_q;
+	double m_gain;
+	std::uint64_t m_type;
+};
+
+template<typename Policy>
+void bench_store_uncontended(const char* name)
+{
+	atomic_notifying_parameter<int, Policy> param;
+	report(name, ns_per_op(c_iterations, [&](std::uint64_t i){ param.store_and_set(static_cast<int>(i)); }));
+}
+
+template<typename Policy>
+void bench_store_with_consumer(const char* name)
+{
+	atomic_notifying_parameter<int, Policy> param;
+	std::atomic<bool> stop {false};
+	std::thread consumer([&](){
+		int value {0};
+		while(!stop.load(std::memory_order_relaxed))
+		{
+			param.load_and_clear_if_set(&value);
+			do_not_optimize(value);
+		}
+	});
+	report(name, ns_per_op(c_iterations, [&](std::uint64_t i){ param.store_and_set(static_cast<int>(i)); }));
+	stop = true;
+	consumer.join();
+}
+
+template<typename Policy>
+void bench_load_no_update(const char* name)
+{
+	atomic_notifying_parameter<int, Policy> param;
+	int value {0};
+	report(name, ns_per_op(c_iterations, [&](std::uint64_t){
+		do_not_optimize(param.load_and_clear_if_set(&value));
+	}));
+}
+
+template<typename Policy>
+void bench_round_trip(const char* name)
+{
+	atomic_notifying_parameter<int, Policy> param;
+	int value {0};
+	report(name, ns_per_op(c_iterations, [&](std::uint64_t i){
+		param.store_and_set(static_cast<int>(i));
+		param.load_and_clear_if_set(&value);
+		do_not_optimize(value);
+	}));
+}
+
+template<typename Policy>
+void bench_struct_store(const char* name)
+{
+	atomic_notifying_parameter<SmallStruct, Policy> param;
+	SmallStruct s {};
+	report(name, ns_per_op(c_iterations / 4, [&](std::uint64_t i){
+		s.m_type = i;
+		param.store_and_set(s);
+	}));
+}
+
+/// A 16-byte payload, which goes through a 16-byte CAS where there is one rather than the spinlock.
+struct StereoPair
+{
+	double m_left;
+	double m_right;
+};
+
+/// One double too many for that, for comparison.
+struct StereoPairAndGain
+{
+	double m_left;
+	double m_right;
+	double m_gain;
+};
+
+template<typename Payload>
+void bench_struct_round_trip(const char* name)
+{
+	atomic_notifying_parameter<Payload> param;
+	Payload s {}, value {};
+	report(name, ns_per_op(c_iterations / 4, [&](std::uint64_t i){
+		s.m_left = static_cast<double>(i);
+		param.store_and_set(s);
+		param.load_and_clear_if_set(&value);
+		do_not_optimize(value);
+	}));
+}
+
+} // namespace
+
+int main()
+{
+	bench_store_uncontended<memory_order_policy_acq_rel>("store_and_set<int> uncontended, acq_rel");
+	bench_store_uncontended<memory_order_policy_seq_cst>("store_and_set<int> uncontended, seq_cst");
+	bench_store_with_consumer<memory_order_policy_acq_rel>("store_and_set<int> with polling consumer, acq_rel");
+	bench_store_with_consumer<memory_order_policy_seq_cst>("store_and_set<int> with polling consumer, seq_cst");
+	bench_load_no_update<memory_order_policy_acq_rel>("load_and_clear_if_set<int> nothing new, acq_rel");
+	bench_load_no_update<memory_order_policy_seq_cst>("load_and_clear_if_set<int> nothing new, seq_cst");
+	bench_round_trip<memory_order_policy_acq_rel>("store + load round trip <int>, acq_rel");
+	bench_round_trip<memory_order_policy_seq_cst>("store + load round trip <int>, seq_cst");
+	bench_struct_store<memory_order_policy_acq_rel>("store_and_set<SmallStruct> uncontended, acq_rel");
+	bench_struct_store<memory_order_policy_seq_cst>("store_and_set<SmallStruct> uncontended, seq_cst");
+	bench_struct_round_trip<StereoPair>(atomic_notifying_parameter<StereoPair>::is_always_lock_free
+			? "store + load round trip <StereoPair>, 16-byte CAS" : "store + load round trip <StereoPair>, spinlock");
+	bench_struct_round_trip<StereoPairAndGain>("store + load round trip <StereoPairAndGain>, spinlock");
+	return 0;
+}
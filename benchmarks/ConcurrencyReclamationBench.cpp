@@ -0,0 +1,180 @@
+/*
+ * Copyright 2024 Gary R. Van Sickle (grvs@users.sourceforge.net).
+ *
+ * This file is part of grvslib.
+ *
+ * grvslib is free software: you can redistribute it and/or modify it under the
+ * terms of version 3 of the GNU General Public License as published by the Free
+ * Software Foundation.
+ *
+ * grvslib is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * grvslib.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file Compares reader overhead of epoch-based reclamation, hazard pointers and a mutex, with a writer replacing the
+ *       shared object every millisecond.
+ */
+
+// Std C++
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Ours.
+#include <grvslib/concurrency/epoch_reclamation.h>
+#include <grvslib/concurrency/hazard_pointer.h>
+#include "bench_common.h"
+
+using namespace grvslib::bench;
+
+namespace
+{
+
+struct Config
+{
+	std::uint64_t m_version;
+	double m_values[14];
+};
+
+constexpr std::uint64_t c_reads_per_thread = 2'000'000;
+
+/// Runs @p num_readers threads each doing c_reads_per_thread reads, with a writer updating concurrently.
+template<typename Holder>
+void run(const std::string& name, int num_readers)
+{
+	Holder holder;
+	std::atomic<bool> done {false};
+	std::thread writer([&](){
+		std::uint64_t v = 1;
+		while(!done.load(std::memory_order_relaxed))
+		{
+			holder.write(v++);
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+	});
+
+	std::vector<std::thread> readers;
+	auto start = std::chrono::steady_clock::now();
+	for(int i = 0; i < num_readers; ++i)
+	{
+		readers.emplace_back([&](){
+			auto reader = holder.make_reader();
+			std::uint64_t sum = 0;
+			for(std::uint64_t j = 0; j < c_reads_per_thread; ++j)
+			{
+				sum += holder.read(reader);
+			}
+			do_not_optimize(sum);
+		});
+	}
+	for(auto& t : readers)
+	{
+		t.join();
+	}
+	auto end = std::chrono::steady_clock::now();
+	done = true;
+	writer.join();
+
+	// Per-read latency as seen by one reader.
+	double ns = std::chrono::duration<double, std::nano>(end - start).count() / static_cast<double>(c_reads_per_thread);
+	report(name + ", " + std::to_string(num_readers) + " readers", ns);
+}
+
+struct ebr_holder
+{
+	epoch_domain m_domain {64, 4096};
+	epoch_domain::participant m_writer {m_domain.register_thread()};
+	std::atomic<Config*> m_current {new Config{0, {}}};
+
+	~ebr_holder() { delete m_current.load(); }
+
+	epoch_domain::participant make_reader() { return m_domain.register_thread(); }
+
+	std::uint64_t read(epoch_domain::participant& reader)
+	{
+		auto g = reader.pin();
+		return m_current.load(std::memory_order_acquire)->m_version;
+	}
+
+	void write(std::uint64_t v)
+	{
+		Config* old = m_current.exchange(new Config{v, {}}, std::memory_order_acq_rel);
+		{
+			auto g = m_writer.pin();
+			m_writer.retire(old);
+		}
+		m_domain.reclaim();
+	}
+};
+
+struct hp_config : Config, hazard_pointer_obj_base<hp_config>
+{
+	explicit hp_config(std::uint64_t v) : Config{v, {}} {}
+};
+
+struct hp_holder
+{
+	hazard_pointer_domain m_domain;
+	std::atomic<hp_config*> m_current {new hp_config(0)};
+
+	~hp_holder() { delete m_current.load(); }
+
+	hazard_pointer make_reader() { return make_hazard_pointer(m_domain); }
+
+	std::uint64_t read(hazard_pointer& reader)
+	{
+		const std::uint64_t v = reader.protect(m_current)->m_version;
+		reader.reset_protection();
+		return v;
+	}
+
+	void write(std::uint64_t v)
+	{
+		m_current.exchange(new hp_config(v), std::memory_order_acq_rel)->retire({}, m_domain);
+	}
+};
+
+struct mutex_holder
+{
+	struct no_reader {};
+
+	std::mutex m_mutex;
+	Config m_current {0, {}};
+
+	no_reader make_reader() { return {}; }
+
+	std::uint64_t read(no_reader&)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		return m_current.m_version;
+	}
+
+	void write(std::uint64_t v)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_current = Config{v, {}};
+	}
+};
+
+}
+
+int main()
+{
+	const int max_readers = std::thread::hardware_concurrency() > 1 ? static_cast<int>(std::thread::hardware_concurrency()) : 1;
+	for(int n = 1; n <= max_readers; n *= 2)
+	{
+		run<ebr_holder>("epoch_domain pin() + load", n);
+		run<hp_holder>("hazard_pointer protect() + reset_protection()", n);
+		run<mutex_holder>("mutex lock + load", n);
+	}
+	return 0;
+}
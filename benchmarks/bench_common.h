@@ -0,0 +1,74 @@
+/*
+ * Copyright 2024 Gary R. Van Sickle (grvs@users.sourceforge.net).
+ *
+ * This file is part of grvslib.
+ *
+ * grvslib is free software: you can redistribute it and/or modify it under the
+ * terms of version 3 of the GNU General Public License as published by the Free
+ * Software Foundation.
+ *
+ * grvslib is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * grvslib.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file Minimal helpers shared by the micro-benchmarks.  Deliberately dependency-free.
+ */
+
+#ifndef GRVSLIB_BENCH_COMMON_H
+#define GRVSLIB_BENCH_COMMON_H
+
+// Std C++
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <string_view>
+
+namespace grvslib::bench
+{
+
+/**
+ * Keep the compiler from optimizing away the computation of @p value.
+ */
+template<typename T>
+inline void do_not_optimize(T const& value)
+{
+#if defined(__GNUC__) || defined(__clang__)
+	asm volatile("" : : "r,m"(value) : "memory");
+#else
+	static volatile T const* sink;
+	sink = &value;
+#endif
+}
+
+/**
+ * Runs @p op @p iterations times and returns the mean time per call in nanoseconds.
+ */
+template<typename Op>
+double ns_per_op(std::uint64_t iterations, Op&& op)
+{
+	auto start = std::chrono::steady_clock::now();
+	for(std::uint64_t i = 0; i < iterations; ++i)
+	{
+		op(i);
+	}
+	auto end = std::chrono::steady_clock::now();
+	return std::chrono::duration<double, std::nano>(end - start).count() / static_cast<double>(iterations);
+}
+
+/**
+ * Print one result line in a fixed, grep-friendly format.
+ */
+inline void report(std::string_view name, double ns_per_op_value)
+{
+	std::printf("%-60.*s %10.2f ns/op %14.0f ops/s\n", static_cast<int>(name.size()), name.data(), ns_per_op_value,
+			 ns_per_op_value > 0.0 ? 1.0e9 / ns_per_op_value : 0.0);
+}
+
+} // namespace grvslib::bench
+
+#endif //GRVSLIB_BENCH_COMMON_H
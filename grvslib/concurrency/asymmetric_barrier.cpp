@@ -0,0 +1,67 @@
+/*
+ * Copyright 2024 Gary R. Van Sickle (grvs@users.sourceforge.net).
+ *
+ * This file is part of grvslib.
+ *
+ * grvslib is free software: you can redistribute it and/or modify it under the
+ * terms of version 3 of the GNU General Public License as published by the Free
+ * Software Foundation.
+ *
+ * grvslib is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * grvslib.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "asymmetric_barrier.h"
+
+// Std C++
+#include <cerrno>
+#include <cstdlib>
+
+#if defined(__linux__)
+#include <linux/membarrier.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace grvslib::impl
+{
+
+bool register_process_membarrier() noexcept
+{
+#if defined(__linux__) && defined(__NR_membarrier)
+	const long supported = ::syscall(__NR_membarrier, MEMBARRIER_CMD_QUERY, 0, 0);
+	if(supported < 0 || (supported & MEMBARRIER_CMD_PRIVATE_EXPEDITED) == 0)
+	{
+		return false;
+	}
+	return ::syscall(__NR_membarrier, MEMBARRIER_CMD_REGISTER_PRIVATE_EXPEDITED, 0, 0) == 0;
+#else
+	return false;
+#endif
+}
+
+void asymmetric_heavy_barrier() noexcept
+{
+#if defined(__linux__) && defined(__NR_membarrier)
+	if(have_fast_heavy_barrier())
+	{
+		// Readers are down to a compiler barrier, so a fence here wouldn't pair with anything.  Retry or give up.
+		while(::syscall(__NR_membarrier, MEMBARRIER_CMD_PRIVATE_EXPEDITED, 0, 0) != 0)
+		{
+			if(errno != EINTR)
+			{
+				std::abort();
+			}
+		}
+		return;
+	}
+#endif
+	// The light side is a full fence in this case, so a full fence here pairs with it.
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+}
+
+}
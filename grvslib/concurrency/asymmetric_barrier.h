@@ -0,0 +1,82 @@
+/*
+ * Copyright 2024 Gary R. Van Sickle (grvs@users.sourceforge.net).
+ *
+ * This file is part of grvslib.
+ *
+ * grvslib is free software: you can redistribute it and/or modify it under the
+ * terms of version 3 of the GNU General Public License as published by the Free
+ * Software Foundation.
+ *
+ * grvslib is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * grvslib.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file An asymmetric memory barrier: a nearly free "light" side for hot reader paths, paired with an expensive
+ *       "heavy" side for the rare thread that needs to see every reader's stores.
+ */
+
+#ifndef GRVSLIB_ASYMMETRIC_BARRIER_H
+#define GRVSLIB_ASYMMETRIC_BARRIER_H
+
+// Std C++
+#include <atomic>
+
+namespace grvslib::impl
+{
+
+/**
+ * Register this process for the expedited membarrier(2).  Returns true if asymmetric_heavy_barrier() can use it.
+ * Called once, by have_fast_heavy_barrier().
+ */
+bool register_process_membarrier() noexcept;
+
+/// True if asymmetric_heavy_barrier() forces a barrier on every running thread, so the light side can be free.
+inline bool have_fast_heavy_barrier() noexcept
+{
+	static const bool s_have = register_process_membarrier();
+	return s_have;
+}
+
+/**
+ * Do have_fast_heavy_barrier()'s one-time registration now.  It makes two system calls under a static-init guard,
+ * so anything whose hot path uses asymmetric_light_barrier() calls this from its setup (domain construction, thread
+ * registration), keeping that off the RT thread.
+ */
+inline void prime_asymmetric_barrier() noexcept
+{
+	static_cast<void>(have_fast_heavy_barrier());
+}
+
+/**
+ * The reader's side: order a preceding store before following loads, as far as a thread calling
+ * asymmetric_heavy_barrier() is concerned.  With membarrier(2) that's just a compiler barrier; without it, a full
+ * fence.
+ */
+inline void asymmetric_light_barrier() noexcept
+{
+	if(have_fast_heavy_barrier())
+	{
+		std::atomic_signal_fence(std::memory_order_seq_cst);
+	}
+	else
+	{
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+	}
+}
+
+/**
+ * The reclaimer's side: after this returns, every other thread's stores before its last asymmetric_light_barrier()
+ * are visible, or its loads after it will see our stores before this.  Costs a system call and an IPI to every CPU
+ * running one of our threads, so keep it off RT threads.  Aborts if membarrier(2) fails after registering
+ * succeeded, since the light side is no longer a fence and there's nothing sound to fall back to.
+ */
+void asymmetric_heavy_barrier() noexcept;
+
+}
+
+#endif //GRVSLIB_ASYMMETRIC_BARRIER_H
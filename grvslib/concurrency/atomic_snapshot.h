@@ -0,0 +1,238 @@
+/*
+ * Copyright 2024 Gary R. Van Sickle (grvs@users.sourceforge.net).
+ *
+ * This file is part of grvslib.
+ *
+ * grvslib is free software: you can redistribute it and/or modify it under the
+ * terms of version 3 of the GNU General Public License as published by the Free
+ * Software Foundation.
+ *
+ * grvslib is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * grvslib.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file A lock-free holder of an immutable, shared, replaceable object, for read-mostly configuration data.
+ */
+
+#ifndef GRVSLIB_ATOMIC_SNAPSHOT_H
+#define GRVSLIB_ATOMIC_SNAPSHOT_H
+
+// Std C++
+#include <atomic>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+
+// Ours.
+#include "cache_line.h"
+
+/**
+ * Holds a pointer to an immutable T which any number of threads can take a reference-counted snapshot of, while any
+ * number of other threads replace it with a new version.  Think std::atomic<std::shared_ptr<const T>>, except that
+ * libstdc++'s and MSVC's implementations of that take an internal spinlock, and this is lock-free.
+ *
+ * This is the split ("differential") reference counting scheme: the published pointer and an "external" count are
+ * packed into one atomic word, and each version also has an "internal" count.  A reader:
+ *
+ * 1. fetch_add()s the external count, which pins the version the pointer refers to,
+ * 2. takes an ordinary reference on the internal count, and
+ * 3. CASes its external increment back off again, if that version is still the published one.
+ *
+ * Step 3 keeps the external count bounded by the number of readers concurrently between steps 1 and 3, rather than
+ * growing with every read.  When a writer replaces the published version, it folds the old version's outstanding
+ * external count into its internal count; whoever brings the internal count to zero deletes it.
+ *
+ * Reads are lock-free (not wait-free: step 3 is a CAS loop), and never allocate.  Writes allocate a new version.
+ *
+ * @note The last snapshot of a version to be released deletes it, on whatever thread that happens to be.  If that
+ *       mustn't be an RT thread, have a non-RT thread hold a snapshot of each version too.
+ * @note On 64-bit platforms this assumes user-space pointers fit in 48 bits, which is true on x86-64 and on ARM64
+ *       without pointer tagging.
+ *
+ * @tparam T  The type of the configuration object.
+ */
+template<typename T>
+class atomic_snapshot
+{
+	struct version
+	{
+		template<typename... Args>
+		explicit version(Args&&... args) : m_value(std::forward<Args>(args)...) {}
+
+		/// References held by snapshots, plus one for the holder while this version is published, plus the external
+		/// references folded in when it's unpublished.
+		std::atomic<std::int64_t> m_internal_count {1};
+		const T m_value;
+	};
+
+	static constexpr unsigned c_count_shift = sizeof(void*) == 8 ? 48 : 32;
+	static constexpr std::uint64_t c_one_external = std::uint64_t(1) << c_count_shift;
+	static constexpr std::uint64_t c_pointer_mask = c_one_external - 1;
+
+	static std::uint64_t pack(version* v) noexcept
+	{
+		// A freshly-published version starts with one external reference, the holder's own.
+		return c_one_external | reinterpret_cast<std::uintptr_t>(v);
+	}
+	static version* pointer_of(std::uint64_t word) noexcept
+	{
+		return reinterpret_cast<version*>(static_cast<std::uintptr_t>(word & c_pointer_mask));
+	}
+	static std::int64_t external_count_of(std::uint64_t word) noexcept
+	{
+		return static_cast<std::int64_t>(word >> c_count_shift);
+	}
+
+	static void release(version* v) noexcept
+	{
+		if(v->m_internal_count.fetch_sub(1, std::memory_order_acq_rel) == 1)
+		{
+			delete v;
+		}
+	}
+
+	/// Called by whoever takes @p word out of m_published.
+	static void unpublish(std::uint64_t word) noexcept
+	{
+		version* v = pointer_of(word);
+		if(v == nullptr)
+		{
+			return;
+		}
+		// Fold in the readers' outstanding external references, and drop the holder's reference, which is counted
+		// both externally and internally.
+		const std::int64_t count_increase = external_count_of(word) - 2;
+		if(v->m_internal_count.fetch_add(count_increase, std::memory_order_acq_rel) == -count_increase)
+		{
+			delete v;
+		}
+	}
+
+public:
+	static constexpr bool is_always_lock_free = std::atomic<std::uint64_t>::is_always_lock_free;
+
+	/**
+	 * A reference-counted, read-only view of one version.  Stays valid however many times the atomic_snapshot is
+	 * updated afterwards.
+	 */
+	class snapshot
+	{
+	public:
+		snapshot() noexcept = default;
+		snapshot(const snapshot& other) noexcept : m_version(other.m_version)
+		{
+			if(m_version != nullptr)
+			{
+				m_version->m_internal_count.fetch_add(1, std::memory_order_relaxed);
+			}
+		}
+		snapshot(snapshot&& other) noexcept : m_version(std::exchange(other.m_version, nullptr)) {}
+		snapshot& operator=(snapshot other) noexcept
+		{
+			std::swap(m_version, other.m_version);
+			return *this;
+		}
+		~snapshot()
+		{
+			if(m_version != nullptr)
+			{
+				release(m_version);
+			}
+		}
+
+		const T* get() const noexcept { return m_version != nullptr ? &m_version->m_value : nullptr; }
+		const T& operator*() const noexcept { return m_version->m_value; }
+		const T* operator->() const noexcept { return &m_version->m_value; }
+		explicit operator bool() const noexcept { return m_version != nullptr; }
+
+	private:
+		friend class atomic_snapshot;
+		explicit snapshot(version* v) noexcept : m_version(v) {}
+
+		version* m_version {nullptr};
+	};
+
+	/// Starts out empty; load() returns an empty snapshot until the first store().
+	atomic_snapshot() noexcept = default;
+
+	explicit atomic_snapshot(T initial) : m_published(pack(new version(std::move(initial)))) {}
+
+	atomic_snapshot(const atomic_snapshot&) = delete;
+	atomic_snapshot& operator=(const atomic_snapshot&) = delete;
+
+	~atomic_snapshot()
+	{
+		unpublish(m_published.load(std::memory_order_acquire));
+	}
+
+	/**
+	 * Take a snapshot of the current version.  Lock-free; doesn't allocate.
+	 */
+	snapshot load() const noexcept
+	{
+		// 1. Pin whatever is published.
+		std::uint64_t word = m_published.fetch_add(c_one_external, std::memory_order_acquire);
+		version* v = pointer_of(word);
+		if(v == nullptr)
+		{
+			// Take our external increment back off, unless a store() already has.
+			word += c_one_external;
+			while(pointer_of(word) == nullptr)
+			{
+				if(m_published.compare_exchange_weak(word, word - c_one_external, std::memory_order_relaxed))
+				{
+					break;
+				}
+			}
+			return snapshot();
+		}
+
+		// 2. Take a real reference.  Safe, since the external count keeps v alive.
+		v->m_internal_count.fetch_add(1, std::memory_order_relaxed);
+
+		// 3. Give the external one back.
+		word += c_one_external;
+		while(pointer_of(word) == v)
+		{
+			if(m_published.compare_exchange_weak(word, word - c_one_external, std::memory_order_relaxed))
+			{
+				return snapshot(v);
+			}
+		}
+		// A store() unpublished v, and folded our external increment into the internal count.  We now have two
+		// references, so drop one.  This can't be the last one.
+		v->m_internal_count.fetch_sub(1, std::memory_order_relaxed);
+		return snapshot(v);
+	}
+
+	/**
+	 * Publish a new version.  Existing snapshots keep referring to the version they were taken of.
+	 */
+	void store(T value)
+	{
+		publish(new version(std::move(value)));
+	}
+
+	/// Construct and publish a new version in place.
+	template<typename... Args>
+	void emplace(Args&&... args)
+	{
+		publish(new version(std::forward<Args>(args)...));
+	}
+
+private:
+	void publish(version* v) noexcept
+	{
+		unpublish(m_published.exchange(pack(v), std::memory_order_acq_rel));
+	}
+
+	/// {external count, version pointer}.  On its own cache line, since every load() RMWs it.
+	alignas(grvslib::impl::cache_line_size) mutable std::atomic<std::uint64_t> m_published {0};
+};
+
+#endif //GRVSLIB_ATOMIC_SNAPSHOT_H
@@ -0,0 +1,135 @@
+/*
+ * Copyright 2024 Gary R. Van Sickle (grvs@users.sourceforge.net).
+ *
+ * This file is part of grvslib.
+ *
+ * grvslib is free software: you can redistribute it and/or modify it under the
+ * terms of version 3 of the GNU General Public License as published by the Free
+ * Software Foundation.
+ *
+ * grvslib is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * grvslib.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "block_pipeline.h"
+
+// Std C++
+#include <stdexcept>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+block_pipeline::block_pipeline() : block_pipeline(options{})
+{
+}
+
+block_pipeline::block_pipeline(options opts) : m_options(std::move(opts))
+{
+}
+
+block_pipeline::~block_pipeline()
+{
+	stop();
+}
+
+std::size_t block_pipeline::add_stage(stage_function f, std::string name)
+{
+	if(!m_links.empty())
+	{
+		throw std::logic_error("block_pipeline: add_stage() after start()");
+	}
+	m_stages.push_back(stage{std::move(f), std::move(name), std::make_unique<std::atomic<std::uint64_t>>(0)});
+	return m_stages.size() - 1;
+}
+
+void block_pipeline::start()
+{
+	if(m_stages.empty())
+	{
+		throw std::logic_error("block_pipeline: no stages");
+	}
+	if(!m_links.empty())
+	{
+		return;
+	}
+
+	block prototype;
+	prototype.m_samples.resize(m_options.m_block_samples);
+	for(std::size_t i = 0; i <= m_stages.size(); ++i)
+	{
+		m_links.push_back(std::make_unique<spsc_ring<block>>(m_options.m_blocks_per_link, prototype));
+	}
+
+	m_stop.store(false, std::memory_order_relaxed);
+	for(std::size_t i = 0; i < m_stages.size(); ++i)
+	{
+		m_threads.emplace_back([this, i](){ stage_main(i); });
+	}
+}
+
+void block_pipeline::stop()
+{
+	m_stop.store(true, std::memory_order_release);
+	for(auto& t : m_threads)
+	{
+		t.join();
+	}
+	m_threads.clear();
+}
+
+void block_pipeline::stage_main(std::size_t index)
+{
+#if defined(__linux__)
+	if(!m_options.m_stage_cpus.empty())
+	{
+		cpu_set_t set;
+		CPU_ZERO(&set);
+		CPU_SET(m_options.m_stage_cpus[index % m_options.m_stage_cpus.size()], &set);
+		pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+	}
+	if(m_options.m_sched_fifo_priority > 0)
+	{
+		sched_param param {};
+		param.sched_priority = m_options.m_sched_fifo_priority;
+		pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+	}
+#endif
+
+	stage& s = m_stages[index];
+	spsc_ring<block>& input = *m_links[index];
+	spsc_ring<block>& output = *m_links[index + 1];
+	std::uint32_t idle_rounds = 0;
+
+	while(!m_stop.load(std::memory_order_acquire))
+	{
+		block* in = input.front();
+		block* out = in != nullptr ? output.try_reserve() : nullptr;
+		if(out == nullptr)
+		{
+			// Starved or backed up.
+			if(++idle_rounds < m_options.m_spin_iterations)
+			{
+				grvslib::impl::cpu_relax();
+			}
+			else
+			{
+				idle_rounds = 0;
+				std::this_thread::yield();
+			}
+			continue;
+		}
+		idle_rounds = 0;
+
+		s.m_function(*in, *out);
+		out->m_sequence = in->m_sequence;
+		output.commit();
+		input.pop();
+		s.m_blocks_processed->fetch_add(1, std::memory_order_relaxed);
+	}
+}
@@ -0,0 +1,181 @@
+/*
+ * Copyright 2024 Gary R. Van Sickle (grvs@users.sourceforge.net).
+ *
+ * This file is part of grvslib.
+ *
+ * grvslib is free software: you can redistribute it and/or modify it under the
+ * terms of version 3 of the GNU General Public License as published by the Free
+ * Software Foundation.
+ *
+ * grvslib is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * grvslib.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file A pipeline of block-processing stages, each on its own thread, linked by zero-copy SPSC rings.
+ */
+
+#ifndef GRVSLIB_BLOCK_PIPELINE_H
+#define GRVSLIB_BLOCK_PIPELINE_H
+
+// Std C++
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Ours.
+#include "realtime.h"
+#include "spsc_ring.h"
+
+/**
+ * Runs a chain of block-processing stages as a pipeline, one thread per stage.
+ *
+ * For long effect chains this trades latency for throughput.  With N stages, a block comes out N-1 stage-times
+ * later than it would if one thread ran the whole chain, but up to N blocks are in flight at once on N cores.
+ * dag_executor is the other way to spread a graph over cores: it adds no latency, but it only helps when the graph
+ * is wide.
+ *
+ * Adjacent stages are linked by an spsc_ring of preallocated blocks.  A stage reads its input block in place with
+ * front(), reserves its output block with try_reserve(), processes one into the other, then commit()s the output and
+ * pop()s the input.  No block is ever copied or allocated once start() has been called.
+ *
+ * The source thread feeds the first ring with try_reserve_input()/commit_input().  The sink thread drains the last
+ * one with try_front_output()/pop_output().  These may be the same thread.
+ *
+ * Stages get their parameters the same way a single DSP thread would.  Each stage polls its own
+ * atomic_notifying_parameter once per block; the add_stage() overload which takes one does the polling for you.
+ */
+class block_pipeline
+{
+public:
+	/// One block of samples.  Interpreting them (channels, interleaving) is up to the stages.
+	struct block
+	{
+		std::vector<float> m_samples;
+		/// Set by the source, and carried through every stage unchanged.
+		std::uint64_t m_sequence {0};
+	};
+
+	/// Process @p in into @p out.  @p out is the same size as @p in, and holds stale data.
+	using stage_function = std::function<void(const block& in, block& out)>;
+
+	struct options
+	{
+		/// Samples per block.
+		std::size_t m_block_samples {256};
+		/// Blocks in each ring between stages.  Two is enough to keep neighbours from waiting on each other.
+		std::size_t m_blocks_per_link {4};
+		/// If non-empty, stage i's thread is pinned to CPU m_stage_cpus[i % size()].  Linux only.
+		std::vector<int> m_stage_cpus;
+		/// If nonzero, stage threads run SCHED_FIFO at this priority.  Linux only; silently ignored if not permitted.
+		int m_sched_fifo_priority {0};
+		/// How long an idle stage spins before it starts yielding.
+		std::uint32_t m_spin_iterations {4000};
+	};
+
+	block_pipeline();
+	explicit block_pipeline(options opts);
+	/// Calls stop().
+	~block_pipeline();
+
+	block_pipeline(const block_pipeline&) = delete;
+	block_pipeline& operator=(const block_pipeline&) = delete;
+
+	/// Append a stage.  @throws std::logic_error after start().
+	std::size_t add_stage(stage_function f, std::string name = {});
+
+#if __cpp_lib_atomic_flag_test >= 201907L
+	/**
+	 * Append a stage which is passed the latest value of @p param.  The stage thread calls
+	 * param.load_and_clear_if_set() once before each block, so @p f always sees a whole, current parameter set.  With
+	 * an accumulating MergePolicy, @p f instead sees what was merged since the previous block, or the policy's identity
+	 * if nothing was.
+	 *
+	 * @param param    Must outlive the pipeline.  Producer threads update it with store_and_set() as usual.
+	 * @param initial  What @p f sees until the first store_and_set().
+	 * @param f        Called as f(in, out, current_value).
+	 */
+	template<typename PayloadType, typename MemoryOrderPolicy, typename NotificationPolicy, typename MergePolicy,
+			 typename F>
+	std::size_t add_stage(
+			atomic_notifying_parameter<PayloadType, MemoryOrderPolicy, NotificationPolicy, MergePolicy>& param,
+			PayloadType initial, F f, std::string name = {})
+	{
+		return add_stage([&param, current = std::move(initial), f = std::move(f)](const block& in, block& out) mutable {
+			if(!param.load_and_clear_if_set(&current))
+			{
+				if constexpr(MergePolicy::accumulates)
+				{
+					// Already applied last block.
+					grvslib::impl::reset_fields<MergePolicy>(current);
+				}
+			}
+			f(in, out, std::as_const(current));
+		}, std::move(name));
+	}
+#endif
+
+	/// Allocate the rings and start one thread per stage.  @throws std::logic_error if there are no stages.
+	void start();
+
+	/// Stop and join the stage threads.  Blocks still in the pipeline are dropped.  Idempotent, but a stopped pipeline can't be
+	/// restarted.
+	void stop();
+
+	/// @name Source side.  One thread only, after start().
+	///@{
+
+	/// @return The next block to fill in, or nullptr if the first stage is backed up.
+	block* try_reserve_input() { return m_links.front()->try_reserve(); }
+	/// Send the block from try_reserve_input() down the pipeline.
+	void commit_input() { m_links.front()->commit(); }
+
+	///@}
+
+	/// @name Sink side.  One thread only, after start().
+	///@{
+
+	/// @return The oldest processed block, or nullptr if there isn't one yet.  Valid until pop_output().
+	const block* try_front_output() { return m_links.back()->front(); }
+	/// Hand the block from try_front_output() back to the last stage.
+	void pop_output() { m_links.back()->pop(); }
+
+	///@}
+
+	std::size_t num_stages() const noexcept { return m_stages.size(); }
+	const std::string& name(std::size_t stage) const { return m_stages[stage].m_name; }
+	/// Blocks @p stage has processed since start().  Any thread.
+	std::uint64_t blocks_processed(std::size_t stage) const
+	{
+		return m_stages[stage].m_blocks_processed->load(std::memory_order_relaxed);
+	}
+
+private:
+	struct stage
+	{
+		stage_function m_function;
+		std::string m_name;
+		std::unique_ptr<std::atomic<std::uint64_t>> m_blocks_processed;
+	};
+
+	void stage_main(std::size_t index);
+
+	options m_options;
+	std::vector<stage> m_stages;
+	/// m_links[i] feeds stage i; m_links[i+1] is its output.
+	std::vector<std::unique_ptr<spsc_ring<block>>> m_links;
+	std::vector<std::thread> m_threads;
+	std::atomic<bool> m_stop {false};
+};
+
+#endif //GRVSLIB_BLOCK_PIPELINE_H
@@ -0,0 +1,40 @@
+/*
+ * Copyright 2024 Gary R. Van Sickle (grvs@users.sourceforge.net).
+ *
+ * This file is part of grvslib.
+ *
+ * grvslib is free software: you can redistribute it and/or modify it under the
+ * terms of version 3 of the GNU General Public License as published by the Free
+ * Software Foundation.
+ *
+ * grvslib is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * grvslib.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file A small header for hardware-related constants used by the concurrency primitives.
+ */
+
+#ifndef GRVSLIB_CACHE_LINE_H
+#define GRVSLIB_CACHE_LINE_H
+
+// Std C++
+#include <cstddef>
+
+namespace grvslib::impl
+{
+/**
+ * The size we pad to in order to keep independently-written atomics off each other's cache lines.
+ *
+ * @note We don't use std::hardware_destructive_interference_size here: GCC warns on every use of it in a header,
+ *       since its value can change with -mtune and so isn't ABI-stable.  64 is correct for every x86-64 and nearly
+ *       every ARM64 part we care about.
+ */
+constexpr static std::size_t cache_line_size = 64;
+}
+
+#endif //GRVSLIB_CACHE_LINE_H
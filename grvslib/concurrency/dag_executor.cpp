@@ -0,0 +1,324 @@
+/*
+ * Copyright 2024 Gary R. Van Sickle (grvs@users.sourceforge.net).
+ *
+ * This file is part of grvslib.
+ *
+ * grvslib is free software: you can redistribute it and/or modify it under the
+ * terms of version 3 of the GNU General Public License as published by the Free
+ * Software Foundation.
+ *
+ * grvslib is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * grvslib.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "dag_executor.h"
+
+// Std C++
+#include <algorithm>
+#include <chrono>
+#include <stdexcept>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+// Ours.
+#include "realtime.h"
+
+namespace grvslib::impl
+{
+
+work_stealing_deque::work_stealing_deque(std::size_t min_capacity)
+{
+	std::size_t capacity = 1;
+	while(capacity < min_capacity)
+	{
+		capacity *= 2;
+	}
+	m_mask = capacity - 1;
+	m_buffer = std::make_unique<std::atomic<std::uint32_t>[]>(capacity);
+}
+
+}
+
+namespace
+{
+
+std::int64_t steady_now_ns() noexcept
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(
+			std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+}
+
+dag_executor::dag_executor() : dag_executor(options{})
+{
+}
+
+dag_executor::dag_executor(options opts) : m_options(std::move(opts))
+{
+}
+
+dag_executor::~dag_executor()
+{
+	m_stop.store(true, std::memory_order_seq_cst);
+	m_generation.fetch_add(1, std::memory_order_seq_cst);
+#if __cpp_lib_atomic_wait >= 201907L
+	m_generation.notify_all();
+#endif
+	for(auto& t : m_workers)
+	{
+		t.join();
+	}
+}
+
+dag_executor::node_id dag_executor::add_node(std::function<void()> work, std::string name)
+{
+	if(m_finalized)
+	{
+		throw std::logic_error("dag_executor: add_node() after finalize()");
+	}
+	m_nodes.push_back(node{std::move(work), std::move(name), {}, {}, 0, {}});
+	return static_cast<node_id>(m_nodes.size() - 1);
+}
+
+void dag_executor::add_edge(node_id before, node_id after)
+{
+	if(m_finalized)
+	{
+		throw std::logic_error("dag_executor: add_edge() after finalize()");
+	}
+	m_nodes.at(before).m_successors.push_back(after);
+	m_nodes.at(after).m_predecessors.push_back(before);
+	m_nodes[after].m_num_predecessors++;
+}
+
+void dag_executor::finalize()
+{
+	if(m_finalized)
+	{
+		return;
+	}
+
+	// Kahn's algorithm, both to find cycles and to get the order critical_path() needs.
+	std::vector<std::uint32_t> in_degree(m_nodes.size());
+	for(std::size_t i = 0; i < m_nodes.size(); ++i)
+	{
+		in_degree[i] = m_nodes[i].m_num_predecessors;
+		if(in_degree[i] == 0)
+		{
+			m_sources.push_back(static_cast<node_id>(i));
+		}
+	}
+	m_topological_order = m_sources;
+	for(std::size_t i = 0; i < m_topological_order.size(); ++i)
+	{
+		for(node_id s : m_nodes[m_topological_order[i]].m_successors)
+		{
+			if(--in_degree[s] == 0)
+			{
+				m_topological_order.push_back(s);
+			}
+		}
+	}
+	if(m_topological_order.size() != m_nodes.size())
+	{
+		m_sources.clear();
+		m_topological_order.clear();
+		throw std::logic_error("dag_executor: the graph has a cycle");
+	}
+
+	m_pending = std::make_unique<pending_count[]>(m_nodes.size());
+	for(std::size_t i = 0; i < m_options.m_num_workers + 1; ++i)
+	{
+		m_deques.push_back(std::make_unique<grvslib::impl::work_stealing_deque>(m_nodes.size() + 1));
+	}
+	m_finalized = true;
+
+	for(std::size_t i = 1; i <= m_options.m_num_workers; ++i)
+	{
+		m_workers.emplace_back([this, i](){ worker_main(i); });
+	}
+}
+
+void dag_executor::run()
+{
+	if(!m_finalized)
+	{
+		finalize();
+	}
+	if(m_nodes.empty())
+	{
+		return;
+	}
+
+	m_block_start_ns.store(steady_now_ns(), std::memory_order_relaxed);
+	for(std::size_t i = 0; i < m_nodes.size(); ++i)
+	{
+		m_pending[i].m_value.store(m_nodes[i].m_num_predecessors, std::memory_order_relaxed);
+	}
+	m_remaining.store(static_cast<std::uint32_t>(m_nodes.size()), std::memory_order_relaxed);
+	for(node_id s : m_sources)
+	{
+		m_deques[0]->push(s);
+	}
+
+	// Start the block.  Same handshake as spin_phaser: only wake the workers if any of them parked.
+	m_generation.fetch_add(1, std::memory_order_seq_cst);
+#if __cpp_lib_atomic_wait >= 201907L
+	if(m_num_parked.load(std::memory_order_seq_cst) != 0)
+	{
+		m_generation.notify_all();
+	}
+#endif
+
+	work(0);
+}
+
+std::vector<dag_executor::node_id> dag_executor::critical_path(std::uint64_t* length_ns) const
+{
+	std::vector<std::uint64_t> longest(m_nodes.size(), 0);
+	std::vector<node_id> via(m_nodes.size(), ~node_id(0));
+	node_id last = ~node_id(0);
+	for(node_id n : m_topological_order)
+	{
+		const auto& t = m_nodes[n].m_timing;
+		std::uint64_t best_pred = 0;
+		for(node_id p : m_nodes[n].m_predecessors)
+		{
+			if(via[n] == ~node_id(0) || longest[p] > best_pred)
+			{
+				best_pred = longest[p];
+				via[n] = p;
+			}
+		}
+		longest[n] = best_pred + (t.m_end_ns - t.m_start_ns);
+		if(last == ~node_id(0) || longest[n] > longest[last])
+		{
+			last = n;
+		}
+	}
+
+	std::vector<node_id> path;
+	for(node_id n = last; n != ~node_id(0); n = via[n])
+	{
+		path.push_back(n);
+	}
+	std::reverse(path.begin(), path.end());
+	if(length_ns != nullptr)
+	{
+		*length_ns = last == ~node_id(0) ? 0 : longest[last];
+	}
+	return path;
+}
+
+void dag_executor::worker_main(std::size_t self)
+{
+#if defined(__linux__)
+	if(!m_options.m_worker_cpus.empty())
+	{
+		cpu_set_t set;
+		CPU_ZERO(&set);
+		CPU_SET(m_options.m_worker_cpus[(self - 1) % m_options.m_worker_cpus.size()], &set);
+		pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+	}
+	if(m_options.m_sched_fifo_priority > 0)
+	{
+		sched_param param {};
+		param.sched_priority = m_options.m_sched_fifo_priority;
+		pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+	}
+#endif
+
+	// Not m_generation.load(): on a busy machine this thread may not get here until after the first run(), or even
+	// after the destructor, and would then wait for a generation which never comes.  Nothing bumps m_generation
+	// before finalize() has started us, so it was 0.
+	std::uint32_t generation = 0;
+	while(true)
+	{
+		// Wait for the next block.
+		std::uint32_t spins = 0;
+		while(m_generation.load(std::memory_order_acquire) == generation)
+		{
+			if(++spins < m_options.m_spin_iterations)
+			{
+				grvslib::impl::cpu_relax();
+				continue;
+			}
+#if __cpp_lib_atomic_wait >= 201907L
+			m_num_parked.fetch_add(1, std::memory_order_seq_cst);
+			m_generation.wait(generation, std::memory_order_seq_cst);
+			m_num_parked.fetch_sub(1, std::memory_order_relaxed);
+#else
+			std::this_thread::yield();
+#endif
+		}
+		generation = m_generation.load(std::memory_order_acquire);
+		if(m_stop.load(std::memory_order_acquire))
+		{
+			return;
+		}
+		work(self);
+	}
+}
+
+void dag_executor::work(std::size_t self)
+{
+	auto& mine = *m_deques[self];
+	std::uint32_t idle_rounds = 0;
+	while(m_remaining.load(std::memory_order_acquire) != 0)
+	{
+		std::uint32_t n = mine.pop();
+		for(std::size_t i = 1; n == grvslib::impl::work_stealing_deque::empty && i < m_deques.size(); ++i)
+		{
+			n = m_deques[(self + i) % m_deques.size()]->steal();
+		}
+		if(n == grvslib::impl::work_stealing_deque::empty)
+		{
+			if(++idle_rounds < m_options.m_spin_iterations)
+			{
+				grvslib::impl::cpu_relax();
+			}
+			else
+			{
+				// Somebody's running a long node.  Don't burn a core another thread might need.
+				idle_rounds = 0;
+				std::this_thread::yield();
+			}
+			continue;
+		}
+		idle_rounds = 0;
+		execute(n, self);
+	}
+}
+
+void dag_executor::execute(node_id n, std::size_t self)
+{
+	node& nd = m_nodes[n];
+	nd.m_timing.m_start_ns = ns_since_block_start();
+	nd.m_work();
+	nd.m_timing.m_end_ns = ns_since_block_start();
+	nd.m_timing.m_worker = static_cast<std::uint32_t>(self);
+
+	auto& mine = *m_deques[self];
+	for(node_id s : nd.m_successors)
+	{
+		// acq_rel: the worker which takes s to zero has to see everything all of s's predecessors did.
+		if(m_pending[s].m_value.fetch_sub(1, std::memory_order_acq_rel) == 1)
+		{
+			mine.push(s);
+		}
+	}
+	m_remaining.fetch_sub(1, std::memory_order_acq_rel);
+}
+
+std::uint64_t dag_executor::ns_since_block_start() const noexcept
+{
+	return static_cast<std::uint64_t>(steady_now_ns() - m_block_start_ns.load(std::memory_order_relaxed));
+}
@@ -0,0 +1,228 @@
+/*
+ * Copyright 2024 Gary R. Van Sickle (grvs@users.sourceforge.net).
+ *
+ * This file is part of grvslib.
+ *
+ * grvslib is free software: you can redistribute it and/or modify it under the
+ * terms of version 3 of the GNU General Public License as published by the Free
+ * Software Foundation.
+ *
+ * grvslib is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * grvslib.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file A parallel executor for a fixed DAG of tasks, run once per audio block on a fixed set of worker threads.
+ */
+
+#ifndef GRVSLIB_DAG_EXECUTOR_H
+#define GRVSLIB_DAG_EXECUTOR_H
+
+// Std C++
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Ours.
+#include "cache_line.h"
+
+namespace grvslib::impl
+{
+/**
+ * A bounded Chase-Lev work-stealing deque of 32-bit task indices, per Lê, Pop, Cohen and Zappa Nardelli, "Correct and
+ * Efficient Work-Stealing for Weak Memory Models" (PPoPP 2013).  The owner push()es and pop()s at the bottom, any
+ * thread may steal() from the top.  The fences of the paper are folded into seq_cst operations, which costs the same
+ * on x86 and keeps ThreadSanitizer able to follow it.
+ *
+ * Bounded because the executor knows the most tasks that can ever be outstanding: the number of nodes.
+ */
+class work_stealing_deque
+{
+public:
+	static constexpr std::uint32_t empty = ~std::uint32_t(0);
+
+	explicit work_stealing_deque(std::size_t min_capacity);
+
+	/// Owner only.  There must be room; see above.
+	void push(std::uint32_t task) noexcept
+	{
+		const std::int64_t b = m_bottom.load(std::memory_order_relaxed);
+		m_buffer[static_cast<std::size_t>(b) & m_mask].store(task, std::memory_order_relaxed);
+		m_bottom.store(b + 1, std::memory_order_release);
+	}
+
+	/// Owner only.  @return The most recently pushed task, or empty.
+	std::uint32_t pop() noexcept
+	{
+		const std::int64_t b = m_bottom.load(std::memory_order_relaxed) - 1;
+		m_bottom.store(b, std::memory_order_seq_cst);
+		std::int64_t t = m_top.load(std::memory_order_seq_cst);
+		if(t > b)
+		{
+			// Was empty.
+			m_bottom.store(b + 1, std::memory_order_relaxed);
+			return empty;
+		}
+		std::uint32_t task = m_buffer[static_cast<std::size_t>(b) & m_mask].load(std::memory_order_relaxed);
+		if(t == b)
+		{
+			// Last one; race any thieves for it.
+			if(!m_top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+			{
+				task = empty;
+			}
+			m_bottom.store(b + 1, std::memory_order_relaxed);
+		}
+		return task;
+	}
+
+	/// Any thread.  @return The oldest task, or empty if there wasn't one or we lost a race for it.
+	std::uint32_t steal() noexcept
+	{
+		std::int64_t t = m_top.load(std::memory_order_seq_cst);
+		const std::int64_t b = m_bottom.load(std::memory_order_seq_cst);
+		if(t >= b)
+		{
+			return empty;
+		}
+		std::uint32_t task = m_buffer[static_cast<std::size_t>(t) & m_mask].load(std::memory_order_relaxed);
+		if(!m_top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+		{
+			return empty;
+		}
+		return task;
+	}
+
+private:
+	alignas(grvslib::impl::cache_line_size) std::atomic<std::int64_t> m_top {0};
+	alignas(grvslib::impl::cache_line_size) std::atomic<std::int64_t> m_bottom {0};
+	alignas(grvslib::impl::cache_line_size) std::size_t m_mask;
+	std::unique_ptr<std::atomic<std::uint32_t>[]> m_buffer;
+};
+}
+
+/**
+ * Runs a fixed graph of tasks (filters, mixers, sends, ...) in parallel once per block, respecting their
+ * dependencies.
+ *
+ * Build the graph with add_node() and add_edge(), then finalize(), which checks it for cycles and starts the
+ * workers.  After that, each call to run() is one parallel traversal of the graph:
+ *
+ * - Every node has an atomic count of unfinished predecessors.  run() resets them all and queues the source nodes.
+ * - Whichever worker finishes a node decrements its successors' counts, and queues any that hit zero on its own
+ *   work-stealing deque.  Idle workers steal from the others.
+ * - The thread which calls run() works too, and run() returns when every node has run.
+ *
+ * Nothing in run() locks or allocates.  Between blocks the workers spin for a while and then park, like spin_phaser.
+ *
+ * Each node's start and end time in the last block is recorded, so critical_path() can tell you which chain of
+ * nodes bounds the block's latency no matter how many cores you throw at it.
+ */
+class dag_executor
+{
+public:
+	using node_id = std::uint32_t;
+
+	struct options
+	{
+		/// Worker threads in addition to the thread calling run().
+		std::size_t m_num_workers {0};
+		/// If non-empty, worker i is pinned to CPU m_worker_cpus[i % size()].  Linux only.
+		std::vector<int> m_worker_cpus;
+		/// If nonzero, workers run SCHED_FIFO at this priority.  Linux only; silently ignored if not permitted.
+		int m_sched_fifo_priority {0};
+		/// How long an idle worker spins before yielding (within a block) or parking (between blocks).
+		std::uint32_t m_spin_iterations {4000};
+	};
+
+	/// Timing of one node in the most recent run(), in nanoseconds from the start of that run().
+	struct node_timing
+	{
+		std::uint64_t m_start_ns {0};
+		std::uint64_t m_end_ns {0};
+		/// Which worker ran it.  0 is the thread which called run().
+		std::uint32_t m_worker {0};
+	};
+
+	dag_executor();
+	explicit dag_executor(options opts);
+	~dag_executor();
+
+	dag_executor(const dag_executor&) = delete;
+	dag_executor& operator=(const dag_executor&) = delete;
+
+	/// Add a node.  @throws std::logic_error after finalize().
+	node_id add_node(std::function<void()> work, std::string name = {});
+
+	/// Make @p after depend on @p before.  @throws std::logic_error after finalize().
+	void add_edge(node_id before, node_id after);
+
+	/**
+	 * Freeze the graph and start the workers.
+	 * @throws std::logic_error if the graph has a cycle.
+	 */
+	void finalize();
+
+	/// Run every node once, in parallel where the dependencies allow.  Only one thread may call this at a time.
+	void run();
+
+	std::size_t num_nodes() const noexcept { return m_nodes.size(); }
+	const std::string& name(node_id node) const { return m_nodes[node].m_name; }
+	const node_timing& timing(node_id node) const { return m_nodes[node].m_timing; }
+
+	/**
+	 * The longest chain of dependent nodes in the last run(), by their measured durations.
+	 *
+	 * @param length_ns  If not null, receives the sum of the durations along the path.
+	 * @return The nodes on the path, first to last.
+	 */
+	std::vector<node_id> critical_path(std::uint64_t* length_ns = nullptr) const;
+
+private:
+	struct node
+	{
+		std::function<void()> m_work;
+		std::string m_name;
+		std::vector<node_id> m_successors;
+		std::vector<node_id> m_predecessors;
+		std::uint32_t m_num_predecessors {0};
+		node_timing m_timing;
+	};
+
+	struct alignas(grvslib::impl::cache_line_size) pending_count
+	{
+		std::atomic<std::uint32_t> m_value {0};
+	};
+
+	void worker_main(std::size_t self);
+	void work(std::size_t self);
+	void execute(node_id n, std::size_t self);
+	std::uint64_t ns_since_block_start() const noexcept;
+
+	options m_options;
+	std::vector<node> m_nodes;
+	std::vector<node_id> m_sources;
+	std::vector<node_id> m_topological_order;
+	bool m_finalized {false};
+
+	std::unique_ptr<pending_count[]> m_pending;
+	std::vector<std::unique_ptr<grvslib::impl::work_stealing_deque>> m_deques;
+	std::vector<std::thread> m_workers;
+
+	alignas(grvslib::impl::cache_line_size) std::atomic<std::uint32_t> m_remaining {0};
+	alignas(grvslib::impl::cache_line_size) std::atomic<std::uint32_t> m_generation {0};
+	std::atomic<std::uint32_t> m_num_parked {0};
+	std::atomic<bool> m_stop {false};
+	std::atomic<std::int64_t> m_block_start_ns {0};
+};
+
+#endif //GRVSLIB_DAG_EXECUTOR_H
@@ -24,6 +24,10 @@
 #include <atomic>
 #include <mutex>
 
+// Ours.
+#include "metrics.h"
+#include "trace.h"
+
 /**
  * Function template implementing a double-checked lock.
  * A primary use case for this is in the creation of singletons, in their get_instance() function.  It makes the
@@ -67,17 +71,33 @@ DoubleCheckedLock(AtomicTypeWrapper &wrap, MutexType &mutex, CacheFillerType cac
 	if(temp_retval == NullVal)
 	{
 		// First check says we don't have the cached value yet.
+		if constexpr(grvslib::trace::enabled)
+		{
+			grvslib::trace::record("DoubleCheckedLock slow path", grvslib::trace::phase::begin);
+		}
 		std::unique_lock<MutexType> lock(mutex);
+		if constexpr(grvslib::metrics::enabled)
+		{
+			grvslib::metrics::double_checked_lock.m_slow_path_entries.add();
+		}
 		// One more try.
 		temp_retval = wrap.load(std::memory_order_relaxed);
 		if(temp_retval == NullVal)
 		{
 			// Still no cached value.  We'll have to do the heavy lifting.
+			if constexpr(grvslib::metrics::enabled)
+			{
+				grvslib::metrics::double_checked_lock.m_cache_fills.add();
+			}
 			//temp_retval = const_cast<ReturnType>(cache_filler());
 			temp_retval = (std::remove_const_t<ReturnType>)(cache_filler());
 			std::atomic_thread_fence(std::memory_order_release);
 			wrap.store(temp_retval, std::memory_order_relaxed);
 		}
+		if constexpr(grvslib::trace::enabled)
+		{
+			grvslib::trace::record("DoubleCheckedLock slow path", grvslib::trace::phase::end);
+		}
 	}
 
 	return temp_retval;
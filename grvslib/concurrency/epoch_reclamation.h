@@ -0,0 +1,316 @@
+/*
+ * Copyright 2024 Gary R. Van Sickle (grvs@users.sourceforge.net).
+ *
+ * This file is part of grvslib.
+ *
+ * grvslib is free software: you can redistribute it and/or modify it under the
+ * terms of version 3 of the GNU General Public License as published by the Free
+ * Software Foundation.
+ *
+ * grvslib is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * grvslib.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file Epoch-based reclamation (EBR) of objects unlinked from lock-free data structures.
+ */
+
+#ifndef GRVSLIB_EPOCH_RECLAMATION_H
+#define GRVSLIB_EPOCH_RECLAMATION_H
+
+// Std C++
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Ours.
+#include "asymmetric_barrier.h"
+#include "cache_line.h"
+#include "spsc_ring.h"
+
+/**
+ * A domain of epoch-based memory reclamation: readers of a lock-free structure pin() the current epoch while they
+ * hold pointers into it, writers retire() what they unlink, and the reclaimer frees a retired object once every
+ * thread has since left the epoch it was retired in.
+ *
+ * Each thread register_thread()s once, off the RT thread, for a participant.  Then:
+ * - Entering a critical section (participant::pin(), or enter()) is an acquire load of the global epoch and a relaxed
+ *   store announcing it, with only a compiler barrier between it and the reads that follow; the other half of that
+ *   fence is an asymmetric_heavy_barrier() on the reclaimer.  Leaving is one release store.
+ * - retire() pushes onto the thread's own fixed-size limbo list, a spsc_ring, so it doesn't allocate either.
+ * - reclaim() tries to advance the epoch and frees, in a batch, everything in every limbo list that is now safe.
+ *   Only ever call it on a non-RT thread (it makes a system call and runs deleters), or start_reclaimer() to have a
+ *   background thread do so periodically.
+ *
+ * So RT threads can read and retire, and never free.  The catch with EBR is that a thread stalled inside a critical
+ * section stops the epoch, and with it all reclamation, so unreclaimed memory is unbounded.  hazard_pointer_domain
+ * bounds it, for a little more per read.
+ *
+ * An object is freed after the epoch has advanced three times past its retirement: one for the retiring thread's own
+ * possibly-stale epoch, two for the grace period proper.
+ */
+class epoch_domain
+{
+	static constexpr std::uint64_t c_quiescent = ~std::uint64_t(0);
+
+	struct retired
+	{
+		void* m_object;
+		void (*m_deleter)(void*);
+		/// Safe to delete once the global epoch reaches this.
+		std::uint64_t m_free_at_epoch;
+	};
+
+	struct slot
+	{
+		explicit slot(std::size_t limbo_capacity) : m_limbo(limbo_capacity) {}
+
+		/// The epoch this thread is in, or c_quiescent.  Alone on its line, since the reclaimer polls it.
+		alignas(grvslib::impl::cache_line_size) std::atomic<std::uint64_t> m_announced {c_quiescent};
+		std::atomic<bool> m_in_use {false};
+		/// Pushed by the owning thread, popped by the reclaimer.
+		spsc_ring<retired> m_limbo;
+	};
+
+public:
+	class participant;
+
+	/// RAII critical section; see participant::pin().
+	class guard
+	{
+	public:
+		explicit guard(participant& p) noexcept : m_participant(&p) { p.enter(); }
+		guard(const guard&) = delete;
+		guard& operator=(const guard&) = delete;
+		~guard() { m_participant->exit(); }
+
+	private:
+		participant* m_participant;
+	};
+
+	/**
+	 * One thread's membership of the domain.  Move-only, and only to be used by one thread at a time.
+	 */
+	class participant
+	{
+	public:
+		participant(participant&& other) noexcept
+			: m_domain(std::exchange(other.m_domain, nullptr)), m_slot(other.m_slot), m_depth(other.m_depth) {}
+		participant& operator=(participant&&) = delete;
+		participant(const participant&) = delete;
+
+		~participant()
+		{
+			if(m_domain != nullptr)
+			{
+				assert(m_depth == 0 && "participant destroyed inside a critical section");
+				m_slot->m_in_use.store(false, std::memory_order_release);
+			}
+		}
+
+		/// Enter a critical section for the guard's lifetime.  Pointers read inside it stay valid until it ends.
+		[[nodiscard]] guard pin() noexcept { return guard(*this); }
+
+		/// Enter a critical section.  Nests.
+		void enter() noexcept
+		{
+			if(m_depth++ == 0)
+			{
+				const std::uint64_t epoch = m_domain->m_epoch.load(std::memory_order_acquire);
+				m_slot->m_announced.store(epoch, std::memory_order_relaxed);
+				// Order the announcement before the reads it protects.  The reclaimer's heavy barrier does the rest.
+				grvslib::impl::asymmetric_light_barrier();
+			}
+		}
+
+		/// Leave a critical section.
+		void exit() noexcept
+		{
+			assert(m_depth > 0);
+			if(--m_depth == 0)
+			{
+				m_slot->m_announced.store(c_quiescent, std::memory_order_release);
+			}
+		}
+
+		/**
+		 * Hand an object which has been unlinked, and so can't be newly reached by anyone, over for deletion by
+		 * @p deleter once no critical section can still be using it.  Call from inside a critical section.
+		 * Allocation-free, so fine on an RT thread.
+		 *
+		 * @return false if this thread's limbo list is full; the object has not been retired.  Reclaim more often,
+		 *         or give the domain a bigger limbo_capacity.  Don't wait for space inside the critical section:
+		 *         it holds back the very epoch advance that would make some.
+		 */
+		bool retire(void* object, void (*deleter)(void*)) noexcept
+		{
+			assert(m_depth > 0 && "retire() outside a critical section");
+			// Our announcement is at most one behind the global epoch.
+			const std::uint64_t retired_epoch = m_slot->m_announced.load(std::memory_order_relaxed) + 1;
+			return m_slot->m_limbo.try_push(retired{object, deleter, retired_epoch + 2});
+		}
+
+		/// retire() with delete.
+		template<typename T>
+		bool retire(T* object) noexcept
+		{
+			return retire(object, [](void* p){ delete static_cast<T*>(p); });
+		}
+
+	private:
+		friend class epoch_domain;
+		participant(epoch_domain* domain, slot* s) noexcept : m_domain(domain), m_slot(s) {}
+
+		epoch_domain* m_domain;
+		slot* m_slot;
+		/// Critical-section nesting depth.
+		unsigned m_depth {0};
+	};
+
+	/**
+	 * @param max_threads     Maximum number of simultaneously registered threads.
+	 * @param limbo_capacity  Minimum number of retired-but-not-freed objects each thread can have outstanding.
+	 */
+	explicit epoch_domain(std::size_t max_threads = 64, std::size_t limbo_capacity = 1024)
+	{
+		m_slots.reserve(max_threads);
+		for(std::size_t i = 0; i < max_threads; ++i)
+		{
+			m_slots.push_back(std::make_unique<slot>(limbo_capacity));
+		}
+		grvslib::impl::prime_asymmetric_barrier();
+	}
+
+	epoch_domain(const epoch_domain&) = delete;
+	epoch_domain& operator=(const epoch_domain&) = delete;
+
+	/// All participants must be gone.  Frees everything still in limbo.
+	~epoch_domain()
+	{
+		stop_reclaimer();
+		for(auto& s : m_slots)
+		{
+			while(retired* r = s->m_limbo.front())
+			{
+				r->m_deleter(r->m_object);
+				s->m_limbo.pop();
+			}
+		}
+	}
+
+	/**
+	 * Claim a slot for the calling thread.  Lock-free, but do it off the RT thread, at startup.
+	 *
+	 * @throws std::runtime_error if max_threads participants already exist.
+	 */
+	participant register_thread()
+	{
+		grvslib::impl::prime_asymmetric_barrier();
+		for(auto& s : m_slots)
+		{
+			bool expected = false;
+			if(!s->m_in_use.load(std::memory_order_relaxed)
+					&& s->m_in_use.compare_exchange_strong(expected, true, std::memory_order_acquire))
+			{
+				return participant(this, s.get());
+			}
+		}
+		throw std::runtime_error("epoch_domain: too many registered threads");
+	}
+
+	/**
+	 * Try to advance the epoch, then free everything retired long enough ago.  Never call this on an RT thread.
+	 * Calls from several threads serialize.
+	 *
+	 * @return Number of objects freed.
+	 */
+	std::size_t reclaim()
+	{
+		std::lock_guard<std::mutex> lock(m_reclaim_mutex);
+
+		// Make every reader's announcement visible, or our view of the world visible to its reads.
+		grvslib::impl::asymmetric_heavy_barrier();
+
+		std::uint64_t epoch = m_epoch.load(std::memory_order_relaxed);
+		bool everyone_caught_up = true;
+		for(auto& s : m_slots)
+		{
+			const std::uint64_t announced = s->m_announced.load(std::memory_order_acquire);
+			everyone_caught_up &= (announced == c_quiescent || announced == epoch);
+		}
+		if(everyone_caught_up)
+		{
+			m_epoch.store(++epoch, std::memory_order_release);
+		}
+
+		std::size_t num_freed = 0;
+		for(auto& s : m_slots)
+		{
+			// Each limbo list is in retirement order, so stop at the first one that isn't due.
+			for(retired* r = s->m_limbo.front(); r != nullptr && r->m_free_at_epoch <= epoch; r = s->m_limbo.front())
+			{
+				r->m_deleter(r->m_object);
+				s->m_limbo.pop();
+				++num_freed;
+			}
+		}
+		return num_freed;
+	}
+
+	/// Start a background thread calling reclaim() every @p period.
+	void start_reclaimer(std::chrono::milliseconds period)
+	{
+		stop_reclaimer();
+		m_stop_reclaimer = false;
+		m_reclaimer = std::thread([this, period](){
+			std::unique_lock<std::mutex> lock(m_reclaimer_mutex);
+			while(!m_reclaimer_cv.wait_for(lock, period, [this](){ return m_stop_reclaimer; }))
+			{
+				reclaim();
+			}
+		});
+	}
+
+	void stop_reclaimer()
+	{
+		if(m_reclaimer.joinable())
+		{
+			{
+				std::lock_guard<std::mutex> lock(m_reclaimer_mutex);
+				m_stop_reclaimer = true;
+			}
+			m_reclaimer_cv.notify_all();
+			m_reclaimer.join();
+		}
+	}
+
+	/// The current global epoch.
+	std::uint64_t epoch() const noexcept { return m_epoch.load(std::memory_order_relaxed); }
+
+private:
+	/// Read by every enter(), written once per reclaim().
+	alignas(grvslib::impl::cache_line_size) std::atomic<std::uint64_t> m_epoch {0};
+
+	alignas(grvslib::impl::cache_line_size) std::vector<std::unique_ptr<slot>> m_slots;
+	std::mutex m_reclaim_mutex;
+
+	std::thread m_reclaimer;
+	std::mutex m_reclaimer_mutex;
+	std::condition_variable m_reclaimer_cv;
+	bool m_stop_reclaimer {false};
+};
+
+#endif //GRVSLIB_EPOCH_RECLAMATION_H
@@ -0,0 +1,110 @@
+/*
+ * Copyright 2024 Gary R. Van Sickle (grvs@users.sourceforge.net).
+ *
+ * This file is part of grvslib.
+ *
+ * grvslib is free software: you can redistribute it and/or modify it under the
+ * terms of version 3 of the GNU General Public License as published by the Free
+ * Software Foundation.
+ *
+ * grvslib is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * grvslib.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file An atomic_notifying_parameter notification policy which signals an eventfd, for consumers in epoll loops.
+ */
+
+#ifndef GRVSLIB_EVENTFD_NOTIFICATION_H
+#define GRVSLIB_EVENTFD_NOTIFICATION_H
+
+// Std C++
+#include <cerrno>
+#include <cstdint>
+#include <system_error>
+
+// Ours.
+#include "realtime.h"
+
+#if __has_include(<sys/eventfd.h>)
+#include <sys/eventfd.h>
+#include <unistd.h>
+#define GRVSLIB_HAVE_EVENTFD 1
+#endif
+
+#ifdef GRVSLIB_HAVE_EVENTFD
+
+/**
+ * Notification policy for atomic_notifying_parameter which makes an eventfd readable when there's a new value, so a
+ * non-RT consumer can sit in epoll/poll/select instead of polling load_and_clear_if_set() on a timer.
+ *
+ * store_and_set() only write()s the eventfd when it sets the "has been updated" flag from clear, so a burst of
+ * stores costs one syscall.  Stores which find the flag already set just overwrite the payload, as usual.
+ *
+ * The consumer, when the fd polls readable, must acknowledge() first and then call load_and_clear_if_set().  In
+ * the other order, a store between the two could set the flag, notify, and then have that notification swallowed by
+ * the acknowledge().
+ *
+ * This adds nothing to load_and_clear_if_set() except on its lock-busy early return, where it re-notifies so the
+ * consumer comes back for the value.  That's a syscall, so don't use this policy on a parameter whose consumer is RT.
+ */
+class eventfd_notification
+{
+public:
+	static constexpr bool enabled = true;
+
+	/// @throws std::system_error if the eventfd can't be created.
+	eventfd_notification() : m_fd(::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC))
+	{
+		if(m_fd < 0)
+		{
+			throw std::system_error(errno, std::system_category(), "eventfd_notification");
+		}
+	}
+
+	eventfd_notification(const eventfd_notification&) = delete;
+	eventfd_notification& operator=(const eventfd_notification&) = delete;
+
+	~eventfd_notification()
+	{
+		::close(m_fd);
+	}
+
+	/// The fd to wait for readability on.  Owned by this object.
+	int fd() const noexcept { return m_fd; }
+
+	/// Called by store_and_set().
+	void notify() noexcept
+	{
+		const std::uint64_t one = 1;
+		// Can only fail if the counter would overflow, in which case it's readable anyway.
+		[[maybe_unused]] auto result = ::write(m_fd, &one, sizeof(one));
+	}
+
+	/**
+	 * Reset the fd to not-readable.  Call this before load_and_clear_if_set(); see above.
+	 * @return The number of notifications since the last call, or 0 if there weren't any.
+	 */
+	std::uint64_t acknowledge() noexcept
+	{
+		std::uint64_t count = 0;
+		return ::read(m_fd, &count, sizeof(count)) == sizeof(count) ? count : 0;
+	}
+
+private:
+	int m_fd;
+};
+
+#if __cpp_lib_atomic_flag_test >= 201907L
+/// An atomic_notifying_parameter whose consumer can wait on notification().fd().
+template<typename PayloadType, typename MemoryOrderPolicy = memory_order_policy_acq_rel>
+using eventfd_notifying_parameter = atomic_notifying_parameter<PayloadType, MemoryOrderPolicy, eventfd_notification>;
+#endif
+
+#endif // GRVSLIB_HAVE_EVENTFD
+
+#endif //GRVSLIB_EVENTFD_NOTIFICATION_H
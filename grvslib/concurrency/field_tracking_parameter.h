@@ -0,0 +1,377 @@
+/*
+ * Copyright 2024 Gary R. Van Sickle (grvs@users.sourceforge.net).
+ *
+ * This file is part of grvslib.
+ *
+ * grvslib is free software: you can redistribute it and/or modify it under the
+ * terms of version 3 of the GNU General Public License as published by the Free
+ * Software Foundation.
+ *
+ * grvslib is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * grvslib.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file An atomic_notifying_parameter for large struct payloads which only copies the fields that changed.
+ */
+
+#ifndef GRVSLIB_FIELD_TRACKING_PARAMETER_H
+#define GRVSLIB_FIELD_TRACKING_PARAMETER_H
+
+// Std C++
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+/**
+ * Describe a struct's fields to field_tracking_parameter.  Put this inside the struct, naming it and then listing its
+ * members (at most 32):
+ * @code
+ *     struct eq_settings
+ *     {
+ *         std::array<eq_band, 64> m_bands;
+ *         float m_output_gain;
+ *         GRVSLIB_DESCRIBE_FIELDS(eq_settings, m_bands, m_output_gain)
+ *     };
+ * @endcode
+ * This gives the struct a constexpr tuple of pointers to those members.  Anything else with the tuple protocol
+ * (std::tuple_size<> and std::get<>()), such as std::array or std::tuple, needs no description: each element is a
+ * field.
+ */
+#define GRVSLIB_DESCRIBE_FIELDS(StructType, ...) \
+	static constexpr auto grvslib_field_pointers() noexcept \
+	{ \
+		return std::make_tuple(GRVSLIB_IMPL_EXPAND(GRVSLIB_IMPL_FIELD_POINTERS(StructType, __VA_ARGS__))); \
+	}
+
+/// @cond
+// &T::f for each field f.  The extra expansions keep MSVC's traditional preprocessor splitting __VA_ARGS__.
+#define GRVSLIB_IMPL_EXPAND(x) x
+#define GRVSLIB_IMPL_FIELD_POINTERS(T, ...) \
+	GRVSLIB_IMPL_EXPAND(GRVSLIB_IMPL_SELECT_FIELD_POINTERS(__VA_ARGS__, \
+		GRVSLIB_IMPL_FIELD_POINTER_32, GRVSLIB_IMPL_FIELD_POINTER_31, GRVSLIB_IMPL_FIELD_POINTER_30, \
+		GRVSLIB_IMPL_FIELD_POINTER_29, GRVSLIB_IMPL_FIELD_POINTER_28, GRVSLIB_IMPL_FIELD_POINTER_27, \
+		GRVSLIB_IMPL_FIELD_POINTER_26, GRVSLIB_IMPL_FIELD_POINTER_25, GRVSLIB_IMPL_FIELD_POINTER_24, \
+		GRVSLIB_IMPL_FIELD_POINTER_23, GRVSLIB_IMPL_FIELD_POINTER_22, GRVSLIB_IMPL_FIELD_POINTER_21, \
+		GRVSLIB_IMPL_FIELD_POINTER_20, GRVSLIB_IMPL_FIELD_POINTER_19, GRVSLIB_IMPL_FIELD_POINTER_18, \
+		GRVSLIB_IMPL_FIELD_POINTER_17, GRVSLIB_IMPL_FIELD_POINTER_16, GRVSLIB_IMPL_FIELD_POINTER_15, \
+		GRVSLIB_IMPL_FIELD_POINTER_14, GRVSLIB_IMPL_FIELD_POINTER_13, GRVSLIB_IMPL_FIELD_POINTER_12, \
+		GRVSLIB_IMPL_FIELD_POINTER_11, GRVSLIB_IMPL_FIELD_POINTER_10, GRVSLIB_IMPL_FIELD_POINTER_9, \
+		GRVSLIB_IMPL_FIELD_POINTER_8, GRVSLIB_IMPL_FIELD_POINTER_7, GRVSLIB_IMPL_FIELD_POINTER_6, \
+		GRVSLIB_IMPL_FIELD_POINTER_5, GRVSLIB_IMPL_FIELD_POINTER_4, GRVSLIB_IMPL_FIELD_POINTER_3, \
+		GRVSLIB_IMPL_FIELD_POINTER_2, GRVSLIB_IMPL_FIELD_POINTER_1)(T, __VA_ARGS__))
+#define GRVSLIB_IMPL_SELECT_FIELD_POINTERS(_1, _2, _3, _4, _5, _6, _7, _8, _9, _10, _11, _12, _13, _14, _15, _16, \
+		_17, _18, _19, _20, _21, _22, _23, _24, _25, _26, _27, _28, _29, _30, _31, _32, NAME, ...) NAME
+#define GRVSLIB_IMPL_FIELD_POINTER_1(T, f) &T::f
+#define GRVSLIB_IMPL_FIELD_POINTER_2(T, f, ...) &T::f, GRVSLIB_IMPL_EXPAND(GRVSLIB_IMPL_FIELD_POINTER_1(T, __VA_ARGS__))
+#define GRVSLIB_IMPL_FIELD_POINTER_3(T, f, ...) &T::f, GRVSLIB_IMPL_EXPAND(GRVSLIB_IMPL_FIELD_POINTER_2(T, __VA_ARGS__))
+#define GRVSLIB_IMPL_FIELD_POINTER_4(T, f, ...) &T::f, GRVSLIB_IMPL_EXPAND(GRVSLIB_IMPL_FIELD_POINTER_3(T, __VA_ARGS__))
+#define GRVSLIB_IMPL_FIELD_POINTER_5(T, f, ...) &T::f, GRVSLIB_IMPL_EXPAND(GRVSLIB_IMPL_FIELD_POINTER_4(T, __VA_ARGS__))
+#define GRVSLIB_IMPL_FIELD_POINTER_6(T, f, ...) &T::f, GRVSLIB_IMPL_EXPAND(GRVSLIB_IMPL_FIELD_POINTER_5(T, __VA_ARGS__))
+#define GRVSLIB_IMPL_FIELD_POINTER_7(T, f, ...) &T::f, GRVSLIB_IMPL_EXPAND(GRVSLIB_IMPL_FIELD_POINTER_6(T, __VA_ARGS__))
+#define GRVSLIB_IMPL_FIELD_POINTER_8(T, f, ...) &T::f, GRVSLIB_IMPL_EXPAND(GRVSLIB_IMPL_FIELD_POINTER_7(T, __VA_ARGS__))
+#define GRVSLIB_IMPL_FIELD_POINTER_9(T, f, ...) &T::f, GRVSLIB_IMPL_EXPAND(GRVSLIB_IMPL_FIELD_POINTER_8(T, __VA_ARGS__))
+#define GRVSLIB_IMPL_FIELD_POINTER_10(T, f, ...) &T::f, GRVSLIB_IMPL_EXPAND(GRVSLIB_IMPL_FIELD_POINTER_9(T, __VA_ARGS__))
+#define GRVSLIB_IMPL_FIELD_POINTER_11(T, f, ...) &T::f, GRVSLIB_IMPL_EXPAND(GRVSLIB_IMPL_FIELD_POINTER_10(T, __VA_ARGS__))
+#define GRVSLIB_IMPL_FIELD_POINTER_12(T, f, ...) &T::f, GRVSLIB_IMPL_EXPAND(GRVSLIB_IMPL_FIELD_POINTER_11(T, __VA_ARGS__))
+#define GRVSLIB_IMPL_FIELD_POINTER_13(T, f, ...) &T::f, GRVSLIB_IMPL_EXPAND(GRVSLIB_IMPL_FIELD_POINTER_12(T, __VA_ARGS__))
+#define GRVSLIB_IMPL_FIELD_POINTER_14(T, f, ...) &T::f, GRVSLIB_IMPL_EXPAND(GRVSLIB_IMPL_FIELD_POINTER_13(T, __VA_ARGS__))
+#define GRVSLIB_IMPL_FIELD_POINTER_15(T, f, ...) &T::f, GRVSLIB_IMPL_EXPAND(GRVSLIB_IMPL_FIELD_POINTER_14(T, __VA_ARGS__))
+#define GRVSLIB_IMPL_FIELD_POINTER_16(T, f, ...) &T::f, GRVSLIB_IMPL_EXPAND(GRVSLIB_IMPL_FIELD_POINTER_15(T, __VA_ARGS__))
+#define GRVSLIB_IMPL_FIELD_POINTER_17(T, f, ...) &T::f, GRVSLIB_IMPL_EXPAND(GRVSLIB_IMPL_FIELD_POINTER_16(T, __VA_ARGS__))
+#define GRVSLIB_IMPL_FIELD_POINTER_18(T, f, ...) &T::f, GRVSLIB_IMPL_EXPAND(GRVSLIB_IMPL_FIELD_POINTER_17(T, __VA_ARGS__))
+#define GRVSLIB_IMPL_FIELD_POINTER_19(T, f, ...) &T::f, GRVSLIB_IMPL_EXPAND(GRVSLIB_IMPL_FIELD_POINTER_18(T, __VA_ARGS__))
+#define GRVSLIB_IMPL_FIELD_POINTER_20(T, f, ...) &T::f, GRVSLIB_IMPL_EXPAND(GRVSLIB_IMPL_FIELD_POINTER_19(T, __VA_ARGS__))
+#define GRVSLIB_IMPL_FIELD_POINTER_21(T, f, ...) &T::f, GRVSLIB_IMPL_EXPAND(GRVSLIB_IMPL_FIELD_POINTER_20(T, __VA_ARGS__))
+#define GRVSLIB_IMPL_FIELD_POINTER_22(T, f, ...) &T::f, GRVSLIB_IMPL_EXPAND(GRVSLIB_IMPL_FIELD_POINTER_21(T, __VA_ARGS__))
+#define GRVSLIB_IMPL_FIELD_POINTER_23(T, f, ...) &T::f, GRVSLIB_IMPL_EXPAND(GRVSLIB_IMPL_FIELD_POINTER_22(T, __VA_ARGS__))
+#define GRVSLIB_IMPL_FIELD_POINTER_24(T, f, ...) &T::f, GRVSLIB_IMPL_EXPAND(GRVSLIB_IMPL_FIELD_POINTER_23(T, __VA_ARGS__))
+#define GRVSLIB_IMPL_FIELD_POINTER_25(T, f, ...) &T::f, GRVSLIB_IMPL_EXPAND(GRVSLIB_IMPL_FIELD_POINTER_24(T, __VA_ARGS__))
+#define GRVSLIB_IMPL_FIELD_POINTER_26(T, f, ...) &T::f, GRVSLIB_IMPL_EXPAND(GRVSLIB_IMPL_FIELD_POINTER_25(T, __VA_ARGS__))
+#define GRVSLIB_IMPL_FIELD_POINTER_27(T, f, ...) &T::f, GRVSLIB_IMPL_EXPAND(GRVSLIB_IMPL_FIELD_POINTER_26(T, __VA_ARGS__))
+#define GRVSLIB_IMPL_FIELD_POINTER_28(T, f, ...) &T::f, GRVSLIB_IMPL_EXPAND(GRVSLIB_IMPL_FIELD_POINTER_27(T, __VA_ARGS__))
+#define GRVSLIB_IMPL_FIELD_POINTER_29(T, f, ...) &T::f, GRVSLIB_IMPL_EXPAND(GRVSLIB_IMPL_FIELD_POINTER_28(T, __VA_ARGS__))
+#define GRVSLIB_IMPL_FIELD_POINTER_30(T, f, ...) &T::f, GRVSLIB_IMPL_EXPAND(GRVSLIB_IMPL_FIELD_POINTER_29(T, __VA_ARGS__))
+#define GRVSLIB_IMPL_FIELD_POINTER_31(T, f, ...) &T::f, GRVSLIB_IMPL_EXPAND(GRVSLIB_IMPL_FIELD_POINTER_30(T, __VA_ARGS__))
+#define GRVSLIB_IMPL_FIELD_POINTER_32(T, f, ...) &T::f, GRVSLIB_IMPL_EXPAND(GRVSLIB_IMPL_FIELD_POINTER_31(T, __VA_ARGS__))
+/// @endcond
+
+namespace grvslib::impl
+{
+template<typename T, typename = void>
+constexpr bool has_described_fields = false;
+template<typename T>
+constexpr bool has_described_fields<T, std::void_t<decltype(T::grvslib_field_pointers())>> = true;
+
+/// True if T's fields are its elements, reached by index: a std::array.
+template<typename T>
+constexpr bool has_indexed_fields = false;
+template<typename E, std::size_t N>
+constexpr bool has_indexed_fields<std::array<E, N>> = true;
+
+/// The tuple of member pointers from T's GRVSLIB_DESCRIBE_FIELDS().
+template<typename T>
+constexpr auto field_pointers = T::grvslib_field_pointers();
+
+template<typename T>
+constexpr std::size_t num_fields_of()
+{
+	if constexpr(has_described_fields<T>)
+	{
+		return std::tuple_size_v<decltype(field_pointers<T>)>;
+	}
+	else
+	{
+		return std::tuple_size_v<T>;
+	}
+}
+
+/// Field @p I of @p t, through its member pointer if it was described, std::get<>() if not.
+template<std::size_t I, typename T>
+constexpr decltype(auto) field(T& t) noexcept
+{
+	using U = std::remove_const_t<T>;
+	if constexpr(has_described_fields<U>)
+	{
+		constexpr auto pointer = std::get<I>(field_pointers<U>);
+		return (t.*pointer);
+	}
+	else
+	{
+		return std::get<I>(t);
+	}
+}
+
+template<typename T, std::size_t I>
+void copy_field(T& to, const T& from)
+{
+	field<I>(to) = field<I>(from);
+}
+
+template<typename T, std::size_t... I>
+constexpr auto make_copy_field_table(std::index_sequence<I...>)
+{
+	return std::array<void (*)(T&, const T&), sizeof...(I)>{&copy_field<T, I>...};
+}
+
+/// Field index -> function copying that field, so the consumer can jump straight to each dirty one.
+template<typename T>
+constexpr auto copy_field_table = make_copy_field_table<T>(std::make_index_sequence<num_fields_of<T>()>{});
+
+/**
+ * Whether two field values differ, as cheaply as we can tell.  Trivially-copyable fields are compared bitwise, which
+ * can only err towards "differs" (padding, -0.0f vs 0.0f), and so costs at most a redundant copy.
+ */
+template<typename F>
+bool field_differs(const F& a, const F& b) noexcept
+{
+	if constexpr(std::is_trivially_copyable_v<F>)
+	{
+		return std::memcmp(&a, &b, sizeof(F)) != 0;
+	}
+	else if constexpr(std::is_convertible_v<decltype(std::declval<const F&>() != std::declval<const F&>()), bool>)
+	{
+		return a != b;
+	}
+	else
+	{
+		// Can't tell: assume it did.
+		return true;
+	}
+}
+}
+
+/**
+ * Like atomic_notifying_parameter with a large, non-atomic payload, but with a dirty bit per field, so that
+ * load_and_clear_if_set() copies only the fields which have changed since the consumer last loaded.  A 4 KB set of EQ
+ * bands where one band's gain changed costs one band's copy instead of 4 KB.
+ *
+ * The payload's fields are whatever its GRVSLIB_DESCRIBE_FIELDS() lists, or its tuple elements (so a std::array of
+ * bands tracks each band).  Fields are tracked at that granularity and no finer.  A std::array is walked by index,
+ * so even one with hundreds of elements costs no more to compile than a loop.
+ *
+ * Because only changed fields are copied, the consumer's copy has to persist: pass the same @p reader_payload to
+ * every load_and_clear_if_set().  The first load after construction copies every field, so it doesn't matter what the
+ * consumer's copy starts out as.
+ *
+ * As with atomic_notifying_parameter, producers take a spinlock which the consumer only ever try-locks, so the
+ * consumer never waits: if a producer is mid-store, the load returns false and picks everything up next time.
+ *
+ * @tparam PayloadType  A struct described with GRVSLIB_DESCRIBE_FIELDS(), or a tuple-like type.
+ */
+template<typename PayloadType>
+class field_tracking_parameter
+{
+	static constexpr std::size_t c_num_fields = grvslib::impl::num_fields_of<PayloadType>();
+	static constexpr std::size_t c_num_dirty_words = (c_num_fields + 63) / 64;
+
+public:
+	static constexpr std::size_t num_fields = c_num_fields;
+
+	explicit field_tracking_parameter(const PayloadType& initial = PayloadType{}) : m_payload(initial)
+	{
+		// So the consumer's first load syncs its whole copy.
+		m_dirty.fill(~std::uint64_t(0));
+	}
+
+	field_tracking_parameter(const field_tracking_parameter&) = delete;
+	field_tracking_parameter& operator=(const field_tracking_parameter&) = delete;
+
+	/**
+	 * The consumer's half.  If anything has been stored since the last call, copy the changed fields into
+	 * @p reader_payload.  Lock-free when there's nothing new; never waits.
+	 *
+	 * @return true if anything was copied.
+	 */
+	bool load_and_clear_if_set(PayloadType* reader_payload)
+	{
+		if(!m_has_been_updated.load(std::memory_order_relaxed))
+		{
+			return false;
+		}
+		if(m_is_being_accessed.test_and_set(std::memory_order_acquire))
+		{
+			// A producer has it; try again next time.
+			return false;
+		}
+
+		// Visit only the set bits, so a single changed field among hundreds costs about one field's copy.
+		for(std::size_t w = 0; w < c_num_dirty_words; ++w)
+		{
+			for(std::uint64_t bits = m_dirty[w]; bits != 0; bits &= bits - 1)
+			{
+				const std::size_t i = w * 64 + lowest_set_bit(bits);
+				if(i < c_num_fields)
+				{
+					copy_field_to(*reader_payload, i);
+				}
+			}
+			m_dirty[w] = 0;
+		}
+		m_has_been_updated.store(false, std::memory_order_relaxed);
+
+		m_is_being_accessed.clear(std::memory_order_release);
+#if __cpp_lib_atomic_flag_test >= 201907L
+		// Wake any producer parked in lock() while we held it.
+		m_is_being_accessed.notify_all();
+#endif
+		return true;
+	}
+
+	/**
+	 * Store a whole new payload, marking only the fields which actually differ from the current one as dirty.
+	 * Any thread except the consumer.
+	 */
+	void store_and_set(const PayloadType& new_writer_payload)
+	{
+		lock();
+		if constexpr(grvslib::impl::has_indexed_fields<PayloadType>)
+		{
+			for(std::size_t i = 0; i < c_num_fields; ++i)
+			{
+				store_if_changed(m_payload[i], new_writer_payload[i], i);
+			}
+		}
+		else
+		{
+			store_changed_fields(new_writer_payload, std::make_index_sequence<c_num_fields>{});
+		}
+		unlock_and_set();
+	}
+
+	/**
+	 * Store just field @p I, e.g. store_field<3>(band) for the fourth band of a std::array.  Cheaper than
+	 * store_and_set() when you know what changed.
+	 */
+	template<std::size_t I, typename ValueType>
+	void store_field(ValueType&& value)
+	{
+		static_assert(I < c_num_fields, "field index out of range");
+		lock();
+		grvslib::impl::field<I>(m_payload) = std::forward<ValueType>(value);
+		mark_dirty(I);
+		unlock_and_set();
+	}
+
+private:
+	static std::size_t lowest_set_bit(std::uint64_t bits) noexcept
+	{
+#if defined(__GNUC__) || defined(__clang__)
+		return static_cast<std::size_t>(__builtin_ctzll(bits));
+#else
+		std::size_t n = 0;
+		for(; (bits & 1) == 0; bits >>= 1)
+		{
+			++n;
+		}
+		return n;
+#endif
+	}
+
+	void copy_field_to(PayloadType& reader_payload, std::size_t i) const
+	{
+		if constexpr(grvslib::impl::has_indexed_fields<PayloadType>)
+		{
+			reader_payload[i] = m_payload[i];
+		}
+		else
+		{
+			grvslib::impl::copy_field_table<PayloadType>[i](reader_payload, m_payload);
+		}
+	}
+
+	template<typename F>
+	void store_if_changed(F& to, const F& from, std::size_t i)
+	{
+		if(grvslib::impl::field_differs(to, from))
+		{
+			to = from;
+			mark_dirty(i);
+		}
+	}
+
+	template<std::size_t... I>
+	void store_changed_fields(const PayloadType& from, std::index_sequence<I...>)
+	{
+		(store_if_changed(grvslib::impl::field<I>(m_payload), grvslib::impl::field<I>(from), I), ...);
+	}
+
+	void mark_dirty(std::size_t i) noexcept { m_dirty[i / 64] |= std::uint64_t(1) << (i % 64); }
+
+	void lock() noexcept
+	{
+		while(m_is_being_accessed.test_and_set(std::memory_order_acquire))
+		{
+#if __cpp_lib_atomic_flag_test >= 201907L
+			m_is_being_accessed.wait(true, std::memory_order_relaxed);
+#endif
+		}
+	}
+
+	void unlock_and_set() noexcept
+	{
+		// Set the flag before unlocking, so the consumer can't clear it and the dirty bits, then miss this store.
+		m_has_been_updated.store(true, std::memory_order_relaxed);
+		m_is_being_accessed.clear(std::memory_order_release);
+#if __cpp_lib_atomic_flag_test >= 201907L
+		m_is_being_accessed.notify_all();
+#endif
+	}
+
+	std::atomic<bool> m_has_been_updated {false};
+	std::atomic_flag m_is_being_accessed = ATOMIC_FLAG_INIT;
+	/// Guarded by m_is_being_accessed.
+	std::array<std::uint64_t, c_num_dirty_words> m_dirty {};
+	PayloadType m_payload;
+};
+
+#endif //GRVSLIB_FIELD_TRACKING_PARAMETER_H
@@ -0,0 +1,128 @@
+/*
+ * Copyright 2024 Gary R. Van Sickle (grvs@users.sourceforge.net).
+ *
+ * This file is part of grvslib.
+ *
+ * grvslib is free software: you can redistribute it and/or modify it under the
+ * terms of version 3 of the GNU General Public License as published by the Free
+ * Software Foundation.
+ *
+ * grvslib is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * grvslib.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file Process-shared futex wait/wake, and a small mutex built on them.
+ */
+
+#ifndef GRVSLIB_FUTEX_H
+#define GRVSLIB_FUTEX_H
+
+// Std C++
+#include <atomic>
+#include <climits>
+#include <cstdint>
+#include <thread>
+
+#if defined(__linux__)
+#include <ctime>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#define GRVSLIB_HAVE_FUTEX 1
+#endif
+
+namespace grvslib::impl
+{
+
+static_assert(sizeof(std::atomic<std::uint32_t>) == sizeof(std::uint32_t) && std::atomic<std::uint32_t>::is_always_lock_free,
+			  "futexes need a std::atomic<std::uint32_t> to be a plain 32-bit word");
+
+/**
+ * Block while @p word still holds @p expected, until futex_wake() on the same word, @p timeout_ns nanoseconds pass
+ * (if non-negative), or a spurious wakeup.  Callers must recheck their condition in a loop.
+ *
+ * Unlike std::atomic<>::wait(), this works between processes: @p word may be in shared memory mapped at different
+ * addresses in each.  Where there's no futex, this just yields.
+ */
+inline void futex_wait(std::atomic<std::uint32_t>* word, std::uint32_t expected, std::int64_t timeout_ns = -1) noexcept
+{
+#ifdef GRVSLIB_HAVE_FUTEX
+	timespec timeout {};
+	if(timeout_ns >= 0)
+	{
+		timeout.tv_sec = static_cast<time_t>(timeout_ns / 1'000'000'000);
+		timeout.tv_nsec = static_cast<long>(timeout_ns % 1'000'000'000);
+	}
+	// Not FUTEX_WAIT_PRIVATE, which only matches waiters in the same process.
+	::syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(word), FUTEX_WAIT, expected,
+			  timeout_ns >= 0 ? &timeout : nullptr, nullptr, 0);
+#else
+	(void)word; (void)expected; (void)timeout_ns;
+	std::this_thread::yield();
+#endif
+}
+
+/// Wake up to @p count threads, in any process, blocked in futex_wait() on @p word.
+inline void futex_wake(std::atomic<std::uint32_t>* word, int count = INT_MAX) noexcept
+{
+#ifdef GRVSLIB_HAVE_FUTEX
+	::syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(word), FUTEX_WAKE, count, nullptr, nullptr, 0);
+#else
+	(void)word; (void)count;
+#endif
+}
+
+/**
+ * A mutex which works between processes, when placed in shared memory.  Uncontended lock() and unlock() are one
+ * atomic operation each; only contended ones make a syscall.  This is "Mutex, Take 2" from Drepper's "Futexes Are
+ * Tricky".  The state is 0 when unlocked, 1 when locked, and 2 when locked and somebody may be waiting.
+ *
+ * Not robust: if a process dies holding it, it stays locked.
+ */
+class futex_mutex
+{
+public:
+	void lock() noexcept
+	{
+		std::uint32_t c = 0;
+		if(m_state.compare_exchange_strong(c, 1, std::memory_order_acquire, std::memory_order_relaxed))
+		{
+			return;
+		}
+		if(c != 2)
+		{
+			c = m_state.exchange(2, std::memory_order_acquire);
+		}
+		while(c != 0)
+		{
+			futex_wait(&m_state, 2);
+			c = m_state.exchange(2, std::memory_order_acquire);
+		}
+	}
+
+	bool try_lock() noexcept
+	{
+		std::uint32_t c = 0;
+		return m_state.compare_exchange_strong(c, 1, std::memory_order_acquire, std::memory_order_relaxed);
+	}
+
+	void unlock() noexcept
+	{
+		if(m_state.exchange(0, std::memory_order_release) == 2)
+		{
+			futex_wake(&m_state, 1);
+		}
+	}
+
+private:
+	std::atomic<std::uint32_t> m_state {0};
+};
+
+}
+
+#endif //GRVSLIB_FUTEX_H
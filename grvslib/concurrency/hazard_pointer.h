@@ -0,0 +1,384 @@
+/*
+ * Copyright 2024 Gary R. Van Sickle (grvs@users.sourceforge.net).
+ *
+ * This file is part of grvslib.
+ *
+ * grvslib is free software: you can redistribute it and/or modify it under the
+ * terms of version 3 of the GNU General Public License as published by the Free
+ * Software Foundation.
+ *
+ * grvslib is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * grvslib.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file Hazard-pointer reclamation of objects unlinked from lock-free data structures, with an interface modelled on
+ *       P2530's std::hazard_pointer.
+ */
+
+#ifndef GRVSLIB_HAZARD_POINTER_H
+#define GRVSLIB_HAZARD_POINTER_H
+
+// Std C++
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+// Ours.
+#include "asymmetric_barrier.h"
+#include "cache_line.h"
+
+namespace grvslib::impl
+{
+
+/// The type-erased part of hazard_pointer_obj_base<>, which is what hazard_pointer_domain keeps retired lists of.
+struct hazard_pointer_retired
+{
+	hazard_pointer_retired* m_next_retired {nullptr};
+	/// Deletes the object this is a base of.
+	void (*m_reclaim)(hazard_pointer_retired*) {nullptr};
+	/// What hazard pointers to this object hold, which needn't be the address of this base.
+	const void* m_protected_address {nullptr};
+};
+
+}
+
+class hazard_pointer;
+
+/**
+ * The set of hazard pointers and retired objects which hazard_pointer and hazard_pointer_obj_base work against.
+ * Most code uses the one hazard_pointer_default_domain(), as P2530 does.
+ *
+ * The point of hazard pointers over epoch_domain is that a stalled reader can only hold up the reclamation of what it
+ * has protected, so unreclaimed memory is bounded: at most retire_threshold retired objects plus one per hazard
+ * pointer.  The price is that a reader pays a little more per object read (see hazard_pointer::protect()).
+ *
+ * Retiring is a lock-free push; when the number of retired objects reaches retire_threshold, the retiring thread
+ * scans: it takes the whole retired list, makes every reader's hazard pointers visible with one
+ * asymmetric_heavy_barrier(), and deletes everything nobody holds.  Scans therefore happen on retiring threads, and
+ * make a system call, so retire off the RT thread, or call reclaim() yourself with a threshold that never triggers.
+ */
+class hazard_pointer_domain
+{
+	struct slot
+	{
+		alignas(grvslib::impl::cache_line_size) std::atomic<const void*> m_protected {nullptr};
+		std::atomic<bool> m_in_use {false};
+	};
+
+public:
+	/**
+	 * @param max_hazard_pointers  Maximum number of hazard_pointer objects existing at once.
+	 * @param retire_threshold     Scan when this many objects have been retired; 0 means 2 * max_hazard_pointers.
+	 */
+	explicit hazard_pointer_domain(std::size_t max_hazard_pointers = 256, std::size_t retire_threshold = 0)
+		: m_num_slots(max_hazard_pointers),
+		  m_slots(std::make_unique<slot[]>(max_hazard_pointers)),
+		  m_retire_threshold(retire_threshold != 0 ? retire_threshold : 2 * max_hazard_pointers)
+	{
+		m_scan_hazards.reserve(max_hazard_pointers);
+		grvslib::impl::prime_asymmetric_barrier();
+	}
+
+	hazard_pointer_domain(const hazard_pointer_domain&) = delete;
+	hazard_pointer_domain& operator=(const hazard_pointer_domain&) = delete;
+
+	/// All hazard pointers must be gone.  Deletes everything still retired.
+	~hazard_pointer_domain()
+	{
+		auto* r = m_retired.exchange(nullptr, std::memory_order_acquire);
+		while(r != nullptr)
+		{
+			auto* next = r->m_next_retired;
+			r->m_reclaim(r);
+			r = next;
+		}
+	}
+
+	/**
+	 * Delete every retired object which no hazard pointer protects.  Never call this on an RT thread.
+	 *
+	 * @return Number of objects deleted.
+	 */
+	std::size_t reclaim()
+	{
+		std::lock_guard<std::mutex> lock(m_scan_mutex);
+		return scan();
+	}
+
+	/// Number of objects retired and not yet deleted.
+	std::size_t num_retired() const noexcept { return m_num_retired.load(std::memory_order_relaxed); }
+
+private:
+	friend class hazard_pointer;
+	friend hazard_pointer make_hazard_pointer(hazard_pointer_domain&);
+	template<typename T, typename D>
+	friend class hazard_pointer_obj_base;
+
+	slot* acquire_slot()
+	{
+		for(std::size_t i = 0; i < m_num_slots; ++i)
+		{
+			bool expected = false;
+			if(!m_slots[i].m_in_use.load(std::memory_order_relaxed)
+					&& m_slots[i].m_in_use.compare_exchange_strong(expected, true, std::memory_order_acquire))
+			{
+				return &m_slots[i];
+			}
+		}
+		throw std::runtime_error("hazard_pointer_domain: too many hazard pointers");
+	}
+
+	void release_slot(slot* s) noexcept
+	{
+		s->m_protected.store(nullptr, std::memory_order_release);
+		s->m_in_use.store(false, std::memory_order_release);
+	}
+
+	void push_retired(grvslib::impl::hazard_pointer_retired* r) noexcept
+	{
+		r->m_next_retired = m_retired.load(std::memory_order_relaxed);
+		while(!m_retired.compare_exchange_weak(r->m_next_retired, r, std::memory_order_release,
+				std::memory_order_relaxed))
+		{
+		}
+	}
+
+	void retire(grvslib::impl::hazard_pointer_retired* r)
+	{
+		push_retired(r);
+		if(m_num_retired.fetch_add(1, std::memory_order_relaxed) + 1 >= m_retire_threshold)
+		{
+			// If somebody else is already scanning, they'll probably take ours too; if not, the next retire will.
+			std::unique_lock<std::mutex> lock(m_scan_mutex, std::try_to_lock);
+			if(lock.owns_lock())
+			{
+				scan();
+			}
+		}
+	}
+
+	/// Call with m_scan_mutex held.
+	std::size_t scan()
+	{
+		auto* r = m_retired.exchange(nullptr, std::memory_order_acquire);
+		if(r == nullptr)
+		{
+			return 0;
+		}
+
+		// Every protect() whose hazard we don't see below will now see its source changed, and retry.
+		grvslib::impl::asymmetric_heavy_barrier();
+
+		m_scan_hazards.clear();
+		for(std::size_t i = 0; i < m_num_slots; ++i)
+		{
+			if(const void* p = m_slots[i].m_protected.load(std::memory_order_acquire))
+			{
+				m_scan_hazards.push_back(p);
+			}
+		}
+		std::sort(m_scan_hazards.begin(), m_scan_hazards.end());
+
+		std::size_t num_reclaimed = 0;
+		while(r != nullptr)
+		{
+			auto* next = r->m_next_retired;
+			if(std::binary_search(m_scan_hazards.begin(), m_scan_hazards.end(), r->m_protected_address))
+			{
+				// Still protected; back on the list for the next scan.
+				push_retired(r);
+			}
+			else
+			{
+				r->m_reclaim(r);
+				++num_reclaimed;
+			}
+			r = next;
+		}
+		m_num_retired.fetch_sub(num_reclaimed, std::memory_order_relaxed);
+		return num_reclaimed;
+	}
+
+	const std::size_t m_num_slots;
+	const std::unique_ptr<slot[]> m_slots;
+	const std::size_t m_retire_threshold;
+
+	alignas(grvslib::impl::cache_line_size) std::atomic<grvslib::impl::hazard_pointer_retired*> m_retired {nullptr};
+	std::atomic<std::size_t> m_num_retired {0};
+
+	std::mutex m_scan_mutex;
+	/// Scratch for scan(), reserved up front.  Guarded by m_scan_mutex.
+	std::vector<const void*> m_scan_hazards;
+};
+
+/// The domain hazard pointers and retire() use unless told otherwise.
+inline hazard_pointer_domain& hazard_pointer_default_domain()
+{
+	static hazard_pointer_domain s_domain;
+	return s_domain;
+}
+
+/**
+ * Base class for objects protected by hazard pointers, as in P2530: derive node from
+ * hazard_pointer_obj_base\<node\>, and retire() a node once it has been unlinked.
+ *
+ * @tparam T  The derived class.
+ * @tparam D  Deleter, called with a T* when the object is reclaimed.
+ */
+template<typename T, typename D = std::default_delete<T>>
+class hazard_pointer_obj_base : private grvslib::impl::hazard_pointer_retired
+{
+public:
+	/**
+	 * Hand this object, which has been unlinked so no new protect() can find it, over for deletion with @p d once
+	 * no hazard pointer protects it.  May run a scan; see hazard_pointer_domain.
+	 */
+	void retire(D d = D(), hazard_pointer_domain& domain = hazard_pointer_default_domain())
+	{
+		m_deleter = std::move(d);
+		m_reclaim = &reclaim;
+		m_protected_address = static_cast<const T*>(this);
+		domain.retire(this);
+	}
+
+protected:
+	hazard_pointer_obj_base() = default;
+	// Copies are new objects, never retired.
+	hazard_pointer_obj_base(const hazard_pointer_obj_base&) noexcept : hazard_pointer_retired() {}
+	hazard_pointer_obj_base& operator=(const hazard_pointer_obj_base&) noexcept { return *this; }
+	~hazard_pointer_obj_base() = default;
+
+private:
+	static void reclaim(grvslib::impl::hazard_pointer_retired* r)
+	{
+		auto* self = static_cast<hazard_pointer_obj_base*>(r);
+		D deleter = std::move(self->m_deleter);
+		deleter(static_cast<T*>(self));
+	}
+
+	[[no_unique_address]] D m_deleter {};
+};
+
+/**
+ * One hazard pointer, as in P2530: while it protect()s an object, that object won't be reclaimed.  Obtain with
+ * make_hazard_pointer(), and keep it around (one per reader thread, say): making one searches the domain for a free
+ * slot, while protect() and reset_protection() are cheap.
+ */
+class hazard_pointer
+{
+public:
+	/// An empty hazard pointer, which can't protect anything.
+	hazard_pointer() noexcept = default;
+
+	hazard_pointer(hazard_pointer&& other) noexcept
+		: m_domain(std::exchange(other.m_domain, nullptr)), m_slot(std::exchange(other.m_slot, nullptr)) {}
+
+	hazard_pointer& operator=(hazard_pointer&& other) noexcept
+	{
+		hazard_pointer(std::move(other)).swap(*this);
+		return *this;
+	}
+
+	~hazard_pointer()
+	{
+		if(m_slot != nullptr)
+		{
+			m_domain->release_slot(m_slot);
+		}
+	}
+
+	[[nodiscard]] bool empty() const noexcept { return m_slot == nullptr; }
+
+	/**
+	 * Load @p src and protect what it points to, retrying until the protection is known to have been in place
+	 * before anyone could have retired it.  The cost is two loads of @p src, a relaxed store and a compiler barrier.
+	 *
+	 * @return The protected pointer, valid until the next protect() or reset_protection().
+	 */
+	template<typename T>
+	T* protect(const std::atomic<T*>& src) noexcept
+	{
+		T* p = src.load(std::memory_order_relaxed);
+		while(!try_protect(p, src))
+		{
+		}
+		return p;
+	}
+
+	/**
+	 * Protect @p ptr, which was loaded from @p src, if @p src still holds it.
+	 *
+	 * @return true if @p ptr is now protected.  If not, @p ptr is updated to @p src's current value, unprotected.
+	 */
+	template<typename T>
+	bool try_protect(T*& ptr, const std::atomic<T*>& src) noexcept
+	{
+		T* const expected = ptr;
+		reset_protection(expected);
+		grvslib::impl::asymmetric_light_barrier();
+		ptr = src.load(std::memory_order_acquire);
+		if(ptr != expected)
+		{
+			reset_protection();
+			return false;
+		}
+		return true;
+	}
+
+	/// Protect @p ptr, which the caller must know can't have been retired yet.
+	template<typename T>
+	void reset_protection(const T* ptr) noexcept
+	{
+		m_slot->m_protected.store(ptr, std::memory_order_relaxed);
+	}
+
+	/// Stop protecting anything.
+	void reset_protection(std::nullptr_t = nullptr) noexcept
+	{
+		m_slot->m_protected.store(nullptr, std::memory_order_release);
+	}
+
+	void swap(hazard_pointer& other) noexcept
+	{
+		std::swap(m_domain, other.m_domain);
+		std::swap(m_slot, other.m_slot);
+	}
+
+private:
+	friend hazard_pointer make_hazard_pointer(hazard_pointer_domain&);
+
+	hazard_pointer(hazard_pointer_domain* domain, hazard_pointer_domain::slot* s) noexcept
+		: m_domain(domain), m_slot(s) {}
+
+	hazard_pointer_domain* m_domain {nullptr};
+	hazard_pointer_domain::slot* m_slot {nullptr};
+};
+
+/**
+ * Make a non-empty hazard pointer in @p domain.
+ *
+ * @throws std::runtime_error if the domain has max_hazard_pointers already.
+ */
+inline hazard_pointer make_hazard_pointer(hazard_pointer_domain& domain = hazard_pointer_default_domain())
+{
+	grvslib::impl::prime_asymmetric_barrier();
+	return hazard_pointer(&domain, domain.acquire_slot());
+}
+
+inline void swap(hazard_pointer& a, hazard_pointer& b) noexcept
+{
+	a.swap(b);
+}
+
+#endif //GRVSLIB_HAZARD_POINTER_H
@@ -0,0 +1,148 @@
+/*
+ * Copyright 2024 Gary R. Van Sickle (grvs@users.sourceforge.net).
+ *
+ * This file is part of grvslib.
+ *
+ * grvslib is free software: you can redistribute it and/or modify it under the
+ * terms of version 3 of the GNU General Public License as published by the Free
+ * Software Foundation.
+ *
+ * grvslib is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * grvslib.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file Left-right: wait-free readers of a large, mutable structure, without copy-on-write.
+ */
+
+#ifndef GRVSLIB_LEFT_RIGHT_H
+#define GRVSLIB_LEFT_RIGHT_H
+
+// Std C++
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+// Ours.
+#include "cache_line.h"
+#include "sharded_counter.h"
+
+/**
+ * Ramalhete and Correia's left-right technique, for structures such as routing tables and preset maps which RT threads
+ * read and UI threads modify, and which are too big to copy-on-write (see atomic_snapshot for when they aren't).
+ *
+ * Two instances of T are kept.  Readers always read whichever one the writer isn't modifying, so they never wait for
+ * it: read() is two loads and an atomic increment and decrement of a read indicator, all wait-free where atomic
+ * fetch_add() is (x86; on LL/SC targets it is lock-free).  modify() applies the mutation to the instance readers
+ * aren't on, switches readers over to it, waits for readers still on the old one to leave, and then applies the same
+ * mutation to that one too.  So a mutation must be deterministic: applied to equal instances, it leaves equal
+ * instances.  Writers serialize on a mutex, and wait for readers, so modify() is for non-RT threads only.
+ *
+ * Each read indicator is split into per-thread shards, like basic_sharded_counter, so that readers on different
+ * threads don't contend on one cache line.
+ *
+ * @tparam T          The structure.
+ * @tparam NumShards  Number of read-indicator shards.  Must be a power of two.
+ */
+template<typename T, std::size_t NumShards = 16>
+class left_right
+{
+	static_assert((NumShards & (NumShards - 1)) == 0, "NumShards must be a power of two");
+
+	struct alignas(grvslib::impl::cache_line_size) shard
+	{
+		std::atomic<std::int64_t> m_num_readers {0};
+	};
+
+	struct alignas(grvslib::impl::cache_line_size) instance
+	{
+		T m_value;
+	};
+
+public:
+	/// Construct both instances from @p args.
+	template<typename... Args>
+	explicit left_right(const Args&... args) : m_instances{instance{T(args...)}, instance{T(args...)}} {}
+
+	left_right(const left_right&) = delete;
+	left_right& operator=(const left_right&) = delete;
+
+	/**
+	 * Call @p f with a const T&, and return what it returns.  Wait-free (with the caveat above), never blocks on
+	 * modify(), and fine on an RT thread.  Don't let references into the T escape @p f.
+	 */
+	template<typename F>
+	auto read(F&& f) const
+	{
+		const std::uint32_t version = m_version_index.load(std::memory_order_seq_cst);
+		std::atomic<std::int64_t>& indicator = my_shard(version);
+		indicator.fetch_add(1, std::memory_order_seq_cst);
+
+		struct depart
+		{
+			std::atomic<std::int64_t>& m_indicator;
+			~depart() { m_indicator.fetch_sub(1, std::memory_order_release); }
+		} departure {indicator};
+
+		return std::forward<F>(f)(std::as_const(m_instances[m_left_right.load(std::memory_order_seq_cst)].m_value));
+	}
+
+	/**
+	 * Apply @p f, which takes a T&, to both instances in turn.  @p f must be deterministic, and is called twice.
+	 * Blocks other writers, and waits for readers of the old instance to finish, so keep this off RT threads.
+	 */
+	template<typename F>
+	void modify(F&& f)
+	{
+		std::lock_guard<std::mutex> lock(m_writer_mutex);
+
+		const std::uint32_t readers_side = m_left_right.load(std::memory_order_relaxed);
+		f(m_instances[readers_side ^ 1].m_value);
+		m_left_right.store(readers_side ^ 1, std::memory_order_seq_cst);
+
+		// Readers which arrived before the store above may still be on the old side.  Two rounds of the version
+		// index make sure every one of them has left, however it interleaved with the store.
+		const std::uint32_t old_version = m_version_index.load(std::memory_order_relaxed);
+		wait_for_no_readers(old_version ^ 1);
+		m_version_index.store(old_version ^ 1, std::memory_order_seq_cst);
+		wait_for_no_readers(old_version);
+
+		f(m_instances[readers_side].m_value);
+	}
+
+private:
+	std::atomic<std::int64_t>& my_shard(std::uint32_t version) const noexcept
+	{
+		return m_read_indicators[version][grvslib::impl::this_thread_shard_index() & (NumShards - 1)].m_num_readers;
+	}
+
+	void wait_for_no_readers(std::uint32_t version) const noexcept
+	{
+		for(const auto& s : m_read_indicators[version])
+		{
+			while(s.m_num_readers.load(std::memory_order_seq_cst) != 0)
+			{
+				std::this_thread::yield();
+			}
+		}
+	}
+
+	/// Which instance readers should read.
+	alignas(grvslib::impl::cache_line_size) std::atomic<std::uint32_t> m_left_right {0};
+	/// Which read indicator new readers arrive at.
+	std::atomic<std::uint32_t> m_version_index {0};
+
+	mutable std::array<std::array<shard, NumShards>, 2> m_read_indicators {};
+	std::array<instance, 2> m_instances;
+	std::mutex m_writer_mutex;
+};
+
+#endif //GRVSLIB_LEFT_RIGHT_H
@@ -0,0 +1,68 @@
+/*
+ * Copyright 2024 Gary R. Van Sickle (grvs@users.sourceforge.net).
+ *
+ * This file is part of grvslib.
+ *
+ * grvslib is free software: you can redistribute it and/or modify it under the
+ * terms of version 3 of the GNU General Public License as published by the Free
+ * Software Foundation.
+ *
+ * grvslib is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * grvslib.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file Hot-path metrics for the concurrency primitives.
+ *
+ * These are compiled in only if GRVSLIB_ENABLE_METRICS is defined to nonzero (the CMake option of the same name does
+ * that).  Otherwise grvslib::metrics::enabled is false, and the instrumentation in the primitives compiles away.
+ */
+
+#ifndef GRVSLIB_METRICS_H
+#define GRVSLIB_METRICS_H
+
+// Ours.
+#include "sharded_counter.h"
+
+#ifndef GRVSLIB_ENABLE_METRICS
+#define GRVSLIB_ENABLE_METRICS 0
+#endif
+
+namespace grvslib::metrics
+{
+
+/// True if the primitives are counting.
+constexpr static bool enabled = (GRVSLIB_ENABLE_METRICS != 0);
+
+/// Counters for atomic_notifying_parameter, summed over all instances.
+struct realtime_counters
+{
+	/// Calls to store_and_set().
+	sharded_counter m_updates_stored;
+	/// load_and_clear_if_set() calls which picked up a new value.
+	sharded_counter m_updates_applied;
+	/// load_and_clear_if_set() calls which found a new value but skipped it because a producer held the payload lock.
+	sharded_counter m_reads_skipped_busy;
+	/// Extra test_and_set() iterations store_and_set() spun for the payload lock.
+	sharded_counter m_store_spin_iterations;
+};
+
+/// Counters for DoubleCheckedLock(), summed over all call sites.
+struct double_checked_lock_counters
+{
+	/// Calls which missed on the lock-free check and took the mutex.
+	sharded_counter m_slow_path_entries;
+	/// Calls which ran the cache filler.
+	sharded_counter m_cache_fills;
+};
+
+inline realtime_counters realtime;
+inline double_checked_lock_counters double_checked_lock;
+
+}
+
+#endif //GRVSLIB_METRICS_H
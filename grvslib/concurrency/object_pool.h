@@ -0,0 +1,243 @@
+/*
+ * Copyright 2024 Gary R. Van Sickle (grvs@users.sourceforge.net).
+ *
+ * This file is part of grvslib.
+ *
+ * grvslib is free software: you can redistribute it and/or modify it under the
+ * terms of version 3 of the GNU General Public License as published by the Free
+ * Software Foundation.
+ *
+ * grvslib is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * grvslib.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file A lock-free, fixed-capacity object pool, for getting allocation and deallocation off of real-time threads.
+ */
+
+#ifndef GRVSLIB_OBJECT_POOL_H
+#define GRVSLIB_OBJECT_POOL_H
+
+// Std C++
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+
+// Ours.
+#include "cache_line.h"
+
+#if __has_include(<sys/mman.h>)
+#include <sys/mman.h>
+#define GRVSLIB_HAVE_MLOCK 1
+#endif
+
+/**
+ * A fixed-capacity pool of preconstructed objects, with lock-free acquire() and release().
+ *
+ * The intended use is passing "command" or "message" objects between non-RT and RT threads without anybody calling
+ * new or delete on the RT thread.  All @p capacity objects are default-constructed up front in one contiguous slab,
+ * which can optionally be mlock()'ed so the RT thread never takes a page fault on it.  They are only destroyed when
+ * the pool is.  acquire() hands out a free object (in whatever state its last user left it), release() gives it back.
+ *
+ * Internally this is a Treiber stack of slot indices.  The stack head packs a 32-bit index and a 32-bit tag into one
+ * 64-bit atomic; the tag is bumped on every successful CAS, which is what keeps the classic ABA problem away.
+ * acquire() and release() are a single CAS, and so wait-free, when uncontended; under contention they are lock-free.
+ *
+ * Objects can also be referred to by their index (see index_of() and at()), which fits in an
+ * atomic_notifying_parameter\<std::uint32_t\>.  That's the natural way to hand a large payload to the RT thread
+ * lock-free: fill a pooled object, store_and_set() its index, and have the consumer release() the previous one.
+ * pooled_handoff packages exactly that.
+ *
+ * @tparam T  The pooled type.  Must be default-constructible.
+ */
+template<typename T>
+class lock_free_object_pool
+{
+	static_assert(std::is_default_constructible_v<T>, "lock_free_object_pool requires a default-constructible T");
+
+public:
+	/// Index type used to refer to pooled objects.
+	using index_type = std::uint32_t;
+
+	/// The index value meaning "no object".
+	static constexpr index_type npos = ~index_type(0);
+
+	static constexpr bool is_always_lock_free = std::atomic<std::uint64_t>::is_always_lock_free;
+
+	/**
+	 * Construct a pool holding @p capacity default-constructed objects.  This allocates, so do it off the RT thread.
+	 *
+	 * @param capacity        Number of objects in the pool.
+	 * @param lock_in_memory  If true, try to mlock() the slab.  Check is_memory_locked() to see if that worked; it
+	 *                        commonly fails without CAP_IPC_LOCK or a sufficient RLIMIT_MEMLOCK.
+	 */
+	explicit lock_free_object_pool(std::size_t capacity, bool lock_in_memory = false)
+		: m_capacity(capacity)
+	{
+		if(capacity == 0 || capacity >= npos)
+		{
+			throw std::invalid_argument("lock_free_object_pool capacity out of range");
+		}
+
+		m_slab_bytes = sizeof(T) * capacity;
+		m_slab = static_cast<T*>(::operator new(m_slab_bytes, std::align_val_t{slab_alignment}));
+		m_next = std::make_unique<std::atomic<index_type>[]>(capacity);
+
+		std::size_t num_constructed = 0;
+		try
+		{
+			for(; num_constructed < capacity; ++num_constructed)
+			{
+				::new(static_cast<void*>(m_slab + num_constructed)) T();
+			}
+		}
+		catch(...)
+		{
+			destroy_slab(num_constructed);
+			throw;
+		}
+
+		// Build the initial free list 0 -> 1 -> ... -> capacity-1.
+		for(std::size_t i = 0; i < capacity; ++i)
+		{
+			m_next[i].store(i + 1 < capacity ? index_type(i + 1) : npos, std::memory_order_relaxed);
+		}
+		m_head.store(pack(0, 0), std::memory_order_release);
+
+#ifdef GRVSLIB_HAVE_MLOCK
+		if(lock_in_memory)
+		{
+			m_is_memory_locked = (::mlock(m_slab, m_slab_bytes) == 0);
+		}
+#else
+		(void)lock_in_memory;
+#endif
+	}
+
+	lock_free_object_pool(const lock_free_object_pool&) = delete;
+	lock_free_object_pool& operator=(const lock_free_object_pool&) = delete;
+
+	/// All objects must have been release()'d, or at least not be used again, before the pool is destroyed.
+	~lock_free_object_pool()
+	{
+		destroy_slab(m_capacity);
+	}
+
+	/**
+	 * Take a free object out of the pool.
+	 *
+	 * @return Pointer to the object, or nullptr if the pool is exhausted.
+	 */
+	T* acquire() noexcept
+	{
+		index_type index = acquire_index();
+		return index == npos ? nullptr : m_slab + index;
+	}
+
+	/**
+	 * Take a free object out of the pool, by index.
+	 *
+	 * @return The index of the object, or npos if the pool is exhausted.
+	 */
+	index_type acquire_index() noexcept
+	{
+		std::uint64_t old_head = m_head.load(std::memory_order_acquire);
+		while(unpack_index(old_head) != npos)
+		{
+			// This may read a stale "next" if another thread pops and re-pushes this node under us, but then the
+			// tag will have changed and the CAS will fail.
+			index_type next = m_next[unpack_index(old_head)].load(std::memory_order_relaxed);
+			std::uint64_t new_head = pack(next, unpack_tag(old_head) + 1);
+			if(m_head.compare_exchange_weak(old_head, new_head, std::memory_order_acquire, std::memory_order_acquire))
+			{
+				return unpack_index(old_head);
+			}
+		}
+		return npos;
+	}
+
+	/**
+	 * Return an object obtained from acquire() to the pool.
+	 */
+	void release(T* object) noexcept
+	{
+		release_index(index_of(object));
+	}
+
+	/**
+	 * Return an object obtained from acquire_index() to the pool.
+	 */
+	void release_index(index_type index) noexcept
+	{
+		std::uint64_t old_head = m_head.load(std::memory_order_relaxed);
+		std::uint64_t new_head;
+		do
+		{
+			m_next[index].store(unpack_index(old_head), std::memory_order_relaxed);
+			new_head = pack(index, unpack_tag(old_head) + 1);
+		}
+		while(!m_head.compare_exchange_weak(old_head, new_head, std::memory_order_release, std::memory_order_relaxed));
+	}
+
+	/// Returns the index of pooled @p object.
+	index_type index_of(const T* object) const noexcept { return static_cast<index_type>(object - m_slab); }
+
+	/// Returns the pooled object at @p index.
+	T* at(index_type index) const noexcept { return m_slab + index; }
+
+	/// Returns true if @p object points into this pool.
+	bool owns(const T* object) const noexcept
+	{
+		return object >= m_slab && object < m_slab + m_capacity;
+	}
+
+	std::size_t capacity() const noexcept { return m_capacity; }
+
+	/// True if the constructor was asked to mlock() the slab and succeeded.
+	bool is_memory_locked() const noexcept { return m_is_memory_locked; }
+
+private:
+	static constexpr std::size_t slab_alignment = alignof(T) > grvslib::impl::cache_line_size
+			? alignof(T) : grvslib::impl::cache_line_size;
+
+	static constexpr std::uint64_t pack(index_type index, std::uint32_t tag) noexcept
+	{
+		return (std::uint64_t(tag) << 32) | index;
+	}
+	static constexpr index_type unpack_index(std::uint64_t head) noexcept { return index_type(head); }
+	static constexpr std::uint32_t unpack_tag(std::uint64_t head) noexcept { return std::uint32_t(head >> 32); }
+
+	void destroy_slab(std::size_t num_constructed) noexcept
+	{
+#ifdef GRVSLIB_HAVE_MLOCK
+		if(m_is_memory_locked)
+		{
+			::munlock(m_slab, m_slab_bytes);
+		}
+#endif
+		for(std::size_t i = 0; i < num_constructed; ++i)
+		{
+			m_slab[i].~T();
+		}
+		::operator delete(m_slab, std::align_val_t{slab_alignment});
+	}
+
+	/// The free-list head, {tag, index}.  On its own cache line since every acquire and release CASes it.
+	alignas(grvslib::impl::cache_line_size) std::atomic<std::uint64_t> m_head {pack(npos, 0)};
+
+	alignas(grvslib::impl::cache_line_size) std::size_t m_capacity;
+	std::size_t m_slab_bytes {0};
+	T* m_slab {nullptr};
+	std::unique_ptr<std::atomic<index_type>[]> m_next;
+	bool m_is_memory_locked {false};
+};
+
+#endif //GRVSLIB_OBJECT_POOL_H
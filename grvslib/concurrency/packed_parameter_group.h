@@ -0,0 +1,278 @@
+/*
+ * Copyright 2024 Gary R. Van Sickle (grvs@users.sourceforge.net).
+ *
+ * This file is part of grvslib.
+ *
+ * grvslib is free software: you can redistribute it and/or modify it under the
+ * terms of version 3 of the GNU General Public License as published by the Free
+ * Software Foundation.
+ *
+ * grvslib is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * grvslib.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file Several small parameters (flags, enums, 8-bit values) bit-packed into one or two atomic words.
+ */
+
+#ifndef GRVSLIB_PACKED_PARAMETER_GROUP_H
+#define GRVSLIB_PACKED_PARAMETER_GROUP_H
+
+// Std C++
+#include <array>
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+/**
+ * Describes one field of a packed_parameter_group: a value of type @p T stored in @p Bits bits.
+ *
+ * @tparam T     bool, an integral type, or an enum.  Signed types are sign-extended on the way out.
+ * @tparam Bits  1 to 64.
+ */
+template<typename T, unsigned Bits>
+struct packed_field
+{
+	static_assert(std::is_integral_v<T> || std::is_enum_v<T>, "packed_field needs a bool, integral or enum type");
+	static_assert(Bits >= 1 && Bits <= 64, "packed_field needs 1 to 64 bits");
+	using value_type = T;
+	static constexpr unsigned bits = Bits;
+};
+
+/**
+ * A group of small parameters packed into one or two std::atomic<std::uint64_t>s, instead of one
+ * atomic_notifying_parameter (two flags and a payload, each) per parameter:
+ * @code
+ *     packed_parameter_group<packed_field<bool, 1>, packed_field<filter_type, 2>, packed_field<std::uint8_t, 8>> g;
+ *     g.store<0, 1>(true, filter_type::highpass);   // one CAS
+ *     ...
+ *     if(g.load_if_changed(&snapshot))                 // one load per word
+ *         f = snapshot.get<1>();                        // a shift and a mask
+ * @endcode
+ *
+ * Fields are laid out in declaration order, starting a second word when one won't fit in what's left of the first.
+ * A store() of any number of fields is a single CAS per word it touches, and load_if_changed() is a single acquire
+ * load per word, so changes within a word are atomic.  Changes spanning both words are not: put fields which must
+ * change together next to each other in the first 64 bits.
+ *
+ * There's no separate "updated" flag: the consumer keeps its last snapshot and a change is a word that differs from
+ * it.  Storing the value a field already has is therefore not a change.
+ *
+ * @tparam Fields  packed_field<>s, at most 128 bits in all.
+ */
+template<typename... Fields>
+class packed_parameter_group
+{
+	static_assert(sizeof...(Fields) > 0, "packed_parameter_group needs at least one field");
+
+	static constexpr std::size_t c_num_fields = sizeof...(Fields);
+
+	struct layout
+	{
+		std::array<unsigned, c_num_fields> m_word {};
+		std::array<unsigned, c_num_fields> m_shift {};
+		std::size_t m_num_words {1};
+	};
+
+	static constexpr layout make_layout()
+	{
+		constexpr std::array<unsigned, c_num_fields> bits {Fields::bits...};
+		layout l {};
+		unsigned word = 0, position = 0;
+		for(std::size_t i = 0; i < c_num_fields; ++i)
+		{
+			if(position + bits[i] > 64)
+			{
+				++word;
+				position = 0;
+			}
+			l.m_word[i] = word;
+			l.m_shift[i] = position;
+			position += bits[i];
+		}
+		l.m_num_words = word + 1;
+		return l;
+	}
+
+	static constexpr layout c_layout = make_layout();
+	static_assert(c_layout.m_num_words <= 2, "packed_parameter_group fields must fit in two 64-bit words");
+	static constexpr std::size_t c_num_words = c_layout.m_num_words;
+
+	template<std::size_t I>
+	using field = std::tuple_element_t<I, std::tuple<Fields...>>;
+
+	template<std::size_t I>
+	static constexpr std::uint64_t field_mask() noexcept
+	{
+		return field<I>::bits == 64 ? ~std::uint64_t(0) : (std::uint64_t(1) << field<I>::bits) - 1;
+	}
+
+public:
+	template<std::size_t I>
+	using field_type = typename field<I>::value_type;
+
+	static constexpr std::size_t num_words = c_num_words;
+	static constexpr bool is_always_lock_free = std::atomic<std::uint64_t>::is_always_lock_free;
+
+	/**
+	 * The consumer's copy of the group.  Default-constructed it's all-zero fields, so a consumer starting with one
+	 * sees any non-zero initial values as a change.
+	 */
+	class snapshot
+	{
+	public:
+		template<std::size_t I>
+		field_type<I> get() const noexcept
+		{
+			return decode<I>(m_words[c_layout.m_word[I]]);
+		}
+
+	private:
+		friend class packed_parameter_group;
+		std::array<std::uint64_t, c_num_words> m_words {};
+	};
+
+	/// All fields zero.
+	packed_parameter_group() noexcept = default;
+
+	/// Every field's initial value, in order.
+	explicit packed_parameter_group(typename Fields::value_type... initial) noexcept
+	{
+		store_all(std::make_index_sequence<c_num_fields>{}, initial...);
+	}
+
+	packed_parameter_group(const packed_parameter_group&) = delete;
+	packed_parameter_group& operator=(const packed_parameter_group&) = delete;
+
+	/**
+	 * Store fields @p I... with @p values..., e.g. store<0, 2>(true, 7).  One CAS loop per word touched; lock-free.
+	 * Values are truncated to their fields' widths (and assert()ed not to need it).
+	 */
+	template<std::size_t... I, typename... ValueTypes>
+	void store(ValueTypes... values) noexcept
+	{
+		static_assert(sizeof...(I) == sizeof...(ValueTypes), "store<I...>() needs one value per field index");
+		static_assert(sizeof...(I) > 0, "store<I...>() needs at least one field index");
+
+		std::array<std::uint64_t, c_num_words> masks {}, bits {};
+		((masks[c_layout.m_word[I]] |= field_mask<I>() << c_layout.m_shift[I],
+		  bits[c_layout.m_word[I]] |= encode<I>(static_cast<field_type<I>>(values))), ...);
+
+		for(std::size_t w = 0; w < c_num_words; ++w)
+		{
+			if(masks[w] == 0)
+			{
+				continue;
+			}
+			std::uint64_t expected = m_words[w].load(std::memory_order_relaxed);
+			while(!m_words[w].compare_exchange_weak(expected, (expected & ~masks[w]) | bits[w],
+					std::memory_order_release, std::memory_order_relaxed))
+			{
+			}
+		}
+	}
+
+	/**
+	 * The consumer's pickup: load the group into @p reader_snapshot, and say whether anything changed since it was
+	 * last loaded into.  Wait-free: one acquire load per word.
+	 */
+	bool load_if_changed(snapshot* reader_snapshot) const noexcept
+	{
+		bool changed = false;
+		for(std::size_t w = 0; w < c_num_words; ++w)
+		{
+			const std::uint64_t word = m_words[w].load(std::memory_order_acquire);
+			changed |= (word != reader_snapshot->m_words[w]);
+			reader_snapshot->m_words[w] = word;
+		}
+		return changed;
+	}
+
+	/// Load the whole group.
+	snapshot load() const noexcept
+	{
+		snapshot s;
+		load_if_changed(&s);
+		return s;
+	}
+
+	/// Load one field.
+	template<std::size_t I>
+	field_type<I> load() const noexcept
+	{
+		return decode<I>(m_words[c_layout.m_word[I]].load(std::memory_order_acquire));
+	}
+
+private:
+	/// @p value's bits for field @p I, in place in its word.
+	template<std::size_t I>
+	static std::uint64_t encode(field_type<I> value) noexcept
+	{
+		using T = field_type<I>;
+		std::uint64_t raw;
+		if constexpr(std::is_same_v<T, bool>)
+		{
+			raw = value ? 1 : 0;
+		}
+		else
+		{
+			using integral = typename std::conditional_t<std::is_enum_v<T>, std::underlying_type<T>,
+					std::common_type<T>>::type;
+			raw = static_cast<std::uint64_t>(static_cast<std::make_unsigned_t<integral>>(static_cast<integral>(value)));
+			if constexpr(std::is_signed_v<integral>)
+			{
+				assert((static_cast<std::int64_t>(static_cast<integral>(value)) >> (field<I>::bits - 1)) == 0
+						|| (static_cast<std::int64_t>(static_cast<integral>(value)) >> (field<I>::bits - 1)) == -1);
+			}
+			else
+			{
+				assert((raw & ~field_mask<I>()) == 0 && "value too wide for its packed_field");
+			}
+		}
+		return (raw & field_mask<I>()) << c_layout.m_shift[I];
+	}
+
+	template<std::size_t... I, typename... ValueTypes>
+	void store_all(std::index_sequence<I...>, ValueTypes... values) noexcept
+	{
+		store<I...>(values...);
+	}
+
+	template<std::size_t I>
+	static field_type<I> decode(std::uint64_t word) noexcept
+	{
+		using T = field_type<I>;
+		const std::uint64_t raw = (word >> c_layout.m_shift[I]) & field_mask<I>();
+		if constexpr(std::is_same_v<T, bool>)
+		{
+			return raw != 0;
+		}
+		else
+		{
+			using integral = typename std::conditional_t<std::is_enum_v<T>, std::underlying_type<T>,
+					std::common_type<T>>::type;
+			if constexpr(std::is_signed_v<integral> && field<I>::bits < 64)
+			{
+				// Sign-extend.
+				const std::uint64_t sign = std::uint64_t(1) << (field<I>::bits - 1);
+				return static_cast<T>(static_cast<integral>(static_cast<std::int64_t>((raw ^ sign) - sign)));
+			}
+			else
+			{
+				return static_cast<T>(static_cast<integral>(raw));
+			}
+		}
+	}
+
+	std::array<std::atomic<std::uint64_t>, c_num_words> m_words {};
+};
+
+#endif //GRVSLIB_PACKED_PARAMETER_GROUP_H
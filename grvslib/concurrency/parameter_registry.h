@@ -0,0 +1,293 @@
+/*
+ * Copyright 2024 Gary R. Van Sickle (grvs@users.sourceforge.net).
+ *
+ * This file is part of grvslib.
+ *
+ * grvslib is free software: you can redistribute it and/or modify it under the
+ * terms of version 3 of the GNU General Public License as published by the Free
+ * Software Foundation.
+ *
+ * grvslib is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * grvslib.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file A build-once, then read-only-and-lock-free, lookup table from parameter IDs and names to parameter objects.
+ */
+
+#ifndef GRVSLIB_PARAMETER_REGISTRY_H
+#define GRVSLIB_PARAMETER_REGISTRY_H
+
+// Std C++
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace grvslib::impl
+{
+/// 64-bit FNV-1a.  constexpr so names known at compile time can be hashed at compile time.
+constexpr std::uint64_t fnv1a_64(std::string_view s) noexcept
+{
+	std::uint64_t hash = 14695981039346656037ULL;
+	for(char c : s)
+	{
+		hash ^= static_cast<unsigned char>(c);
+		hash *= 1099511628211ULL;
+	}
+	return hash;
+}
+
+/// The splitmix64 finalizer, to spread out sequential IDs.
+constexpr std::uint64_t mix64(std::uint64_t x) noexcept
+{
+	x ^= x >> 30;
+	x *= 0xbf58476d1ce4e5b9ULL;
+	x ^= x >> 27;
+	x *= 0x94d049bb133111ebULL;
+	x ^= x >> 31;
+	return x;
+}
+}
+
+/**
+ * Hash of a parameter name as used by frozen_parameter_registry.  Use it to precompute the hash of a name once, at
+ * compile time if possible, and then call frozen_parameter_registry::find(name, hash) from the RT thread.
+ */
+constexpr std::uint64_t parameter_name_hash(std::string_view name) noexcept
+{
+	return grvslib::impl::fnv1a_64(name);
+}
+
+/**
+ * An immutable map from parameter IDs and parameter names to parameter objects (e.g. atomic_notifying_parameter
+ * instances), for hosts with too many parameters to look up by scanning, and threads which can't take a lock.
+ *
+ * You build one with a frozen_parameter_registry::builder at startup, then call freeze().  After that, nothing about
+ * the registry changes, so any number of threads can call find() concurrently with no locks, no atomics and no
+ * allocation.  The only requirement is the usual one for sharing any object: the threads have to get at the frozen
+ * registry through something which happens-after its construction (starting the thread, a mutex, a release store of
+ * a pointer to it, etc.).
+ *
+ * Both lookups are open-addressing hash tables with linear probing, sized to a power of two at least twice the number
+ * of entries.  The longest probe sequence is recorded at freeze() time, so even a lookup for a name or ID which isn't
+ * there is bounded.
+ *
+ * The registry does not own the parameter objects.
+ *
+ * @tparam SlotType  The type of the parameter objects being looked up.
+ */
+template<typename SlotType>
+class frozen_parameter_registry
+{
+public:
+	using id_type = std::uint32_t;
+
+	/**
+	 * Collects the entries for a frozen_parameter_registry.  Not thread-safe, and allocates; use it at startup.
+	 */
+	class builder
+	{
+	public:
+		/**
+		 * Add a parameter.
+		 *
+		 * @throws std::invalid_argument if @p id or @p name has already been added, or @p slot is null.
+		 */
+		builder& add(id_type id, std::string_view name, SlotType* slot)
+		{
+			if(slot == nullptr)
+			{
+				throw std::invalid_argument("frozen_parameter_registry: null slot");
+			}
+			for(const auto& e : m_pending)
+			{
+				if(e.m_id == id)
+				{
+					throw std::invalid_argument("frozen_parameter_registry: duplicate parameter ID");
+				}
+				if(e.m_name == name)
+				{
+					throw std::invalid_argument("frozen_parameter_registry: duplicate parameter name");
+				}
+			}
+			m_pending.push_back({id, std::string(name), slot});
+			return *this;
+		}
+
+		/// Build the lookup tables.  The builder is left empty.
+		frozen_parameter_registry freeze()
+		{
+			frozen_parameter_registry retval(std::move(m_pending));
+			m_pending.clear();
+			return retval;
+		}
+
+	private:
+		friend class frozen_parameter_registry;
+
+		struct pending_entry
+		{
+			id_type m_id;
+			std::string m_name;
+			SlotType* m_slot;
+		};
+
+		std::vector<pending_entry> m_pending;
+	};
+
+	frozen_parameter_registry() = default;
+
+	/// Look up a parameter by ID.  Returns nullptr if there is no such parameter.
+	SlotType* find(id_type id) const noexcept
+	{
+		if(m_entries.empty())
+		{
+			return nullptr;
+		}
+		std::size_t pos = grvslib::impl::mix64(id) & m_mask;
+		for(std::size_t probe = 0; probe <= m_max_id_probe; ++probe, pos = (pos + 1) & m_mask)
+		{
+			std::uint32_t index = m_id_table[pos];
+			if(index == c_empty)
+			{
+				return nullptr;
+			}
+			if(m_entries[index].m_id == id)
+			{
+				return m_entries[index].m_slot;
+			}
+		}
+		return nullptr;
+	}
+
+	/// Look up a parameter by name.  Returns nullptr if there is no such parameter.
+	SlotType* find(std::string_view name) const noexcept
+	{
+		return find(name, parameter_name_hash(name));
+	}
+
+	/**
+	 * Look up a parameter by name, with its hash already computed by parameter_name_hash().
+	 * Returns nullptr if there is no such parameter.
+	 */
+	SlotType* find(std::string_view name, std::uint64_t name_hash) const noexcept
+	{
+		if(m_entries.empty())
+		{
+			return nullptr;
+		}
+		std::size_t pos = name_hash & m_mask;
+		for(std::size_t probe = 0; probe <= m_max_name_probe; ++probe, pos = (pos + 1) & m_mask)
+		{
+			std::uint32_t index = m_name_table[pos];
+			if(index == c_empty)
+			{
+				return nullptr;
+			}
+			const entry& e = m_entries[index];
+			if(e.m_name_hash == name_hash && name_of(e) == name)
+			{
+				return e.m_slot;
+			}
+		}
+		return nullptr;
+	}
+
+	/// Number of registered parameters.
+	std::size_t size() const noexcept { return m_entries.size(); }
+
+	/// The longest probe sequence either table needed at freeze() time.  Mostly of interest to tests.
+	std::size_t max_probe_length() const noexcept
+	{
+		return (m_max_id_probe > m_max_name_probe ? m_max_id_probe : m_max_name_probe) + 1;
+	}
+
+	/// Visit every registered parameter, in the order they were added, as f(id, name, slot).
+	template<typename Callable>
+	void for_each(Callable&& f) const
+	{
+		for(const entry& e : m_entries)
+		{
+			f(e.m_id, name_of(e), e.m_slot);
+		}
+	}
+
+private:
+	static constexpr std::uint32_t c_empty = ~std::uint32_t(0);
+
+	struct entry
+	{
+		std::uint64_t m_name_hash;
+		id_type m_id;
+		std::uint32_t m_name_offset;
+		std::uint32_t m_name_length;
+		SlotType* m_slot;
+	};
+
+	explicit frozen_parameter_registry(std::vector<typename builder::pending_entry>&& pending)
+	{
+		if(pending.empty())
+		{
+			return;
+		}
+
+		std::size_t table_size = 2;
+		while(table_size < pending.size() * 2)
+		{
+			table_size *= 2;
+		}
+		m_mask = table_size - 1;
+		m_id_table.assign(table_size, c_empty);
+		m_name_table.assign(table_size, c_empty);
+		m_entries.reserve(pending.size());
+
+		for(auto& p : pending)
+		{
+			entry e {parameter_name_hash(p.m_name), p.m_id, static_cast<std::uint32_t>(m_names.size()),
+				static_cast<std::uint32_t>(p.m_name.size()), p.m_slot};
+			m_names += p.m_name;
+			auto index = static_cast<std::uint32_t>(m_entries.size());
+			m_entries.push_back(e);
+
+			m_max_id_probe = insert(m_id_table, grvslib::impl::mix64(e.m_id) & m_mask, index, m_max_id_probe);
+			m_max_name_probe = insert(m_name_table, e.m_name_hash & m_mask, index, m_max_name_probe);
+		}
+	}
+
+	std::size_t insert(std::vector<std::uint32_t>& table, std::size_t pos, std::uint32_t index,
+					   std::size_t max_probe_so_far) const
+	{
+		std::size_t probe = 0;
+		while(table[pos] != c_empty)
+		{
+			pos = (pos + 1) & m_mask;
+			++probe;
+		}
+		table[pos] = index;
+		return probe > max_probe_so_far ? probe : max_probe_so_far;
+	}
+
+	std::string_view name_of(const entry& e) const noexcept
+	{
+		return std::string_view(m_names).substr(e.m_name_offset, e.m_name_length);
+	}
+
+	std::vector<entry> m_entries;
+	/// All the names, back to back.
+	std::string m_names;
+	std::vector<std::uint32_t> m_id_table;
+	std::vector<std::uint32_t> m_name_table;
+	std::size_t m_mask {0};
+	std::size_t m_max_id_probe {0};
+	std::size_t m_max_name_probe {0};
+};
+
+#endif //GRVSLIB_PARAMETER_REGISTRY_H
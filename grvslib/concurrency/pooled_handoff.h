@@ -0,0 +1,154 @@
+/*
+ * Copyright 2024 Gary R. Van Sickle (grvs@users.sourceforge.net).
+ *
+ * This file is part of grvslib.
+ *
+ * grvslib is free software: you can redistribute it and/or modify it under the
+ * terms of version 3 of the GNU General Public License as published by the Free
+ * Software Foundation.
+ *
+ * grvslib is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * grvslib.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file Zero-copy handoff of large, pooled buffers to a real-time consumer.
+ */
+
+#ifndef GRVSLIB_POOLED_HANDOFF_H
+#define GRVSLIB_POOLED_HANDOFF_H
+
+// Std C++
+#include <atomic>
+#include <cstddef>
+#include <stdexcept>
+
+// Ours.
+#include "cache_line.h"
+#include "object_pool.h"
+
+/**
+ * The move-semantics counterpart of atomic_notifying_parameter, for payloads too big to copy on the RT thread at all,
+ * such as a 16K-sample impulse response.
+ *
+ * Buffers live in a lock_free_object_pool and are handed over by index.  A producer acquire()s a buffer, fills it and
+ * publish()es it.  The consumer's take_if_published() swaps the published buffer in as its current() one and returns
+ * the one it had to the pool.  No payload is ever copied, and everything is lock-free: a producer publishing over a
+ * buffer the consumer hasn't taken yet just returns that one to the pool itself.
+ *
+ * Pooled buffers are reused, in whatever state their last user left them, so a producer has to overwrite all of
+ * one.  Give the constructor a @p prototype to pre-size them (e.g. a std::vector of the right length), so that
+ * filling one never allocates.
+ *
+ * The pool needs a buffer for the consumer's current one, one for the published one, one more for the moment inside
+ * take_if_published() when the consumer holds both of those, and one for each producer concurrently filling one;
+ * acquire() returns nullptr if a producer asks for more.
+ *
+ * @tparam T  The buffer type.  Must be default-constructible and copy-assignable (for @p prototype).
+ */
+template<typename T>
+class pooled_handoff
+{
+	using pool_type = lock_free_object_pool<T>;
+	using index_type = typename pool_type::index_type;
+	static constexpr index_type npos = pool_type::npos;
+
+public:
+	static constexpr bool is_always_lock_free = pool_type::is_always_lock_free
+			&& std::atomic<index_type>::is_always_lock_free;
+
+	/**
+	 * @param capacity   Number of buffers in the pool; at least 3 + the number of concurrent producers.
+	 * @param prototype  Value every buffer starts out as.
+	 * @param lock_in_memory  As for lock_free_object_pool.
+	 */
+	explicit pooled_handoff(std::size_t capacity, const T& prototype = T{}, bool lock_in_memory = false)
+		: m_pool(capacity, lock_in_memory)
+	{
+		if(capacity < 3)
+		{
+			throw std::invalid_argument("pooled_handoff needs a capacity of at least 3");
+		}
+		for(std::size_t i = 0; i < capacity; ++i)
+		{
+			*m_pool.at(static_cast<index_type>(i)) = prototype;
+		}
+	}
+
+	pooled_handoff(const pooled_handoff&) = delete;
+	pooled_handoff& operator=(const pooled_handoff&) = delete;
+
+	/**
+	 * Producer: take a buffer to fill.
+	 *
+	 * @return The buffer, or nullptr if the pool is exhausted.
+	 */
+	T* acquire() noexcept { return m_pool.acquire(); }
+
+	/**
+	 * Producer: give back a buffer from acquire() without publishing it.
+	 */
+	void discard(T* buffer) noexcept { m_pool.release(buffer); }
+
+	/**
+	 * Producer: publish a filled buffer from acquire().  Ownership passes to this object; don't touch @p buffer again.
+	 * Any previously published buffer the consumer hasn't taken yet goes back to the pool unseen.
+	 */
+	void publish(T* buffer) noexcept
+	{
+		// acq_rel: release our writes to the consumer, and acquire any superseded producer's before recycling theirs.
+		const index_type superseded = m_published.exchange(m_pool.index_of(buffer), std::memory_order_acq_rel);
+		if(superseded != npos)
+		{
+			m_pool.release_index(superseded);
+		}
+	}
+
+	/**
+	 * Consumer: if a buffer has been published since the last call, make it current() and return the old current one
+	 * to the pool.  Lock-free, and a single relaxed load when there's nothing new.
+	 *
+	 * @return true if current() changed.
+	 */
+	bool take_if_published() noexcept
+	{
+		if(m_published.load(std::memory_order_relaxed) == npos)
+		{
+			return false;
+		}
+		const index_type taken = m_published.exchange(npos, std::memory_order_acquire);
+		if(taken == npos)
+		{
+			return false;
+		}
+		if(m_current != npos)
+		{
+			m_pool.release_index(m_current);
+		}
+		m_current = taken;
+		return true;
+	}
+
+	/// Consumer: the buffer most recently taken, or nullptr before the first one.
+	const T* current() const noexcept { return m_current == npos ? nullptr : m_pool.at(m_current); }
+
+	/// Consumer: mutable access, e.g. for a convolution's state that lives alongside its impulse response.
+	T* current() noexcept { return m_current == npos ? nullptr : m_pool.at(m_current); }
+
+	std::size_t capacity() const noexcept { return m_pool.capacity(); }
+
+private:
+	pool_type m_pool;
+
+	/// Index of the published, not-yet-taken buffer, or npos.
+	alignas(grvslib::impl::cache_line_size) std::atomic<index_type> m_published {npos};
+
+	/// Consumer-only.
+	alignas(grvslib::impl::cache_line_size) index_type m_current {npos};
+};
+
+#endif //GRVSLIB_POOLED_HANDOFF_H
@@ -0,0 +1,124 @@
+/*
+ * Copyright 2024 Gary R. Van Sickle (grvs@users.sourceforge.net).
+ *
+ * This file is part of grvslib.
+ *
+ * grvslib is free software: you can redistribute it and/or modify it under the
+ * terms of version 3 of the GNU General Public License as published by the Free
+ * Software Foundation.
+ *
+ * grvslib is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * grvslib.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file A mutex with priority inheritance, for locks shared between real-time and non-real-time threads.
+ */
+
+#ifndef GRVSLIB_PRIORITY_INHERITANCE_MUTEX_H
+#define GRVSLIB_PRIORITY_INHERITANCE_MUTEX_H
+
+// Std C++
+#include <mutex>
+#include <system_error>
+
+#if __has_include(<pthread.h>) && !defined(_WIN32)
+#include <pthread.h>
+#include <unistd.h>
+#endif
+
+/**
+ * A Lockable mutex (so usable with std::unique_lock, std::lock_guard, std::scoped_lock, and as DoubleCheckedLock()'s
+ * MutexType) which avoids unbounded priority inversion.
+ *
+ * While a thread holds it, that thread runs at the priority of the highest-priority thread blocked on it.  So when a
+ * low-priority UI thread holds a lock the SCHED_FIFO audio thread needs (e.g. the one in DoubleCheckedLock()'s slow
+ * path), medium-priority threads can't keep the low-priority holder, and thus the audio thread, off the CPU.
+ *
+ * On POSIX systems with _POSIX_THREAD_PRIO_INHERIT this is a pthread mutex with the PTHREAD_PRIO_INHERIT protocol.
+ * Elsewhere (e.g. Windows, which has no priority-inheriting mutex; it relies on random priority boosting instead) it's
+ * a plain std::mutex, and has_priority_inheritance is false.
+ */
+class priority_inheritance_mutex
+{
+public:
+#if defined(_POSIX_THREAD_PRIO_INHERIT) && _POSIX_THREAD_PRIO_INHERIT > 0
+	static constexpr bool has_priority_inheritance = true;
+	using native_handle_type = pthread_mutex_t*;
+
+	/**
+	 * @throws std::system_error if the platform refuses to create a priority-inheriting mutex.
+	 */
+	priority_inheritance_mutex()
+	{
+		pthread_mutexattr_t attr;
+		int err = pthread_mutexattr_init(&attr);
+		if(err == 0)
+		{
+			err = pthread_mutexattr_setprotocol(&attr, PTHREAD_PRIO_INHERIT);
+			if(err == 0)
+			{
+				err = pthread_mutex_init(&m_mutex, &attr);
+			}
+			pthread_mutexattr_destroy(&attr);
+		}
+		if(err != 0)
+		{
+			throw std::system_error(err, std::system_category(), "priority_inheritance_mutex");
+		}
+	}
+
+	~priority_inheritance_mutex()
+	{
+		pthread_mutex_destroy(&m_mutex);
+	}
+
+	priority_inheritance_mutex(const priority_inheritance_mutex&) = delete;
+	priority_inheritance_mutex& operator=(const priority_inheritance_mutex&) = delete;
+
+	void lock()
+	{
+		int err = pthread_mutex_lock(&m_mutex);
+		if(err != 0)
+		{
+			throw std::system_error(err, std::system_category(), "priority_inheritance_mutex::lock");
+		}
+	}
+
+	bool try_lock() noexcept
+	{
+		return pthread_mutex_trylock(&m_mutex) == 0;
+	}
+
+	void unlock() noexcept
+	{
+		pthread_mutex_unlock(&m_mutex);
+	}
+
+	native_handle_type native_handle() noexcept { return &m_mutex; }
+
+private:
+	pthread_mutex_t m_mutex;
+#else
+	static constexpr bool has_priority_inheritance = false;
+	using native_handle_type = std::mutex::native_handle_type;
+
+	priority_inheritance_mutex() = default;
+	priority_inheritance_mutex(const priority_inheritance_mutex&) = delete;
+	priority_inheritance_mutex& operator=(const priority_inheritance_mutex&) = delete;
+
+	void lock() { m_mutex.lock(); }
+	bool try_lock() noexcept { return m_mutex.try_lock(); }
+	void unlock() noexcept { m_mutex.unlock(); }
+	native_handle_type native_handle() { return m_mutex.native_handle(); }
+
+private:
+	std::mutex m_mutex;
+#endif
+};
+
+#endif //GRVSLIB_PRIORITY_INHERITANCE_MUTEX_H
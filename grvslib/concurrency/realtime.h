@@ -22,8 +22,27 @@
 #ifndef GRVSLIB_REALTIME_H
 #define GRVSLIB_REALTIME_H
 
+#include <algorithm>
+#include <array>
 #include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <tuple>
 #include <type_traits>
+#include <utility>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#endif
+
+// Ours.
+#include "cache_line.h"
+#include "metrics.h"
+#include "trace.h"
 
 namespace grvslib::impl
 {
@@ -32,7 +51,377 @@ constexpr static bool is_atomic = false;
 
 template<typename T>
 constexpr static bool is_atomic<std::atomic<T>> = true;
+
+/// Tell the CPU we're in a spin-wait loop.  Saves power, and on SMT cores gives the sibling thread the pipeline.
+inline void cpu_relax() noexcept
+{
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+	_mm_pause();
+#elif defined(__x86_64__) || defined(__i386__)
+	__builtin_ia32_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+	asm volatile("yield" ::: "memory");
+#endif
+}
+}
+
+/**
+ * @name Memory-order policies
+ * Policy types selecting the std::memory_order used for each atomic operation in the primitives of this file.  Each
+ * member names one operation in the algorithms:
+ *
+ * - notify_test:    Consumer's quick check of the "has been updated" flag.
+ * - notify_consume: Consumer's read-modify-write clear of the "has been updated" flag.  This is the operation which
+ *                   synchronizes with the producer's notify_set, so it must be at least acquire.
+ * - notify_clear:   Consumer's plain-store clear of the "has been updated" flag while holding the payload lock.
+ * - notify_set:     Producer's store of the "has been updated" flag.  Must be at least release.
+ * - payload_load:   Consumer's load of an atomic payload.
+ * - payload_store:  Producer's store of an atomic payload.
+ * - lock_acquire:   Taking the payload spinlock of non-atomic payloads.  Must be at least acquire.
+ * - lock_release:   Releasing the payload spinlock of non-atomic payloads.  Must be at least release.
+ */
+///@{
+
+/// The weakest orderings the algorithms are correct with.  This is the default.
+struct memory_order_policy_acq_rel
+{
+	static constexpr std::memory_order notify_test = std::memory_order_relaxed;
+	static constexpr std::memory_order notify_consume = std::memory_order_acquire;
+	static constexpr std::memory_order notify_clear = std::memory_order_relaxed;
+	static constexpr std::memory_order notify_set = std::memory_order_release;
+	static constexpr std::memory_order payload_load = std::memory_order_acquire;
+	static constexpr std::memory_order payload_store = std::memory_order_release;
+	static constexpr std::memory_order lock_acquire = std::memory_order_acquire;
+	static constexpr std::memory_order lock_release = std::memory_order_release;
+};
+
+/// Everything sequentially-consistent.  Slower, but handy for ruling out an ordering bug while debugging.
+struct memory_order_policy_seq_cst
+{
+	static constexpr std::memory_order notify_test = std::memory_order_seq_cst;
+	static constexpr std::memory_order notify_consume = std::memory_order_seq_cst;
+	static constexpr std::memory_order notify_clear = std::memory_order_seq_cst;
+	static constexpr std::memory_order notify_set = std::memory_order_seq_cst;
+	static constexpr std::memory_order payload_load = std::memory_order_seq_cst;
+	static constexpr std::memory_order payload_store = std::memory_order_seq_cst;
+	static constexpr std::memory_order lock_acquire = std::memory_order_seq_cst;
+	static constexpr std::memory_order lock_release = std::memory_order_seq_cst;
+};
+
+///@}
+
+/**
+ * @name Notification policies
+ * How atomic_notifying_parameter tells a consumer which doesn't want to poll that there's a new value.  A policy has
+ * a static constexpr bool @a enabled, and a notify() member which store_and_set() calls whenever it takes the
+ * "has been updated" flag from clear to set, so a burst of stores between two loads costs only one notify().  See
+ * eventfd_notification.h for one which wakes an epoll loop.
+ */
+///@{
+
+/// No notification; consumers poll.  This is the default, and compiles to exactly the polling-only code.
+struct no_notification
+{
+	static constexpr bool enabled = false;
+	void notify() noexcept {}
+};
+
+///@}
+
+/**
+ * @name Merge policies
+ * What atomic_notifying_parameter::store_and_set() does with a new value when the consumer hasn't picked up the last
+ * one yet.  The default, merge_overwrite, replaces it.  The others accumulate it, and load_and_clear_if_set() then
+ * returns the accumulated value and resets the payload to the policy's identity in the same step, so nothing stored
+ * between two loads is lost or counted twice.  That's what you want when the RT thread is the producer, e.g. a peak
+ * meter (merge_max), an event counter (merge_sum) or a set of status bits (merge_bitwise_or).
+ *
+ * Arithmetic payloads are merged with one lock-free atomic read-modify-write: fetch_add() or fetch_or() where the
+ * standard has it, a compare-exchange loop for max and for floating-point sums.  Struct payloads go through the
+ * payload lock as usual, and are merged field by field: std::array, std::pair and std::tuple element-wise, recursively.
+ * For a struct of your own, derive a policy from one of these and give it
+ * @code
+ *     static void merge(your_struct& accumulated, const your_struct& value);
+ *     static void reset(your_struct& accumulated);
+ * @endcode
+ */
+///@{
+
+/// Replace the payload.  This is the default, and compiles to exactly the non-merging code.
+struct merge_overwrite
+{
+	static constexpr bool accumulates = false;
+};
+
+/// Keep the largest value stored since the last load.
+struct merge_max
+{
+	static constexpr bool accumulates = true;
+
+	template<typename T>
+	static constexpr T identity() noexcept { return std::numeric_limits<T>::lowest(); }
+
+	template<typename T>
+	static constexpr T combine(T accumulated, T value) noexcept { return accumulated < value ? value : accumulated; }
+
+	template<typename T>
+	static void fetch_merge(std::atomic<T>& accumulated, T value, std::memory_order order) noexcept
+	{
+		// No std::atomic<>::fetch_max() until C++26.  Don't write if it wouldn't change anything.
+		T current = accumulated.load(std::memory_order_relaxed);
+		while(current < value && !accumulated.compare_exchange_weak(current, value, order, std::memory_order_relaxed))
+		{
+		}
+	}
+};
+
+/// Add up the values stored since the last load.
+struct merge_sum
+{
+	static constexpr bool accumulates = true;
+
+	template<typename T>
+	static constexpr T identity() noexcept { return T{0}; }
+
+	template<typename T>
+	static constexpr T combine(T accumulated, T value) noexcept { return accumulated + value; }
+
+	template<typename T>
+	static void fetch_merge(std::atomic<T>& accumulated, T value, std::memory_order order) noexcept
+	{
+		if constexpr(std::is_integral_v<T>)
+		{
+			accumulated.fetch_add(value, order);
+		}
+		else
+		{
+			T current = accumulated.load(std::memory_order_relaxed);
+			while(!accumulated.compare_exchange_weak(current, current + value, order, std::memory_order_relaxed))
+			{
+			}
+		}
+	}
+};
+
+/// OR together the values stored since the last load.  Integral payloads only.
+struct merge_bitwise_or
+{
+	static constexpr bool accumulates = true;
+
+	template<typename T>
+	static constexpr T identity() noexcept { return T{0}; }
+
+	template<typename T>
+	static constexpr T combine(T accumulated, T value) noexcept
+	{
+		static_assert(std::is_integral_v<T>, "merge_bitwise_or only works on integral payloads and fields");
+		return static_cast<T>(accumulated | value);
+	}
+
+	template<typename T>
+	static void fetch_merge(std::atomic<T>& accumulated, T value, std::memory_order order) noexcept
+	{
+		static_assert(std::is_integral_v<T>, "merge_bitwise_or only works on integral payloads");
+		accumulated.fetch_or(value, order);
+	}
+};
+
+///@}
+
+namespace grvslib::impl
+{
+template<typename T>
+constexpr bool is_std_array = false;
+template<typename T, std::size_t N>
+constexpr bool is_std_array<std::array<T, N>> = true;
+
+template<typename T>
+constexpr bool is_tuple_like = false;
+template<typename... Ts>
+constexpr bool is_tuple_like<std::tuple<Ts...>> = true;
+template<typename T, typename U>
+constexpr bool is_tuple_like<std::pair<T, U>> = true;
+
+template<typename MergePolicy, typename T>
+void merge_fields(T& accumulated, const T& value);
+
+template<typename MergePolicy, typename T, std::size_t... I>
+void merge_tuple_fields(T& accumulated, const T& value, std::index_sequence<I...>)
+{
+	(merge_fields<MergePolicy>(std::get<I>(accumulated), std::get<I>(value)), ...);
+}
+
+/// Merge @p value into @p accumulated field by field, per MergePolicy.  See "Merge policies" above.
+template<typename MergePolicy, typename T>
+void merge_fields(T& accumulated, const T& value)
+{
+	if constexpr(std::is_arithmetic_v<T>)
+	{
+		accumulated = MergePolicy::template combine<T>(accumulated, value);
+	}
+	else if constexpr(is_std_array<T>)
+	{
+		for(std::size_t i = 0; i < accumulated.size(); ++i)
+		{
+			merge_fields<MergePolicy>(accumulated[i], value[i]);
+		}
+	}
+	else if constexpr(is_tuple_like<T>)
+	{
+		merge_tuple_fields<MergePolicy>(accumulated, value, std::make_index_sequence<std::tuple_size_v<T>>{});
+	}
+	else
+	{
+		MergePolicy::merge(accumulated, value);
+	}
+}
+
+/// Set every field of @p accumulated to MergePolicy's identity.
+template<typename MergePolicy, typename T>
+void reset_fields(T& accumulated)
+{
+	if constexpr(std::is_arithmetic_v<T>)
+	{
+		accumulated = MergePolicy::template identity<T>();
+	}
+	else if constexpr(is_std_array<T>)
+	{
+		for(auto& e : accumulated)
+		{
+			reset_fields<MergePolicy>(e);
+		}
+	}
+	else if constexpr(is_tuple_like<T>)
+	{
+		std::apply([](auto&... e){ (reset_fields<MergePolicy>(e), ...); }, accumulated);
+	}
+	else
+	{
+		MergePolicy::reset(accumulated);
+	}
+}
+}
+
+/**
+ * @name Double-width CAS
+ * A lock-free atomic for 9- to 16-byte trivially-copyable payloads, such as a stereo pair of doubles, built on a
+ * 16-byte compare-and-swap (cmpxchg16b on x86-64, CASP or LDXP/STXP on AArch64).  std::atomic<> doesn't give us this:
+ * GCC routes 16-byte atomics through libatomic and reports them not lock-free, even where they are.
+ *
+ * Only available when the compiler has a 16-byte CAS builtin, in which case GRVSLIB_HAVE_DWCAS is defined.  AArch64
+ * has one; on x86-64 it needs -mcx16, which the CMake option GRVSLIB_ENABLE_DWCAS (on by default) detects and adds to
+ * everything using grvslib.  Since it changes atomic_notifying_parameter's layout, every translation unit in a program
+ * has to be built with the same setting.
+ */
+///@{
+#if defined(__SIZEOF_INT128__) && defined(__GCC_HAVE_SYNC_COMPARE_AND_SWAP_16)
+#define GRVSLIB_HAVE_DWCAS 1
+#endif
+
+namespace grvslib::impl
+{
+template<typename T>
+class dwcas_atomic;
+
+#ifdef GRVSLIB_HAVE_DWCAS
+
+using uint128 = unsigned __int128;
+
+/**
+ * If *@p target == @p expected, replace it with @p desired.  Either way, @p expected ends up with the old value.
+ * A full barrier, whatever memory order the caller wanted.
+ */
+inline bool dwcas(uint128* target, uint128& expected, uint128 desired) noexcept
+{
+	const uint128 previous = __sync_val_compare_and_swap(target, expected, desired);
+	const bool swapped = (previous == expected);
+	expected = previous;
+	return swapped;
+}
+
+/**
+ * The subset of std::atomic<T>'s interface atomic_notifying_parameter uses, for trivially-copyable T of at most 16
+ * bytes, lock-free via dwcas().  Every operation is a full barrier, so the memory_order arguments are accepted and
+ * ignored.  A load is a CAS too (of the value with itself), so it needs the cache line exclusively, like a store.
+ */
+template<typename T>
+class dwcas_atomic
+{
+	static_assert(std::is_trivially_copyable_v<T> && std::is_default_constructible_v<T>
+				  && sizeof(T) <= sizeof(uint128) && alignof(T) <= alignof(uint128),
+				  "dwcas_atomic needs a default-constructible, trivially-copyable type of at most 16 bytes");
+
+public:
+	using value_type = T;
+	static constexpr bool is_always_lock_free = true;
+
+	dwcas_atomic() noexcept : dwcas_atomic(T{}) {}
+
+	explicit dwcas_atomic(const T& value) noexcept : m_raw(to_raw(value)) {}
+
+	dwcas_atomic(const dwcas_atomic&) = delete;
+	dwcas_atomic& operator=(const dwcas_atomic&) = delete;
+
+	T load(std::memory_order = std::memory_order_seq_cst) const noexcept
+	{
+		// Guess zero: if right, we "replace" zero with zero; if wrong, the failed CAS hands us the value.
+		uint128 expected = 0;
+		dwcas(&m_raw, expected, 0);
+		return from_raw(expected);
+	}
+
+	void store(const T& value, std::memory_order order = std::memory_order_seq_cst) noexcept
+	{
+		exchange(value, order);
+	}
+
+	T exchange(const T& value, std::memory_order = std::memory_order_seq_cst) noexcept
+	{
+		const uint128 desired = to_raw(value);
+		uint128 expected = 0;
+		while(!dwcas(&m_raw, expected, desired))
+		{
+		}
+		return from_raw(expected);
+	}
+
+private:
+	static uint128 to_raw(const T& value) noexcept
+	{
+		uint128 raw = 0;
+		std::memcpy(&raw, static_cast<const void*>(&value), sizeof(T));
+		return raw;
+	}
+
+	static T from_raw(uint128 raw) noexcept
+	{
+		T value;
+		// Through void* since T may have default member initializers, which -Wclass-memaccess objects to.
+		std::memcpy(static_cast<void*>(&value), &raw, sizeof(T));
+		return value;
+	}
+
+	/// Mutable since even a load writes.
+	alignas(16) mutable uint128 m_raw;
+};
+
+template<typename T>
+constexpr static bool is_atomic<dwcas_atomic<T>> = true;
+
+#endif //GRVSLIB_HAVE_DWCAS
+
+/// True if atomic_notifying_parameter stores a T in a dwcas_atomic<>: too big for a lock-free std::atomic<>, but not
+/// too big for a 16-byte CAS.
+template<typename T, typename MergePolicy>
+constexpr bool use_dwcas_atomic =
+#ifdef GRVSLIB_HAVE_DWCAS
+		!is_atomic<T> && !std::is_arithmetic_v<T> && !MergePolicy::accumulates && std::is_trivially_copyable_v<T>
+		&& std::is_default_constructible_v<T> && sizeof(T) > 8 && sizeof(T) <= sizeof(uint128) && alignof(T) <= alignof(uint128);
+#else
+		false;
+#endif
 }
+///@}
 
 // This class needs the additions to std::atomic_flag introduced in C++20.
 #if __cpp_lib_atomic_flag_test >= 201907L
@@ -53,12 +442,21 @@ constexpr static bool is_atomic<std::atomic<T>> = true;
  * Note that this class is always lock-free if:
  * - PayloadType is a std::is_arithmetic type and std::atomic\<PayloadType\> is always-lock-free.
  * - PayloadType is a std:atomic\<\> type and it is always lock-free.
+ * - PayloadType is a trivially-copyable 9- to 16-byte type, MergePolicy is merge_overwrite, and GRVSLIB_HAVE_DWCAS
+ *   is defined.  It's then held in a grvslib::impl::dwcas_atomic\<\>.
  *
  * Calls to load_and_clear_if_set() are always lock-free when there is not a newly-written value to load.
  *
  * @tparam PayloadType
+ * @tparam MemoryOrderPolicy  One of the memory_order_policy_* types above.  Defaults to the minimal acquire/release
+ *                            orderings; use memory_order_policy_seq_cst when debugging a suspected ordering problem.
+ * @tparam NotificationPolicy  One of the notification policies above.  Only affects store_and_set(), and the
+ *                             lock-busy early return of load_and_clear_if_set().
+ * @tparam MergePolicy  One of the merge policies above.  Defaults to overwriting; the others accumulate stores until
+ *                      the next load, which also resets the payload.
  */
-template<typename PayloadType>
+template<typename PayloadType, typename MemoryOrderPolicy = memory_order_policy_acq_rel,
+		typename NotificationPolicy = no_notification, typename MergePolicy = merge_overwrite>
 class atomic_notifying_parameter
 {
 	template<typename T>
@@ -76,16 +474,52 @@ class atomic_notifying_parameter
 
 	using PayloadStorageType = std::conditional_t<
 			!grvslib::impl::is_atomic<PayloadType> && std::is_arithmetic<PayloadType>::value,
-			std::atomic<PayloadType>, PayloadType>;
+			std::atomic<PayloadType>,
+			std::conditional_t<grvslib::impl::use_dwcas_atomic<PayloadType, MergePolicy>,
+					grvslib::impl::dwcas_atomic<PayloadType>, PayloadType>>;
 	static constexpr bool PayloadStorageType_is_atomic = grvslib::impl::is_atomic<PayloadStorageType>;
 	static constexpr bool PayloadStorageType_is_always_lock_free = type_is_atomic_and_always_lock_free<PayloadStorageType>();
 
+	using mo = MemoryOrderPolicy;
+
+	template<typename T, bool = grvslib::impl::is_atomic<T>>
+	struct value_type_of { using type = T; };
+	template<typename T>
+	struct value_type_of<T, true> { using type = typename T::value_type; };
+	/// What's actually stored, whether or not it's wrapped in a std::atomic<>.
+	using PayloadValueType = typename value_type_of<PayloadStorageType>::type;
+
 public:
 
 	/// If the type of our @a m_payload member (PayloadStorageType) is always lock free, the algorithms of this
 	/// class will be always lock free.
 	static constexpr bool is_always_lock_free = PayloadStorageType_is_always_lock_free;
 
+	/// The memory-order policy this instantiation was built with.
+	using memory_order_policy = MemoryOrderPolicy;
+
+	/// The notification policy this instantiation was built with.
+	using notification_policy = NotificationPolicy;
+
+	/// The merge policy this instantiation was built with.
+	using merge_policy = MergePolicy;
+
+	atomic_notifying_parameter()
+	{
+		if constexpr(MergePolicy::accumulates)
+		{
+			// Accumulate from the identity, not from whatever default construction left there.
+			if constexpr(PayloadStorageType_is_atomic)
+			{
+				m_payload.store(MergePolicy::template identity<PayloadValueType>(), std::memory_order_relaxed);
+			}
+			else
+			{
+				grvslib::impl::reset_fields<MergePolicy>(m_payload);
+			}
+		}
+	}
+
 
 	/**
 	 * Function the consuming thread should call to atomically check for and load a newly-written value.  Clears the
@@ -100,7 +534,8 @@ public:
 	 */
 	bool load_and_clear_if_set(PayloadType *reader_payload)
 	{
-		if(m_has_been_updated.test())
+		// Cheap check first, so the common "nothing new" path is a single plain load.
+		if(m_has_been_updated.load(mo::notify_test))
 		{
 			// The payload has been updated.
 
@@ -109,8 +544,15 @@ public:
 				// Payload is std::atomic<>.
 
 				// Clear the update notification flag.
-				// Note that we do this before the .load() so we don't lose any notifications.
-				m_has_been_updated.clear();
+				// Note that we do this before the .load() so we don't lose any notifications.  This has to be a
+				// read-modify-write: it reads the most recent store_and_set()'s flag store, and the acquire
+				// synchronizes with that store's release, so the .load() below is guaranteed to see that
+				// store_and_set()'s payload or a later one.  A plain store here would need a StoreLoad barrier.
+				if(!m_has_been_updated.exchange(false, mo::notify_consume))
+				{
+					// Somebody else consumed it between the test and here.
+					return false;
+				}
 
 				// Note that we don't care that we have a race here between the clearing of the "has been updated" flag
 				// and reading the payload, because we always only want the value that was writtem last.
@@ -119,7 +561,29 @@ public:
 				// case.
 
 				// Atomically read the value.  This will be lock-free if PayloadStorageType is lock-free.
-				*reader_payload = m_payload.load();
+				// Acquire so that if we see a newer payload than the flag told us about (e.g. an atomic pointer),
+				// whatever that payload refers to is visible too.
+				if constexpr(MergePolicy::accumulates)
+				{
+					// Take everything accumulated so far and restart from the identity, in one step.  A store which
+					// lands between the flag exchange above and here is included now and flagged again, so the next
+					// load just returns the identity.
+					*reader_payload = m_payload.exchange(MergePolicy::template identity<PayloadValueType>(),
+														 mo::payload_load);
+				}
+				else
+				{
+					*reader_payload = m_payload.load(mo::payload_load);
+				}
+
+				if constexpr(grvslib::metrics::enabled)
+				{
+					grvslib::metrics::realtime.m_updates_applied.add();
+				}
+				if constexpr(grvslib::trace::enabled)
+				{
+					grvslib::trace::instant("atomic_notifying_parameter picked up");
+				}
 			}
 			else
 			{
@@ -127,9 +591,23 @@ public:
 
 				// Let's try to read the value.
 
-				if(m_is_being_accessed.test_and_set() == true)
+				if(m_is_being_accessed.test_and_set(mo::lock_acquire) == true)
 				{
 					// It was already locked, skip this read attempt and try again on the next call.
+					if constexpr(grvslib::metrics::enabled)
+					{
+						grvslib::metrics::realtime.m_reads_skipped_busy.add();
+					}
+					if constexpr(grvslib::trace::enabled)
+					{
+						grvslib::trace::instant("atomic_notifying_parameter skipped busy");
+					}
+					if constexpr(NotificationPolicy::enabled)
+					{
+						// The flag stays set, so the producer we collided with won't notify.  Re-arm, or a consumer
+						// which only calls us when notified would never come back for this value.
+						m_notification.notify();
+					}
 					return false;
 				}
 
@@ -137,12 +615,27 @@ public:
 
 				// Copy the payload out.
 				*reader_payload = m_payload;
+				if constexpr(MergePolicy::accumulates)
+				{
+					grvslib::impl::reset_fields<MergePolicy>(m_payload);
+				}
 
 				// Clear the update notification flag.
-				m_has_been_updated.clear();
+				// This can be relaxed: any store_and_set() whose payload copy we did not see can't have
+				// acquired the lock yet, so its flag store is ordered after our unlock below.
+				m_has_been_updated.store(false, mo::notify_clear);
 				// Unblock any threads which may be waiting in store_and_set().
-				m_is_being_accessed.clear();
+				m_is_being_accessed.clear(mo::lock_release);
 				m_is_being_accessed.notify_all();
+
+				if constexpr(grvslib::metrics::enabled)
+				{
+					grvslib::metrics::realtime.m_updates_applied.add();
+				}
+				if constexpr(grvslib::trace::enabled)
+				{
+					grvslib::trace::instant("atomic_notifying_parameter picked up");
+				}
 			}
 
 			// Indicate that we did a data transfer.
@@ -155,51 +648,412 @@ public:
 
 
 	/**
-	 * Function the producing thread(s) should call to store a new parameter value and set the notify flag.
+	 * Function the producing thread(s) should call to store a new parameter value and set the notify flag.  With an
+	 * accumulating MergePolicy, merges it into the payload instead of replacing it.
 	 *
 	 * @param new_writer_payload  The new value to write.
 	 */
 	void store_and_set(const PayloadType& new_writer_payload)
 	{
+		if constexpr(grvslib::trace::enabled)
+		{
+			grvslib::trace::record("atomic_notifying_parameter store_and_set", grvslib::trace::phase::begin);
+		}
+
 		if constexpr(PayloadStorageType_is_atomic)
 		{
-			m_payload.store(new_writer_payload);
+			if constexpr(MergePolicy::accumulates)
+			{
+				MergePolicy::template fetch_merge<PayloadValueType>(m_payload, new_writer_payload, mo::payload_store);
+			}
+			else
+			{
+				m_payload.store(new_writer_payload, mo::payload_store);
+			}
 		}
 		else
 		{
 			// Wait until the payload lock is false.
 			// This is not lock-free.
-			m_is_being_accessed.wait(true);
+			m_is_being_accessed.wait(true, std::memory_order_relaxed);
 
 			// Another thread may sneak in here and re-set m_is_being_accessed to true.
 			// So, we spin to eliminate that race.
-			while(m_is_being_accessed.test_and_set() == true){};
+			if constexpr(grvslib::metrics::enabled)
+			{
+				std::uint64_t num_spins = 0;
+				while(m_is_being_accessed.test_and_set(mo::lock_acquire) == true){ ++num_spins; };
+				if(num_spins != 0)
+				{
+					grvslib::metrics::realtime.m_store_spin_iterations.add(num_spins);
+				}
+			}
+			else
+			{
+				while(m_is_being_accessed.test_and_set(mo::lock_acquire) == true){};
+			}
 
 			// We've got the m_is_being_accessed lock here.
 
-			// Copy the new payload.
-			m_payload = new_writer_payload;
+			// Copy or merge in the new payload.
+			if constexpr(MergePolicy::accumulates)
+			{
+				grvslib::impl::merge_fields<MergePolicy>(m_payload, new_writer_payload);
+			}
+			else
+			{
+				m_payload = new_writer_payload;
+			}
 
 			// Clear the payload lock.
-			m_is_being_accessed.clear();
+			m_is_being_accessed.clear(mo::lock_release);
 			// In general, nobody should be waiting for us, but notify just in case.
 			m_is_being_accessed.notify_all();
 		}
 
 		// Set the update notification flag.
-		m_has_been_updated.test_and_set();
+		// With the acq_rel policy this is a plain release store, i.e. an ordinary mov on x86 rather than the
+		// xchg a seq_cst store or any test_and_set() compiles to.
+		if constexpr(NotificationPolicy::enabled)
+		{
+			// Here we do need the exchange, to notice the clear-to-set transition.  A consumer that clears the flag
+			// after we set it has also loaded our payload, so a store which finds the flag already set needn't notify.
+			if(!m_has_been_updated.exchange(true, mo::notify_set))
+			{
+				m_notification.notify();
+			}
+		}
+		else
+		{
+			m_has_been_updated.store(true, mo::notify_set);
+		}
+
+		if constexpr(grvslib::metrics::enabled)
+		{
+			grvslib::metrics::realtime.m_updates_stored.add();
+		}
+		if constexpr(grvslib::trace::enabled)
+		{
+			grvslib::trace::record("atomic_notifying_parameter store_and_set", grvslib::trace::phase::end);
+		}
 	}
 
+	/// The notification policy object, e.g. to get an eventfd_notification's fd.
+	NotificationPolicy& notification() noexcept { return m_notification; }
+
 private:
 	/**
 	 * The flag which will communicate whether the payload has be updated or not.
-	 * @note The "= ATOMIC_FLAG_INIT" is not needed post-C++20, but we keep it here in the interest of
-	 *       minimal-pain backward compatibility.
+	 * @note This is a std::atomic<bool> rather than a std::atomic_flag because the consumer needs to clear it with
+	 *       an acquiring read-modify-write (exchange()), which std::atomic_flag doesn't provide.
 	 */
-	std::atomic_flag m_has_been_updated = ATOMIC_FLAG_INIT;
+	std::atomic<bool> m_has_been_updated {false};
 	std::atomic_flag m_is_being_accessed = ATOMIC_FLAG_INIT;
 	PayloadStorageType m_payload;
+	/// Takes no space with no_notification.
+	[[no_unique_address]] NotificationPolicy m_notification;
 };
+
+/// An atomic_notifying_parameter which accumulates stores between loads, e.g. accumulating_parameter<float, merge_max>.
+template<typename PayloadType, typename MergePolicy>
+using accumulating_parameter = atomic_notifying_parameter<PayloadType, memory_order_policy_acq_rel, no_notification,
+		MergePolicy>;
 #endif //__cpp_lib_atomic_flag_test >= 201907L
 
+// spin_phaser parks with C++20 std::atomic<>::wait().
+#if __cpp_lib_atomic_wait >= 201907L
+
+/**
+ * A reusable barrier for a fixed set of threads which process something in short, periodic phases, such as the
+ * stages of one audio block spread over several cores.  Each phase, every participant calls arrive_and_wait(), and
+ * none of them returns until all of them have arrived.
+ *
+ * std::barrier is general-purpose, and may park waiting threads in the kernel right away.  With 64-sample blocks at
+ * 96 kHz a phase is well under a millisecond, so a futex wake-up is a large fraction of it.  This one spins first
+ * (for @a spin_iterations iterations of a cpu_relax() loop), and only parks in std::atomic<>::wait() if the phase
+ * still hasn't completed.  The last thread to arrive only makes the wake-up syscall if somebody actually parked.
+ *
+ * It also keeps per-participant statistics on how long each one waited, which is how you find out whether the work
+ * is balanced across threads and whether the spin limit is right.
+ *
+ * @note Spinning assumes each participant has a core to itself, as pinned RT workers do.  If the participants
+ *       outnumber the cores, a spinner burns the time slice the thread it's waiting for needs; pass a
+ *       @a spin_iterations of 0 to always park.
+ */
+class spin_phaser
+{
+public:
+	/// Per-participant wait statistics.  Times are in nanoseconds.
+	struct participant_stats
+	{
+		std::uint64_t m_num_waits {0};
+		/// Number of waits which gave up spinning and parked.
+		std::uint64_t m_num_parks {0};
+		std::uint64_t m_last_wait_ns {0};
+		std::uint64_t m_max_wait_ns {0};
+		std::uint64_t m_total_wait_ns {0};
+	};
+
+	/**
+	 * @param num_participants  Number of threads which will call arrive_and_wait() each phase.
+	 * @param spin_iterations   How long to spin before parking.
+	 */
+	explicit spin_phaser(std::size_t num_participants, std::uint32_t spin_iterations = 4000)
+		: m_num_participants(num_participants), m_spin_iterations(spin_iterations),
+		  m_stats(std::make_unique<padded_stats[]>(num_participants))
+	{
+	}
+
+	spin_phaser(const spin_phaser&) = delete;
+	spin_phaser& operator=(const spin_phaser&) = delete;
+
+	/**
+	 * Arrive at the end of the current phase and wait for everybody else to.
+	 *
+	 * @param participant  This thread's participant number, 0 to num_participants()-1.  Only used for the stats.
+	 * @return The number of the phase which just completed.
+	 */
+	std::uint32_t arrive_and_wait(std::size_t participant) noexcept
+	{
+		const auto start = std::chrono::steady_clock::now();
+		const std::uint32_t phase = m_phase.load(std::memory_order_acquire);
+		bool parked = false;
+
+		if(m_num_arrived.fetch_add(1, std::memory_order_acq_rel) + 1 == m_num_participants)
+		{
+			// Last one in.  Reset for the next phase before releasing everybody, since they may arrive again as soon
+			// as they're released.
+			m_num_arrived.store(0, std::memory_order_relaxed);
+			m_phase.fetch_add(1, std::memory_order_seq_cst);
+			if(m_num_parked.load(std::memory_order_seq_cst) != 0)
+			{
+				m_phase.notify_all();
+			}
+		}
+		else
+		{
+			std::uint32_t spins = 0;
+			while(m_phase.load(std::memory_order_acquire) == phase)
+			{
+				if(++spins < m_spin_iterations)
+				{
+					grvslib::impl::cpu_relax();
+					continue;
+				}
+				// Spun long enough; park.  The seq_cst increment pairs with the seq_cst phase increment and load of
+				// m_num_parked above: either the last arriver sees us, or our wait() sees the new phase.
+				parked = true;
+				m_num_parked.fetch_add(1, std::memory_order_seq_cst);
+				m_phase.wait(phase, std::memory_order_seq_cst);
+				m_num_parked.fetch_sub(1, std::memory_order_relaxed);
+			}
+		}
+
+		record_wait(participant, start, parked);
+		return phase;
+	}
+
+	std::size_t num_participants() const noexcept { return m_num_participants; }
+
+	/// Participant @p participant's statistics.  Approximate if that participant is running.
+	participant_stats stats(std::size_t participant) const noexcept
+	{
+		const auto& s = m_stats[participant];
+		participant_stats retval;
+		retval.m_num_waits = s.m_num_waits.load(std::memory_order_relaxed);
+		retval.m_num_parks = s.m_num_parks.load(std::memory_order_relaxed);
+		retval.m_last_wait_ns = s.m_last_wait_ns.load(std::memory_order_relaxed);
+		retval.m_max_wait_ns = s.m_max_wait_ns.load(std::memory_order_relaxed);
+		retval.m_total_wait_ns = s.m_total_wait_ns.load(std::memory_order_relaxed);
+		return retval;
+	}
+
+	/// Zero all participants' statistics.  Call only while nobody is in arrive_and_wait().
+	void reset_stats() noexcept
+	{
+		for(std::size_t i = 0; i < m_num_participants; ++i)
+		{
+			auto& s = m_stats[i];
+			s.m_num_waits.store(0, std::memory_order_relaxed);
+			s.m_num_parks.store(0, std::memory_order_relaxed);
+			s.m_last_wait_ns.store(0, std::memory_order_relaxed);
+			s.m_max_wait_ns.store(0, std::memory_order_relaxed);
+			s.m_total_wait_ns.store(0, std::memory_order_relaxed);
+		}
+	}
+
+private:
+	/// Each participant's stats on their own cache line.  Only the participant writes them, so no RMWs needed.
+	struct alignas(grvslib::impl::cache_line_size) padded_stats
+	{
+		std::atomic<std::uint64_t> m_num_waits {0};
+		std::atomic<std::uint64_t> m_num_parks {0};
+		std::atomic<std::uint64_t> m_last_wait_ns {0};
+		std::atomic<std::uint64_t> m_max_wait_ns {0};
+		std::atomic<std::uint64_t> m_total_wait_ns {0};
+	};
+
+	void record_wait(std::size_t participant, std::chrono::steady_clock::time_point start, bool parked) noexcept
+	{
+		const auto ns = static_cast<std::uint64_t>(
+				std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+		auto& s = m_stats[participant];
+		s.m_num_waits.store(s.m_num_waits.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+		if(parked)
+		{
+			s.m_num_parks.store(s.m_num_parks.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+		}
+		s.m_last_wait_ns.store(ns, std::memory_order_relaxed);
+		s.m_max_wait_ns.store(std::max(ns, s.m_max_wait_ns.load(std::memory_order_relaxed)), std::memory_order_relaxed);
+		s.m_total_wait_ns.store(s.m_total_wait_ns.load(std::memory_order_relaxed) + ns, std::memory_order_relaxed);
+	}
+
+	alignas(grvslib::impl::cache_line_size) std::atomic<std::size_t> m_num_arrived {0};
+	alignas(grvslib::impl::cache_line_size) std::atomic<std::uint32_t> m_phase {0};
+	std::atomic<std::uint32_t> m_num_parked {0};
+
+	const std::size_t m_num_participants;
+	const std::uint32_t m_spin_iterations;
+	std::unique_ptr<padded_stats[]> m_stats;
+};
+
+#endif //__cpp_lib_atomic_wait >= 201907L
+
+/**
+ * One channel's meter readings in a meter_bank.
+ */
+struct meter_values
+{
+	float m_peak {0.0f};
+	float m_rms {0.0f};
+	std::uint32_t m_clip_count {0};
+
+	/// Fold @p other in: the larger peak and RMS, and the clips of both.
+	void merge(const meter_values& other) noexcept
+	{
+		m_peak = std::max(m_peak, other.m_peak);
+		m_rms = std::max(m_rms, other.m_rms);
+		m_clip_count += other.m_clip_count;
+	}
+};
+
+/**
+ * Transfers a whole bank of per-channel meters (e.g. peak, RMS and clip count for 128 channels) from the RT thread to
+ * a UI thread once per block, for the price of one atomic load and at most one atomic store.
+ *
+ * A separate atomic_notifying_parameter per value would cost the RT thread hundreds of atomic stores a block, and one
+ * for the whole bank would be a non-atomic payload, i.e. the locked path.  Instead there are two plain buffers and a
+ * single atomic state word holding which buffer the RT thread owns and whether the other one holds readings the UI
+ * hasn't taken yet:
+ *
+ * - The RT thread merges its readings into its own buffer with update(), plain loads and stores.
+ * - At the end of the block it calls publish().  If the UI has taken the last published buffer, the buffers swap,
+ *   and the RT thread starts over on a reset one.  If not, it keeps merging into the one it has, and tries again
+ *   next block.  Either way it never waits, and nothing is lost: a peak between two UI reads is still held.
+ * - The UI thread calls read_and_merge() whenever it likes.  If a buffer has been published, it merges it into the
+ *   UI's own peak-hold array and hands the buffer back.
+ *
+ * Only the RT thread changes which buffer it owns, and only the UI thread says it's done with the other, so the
+ * state word never needs a read-modify-write.
+ */
+class meter_bank
+{
+public:
+	explicit meter_bank(std::size_t num_channels)
+		: m_num_channels(num_channels),
+		  m_buffers{std::make_unique<meter_values[]>(num_channels + c_padding),
+					std::make_unique<meter_values[]>(num_channels + c_padding)},
+		  m_rt_buffer(m_buffers[0].get())
+	{
+	}
+
+	meter_bank(const meter_bank&) = delete;
+	meter_bank& operator=(const meter_bank&) = delete;
+
+	std::size_t num_channels() const noexcept { return m_num_channels; }
+
+	/// @name RT thread
+	///@{
+
+	/// Merge one block's readings for @p channel into the RT thread's buffer.
+	void update(std::size_t channel, float peak, float rms, std::uint32_t clip_count = 0) noexcept
+	{
+		m_rt_buffer[channel].merge(meter_values{peak, rms, clip_count});
+	}
+
+	/**
+	 * The RT thread's buffer, for code which fills in all the channels at once.  Merge into it rather than
+	 * overwriting it: it may still hold earlier blocks' readings the UI hasn't taken yet.
+	 */
+	meter_values* rt_buffer() noexcept { return m_rt_buffer; }
+
+	/**
+	 * Call at the end of every block.  Publishes the readings merged since the last successful publish(), if the UI
+	 * has taken those.
+	 * @return true if it published.
+	 */
+	bool publish() noexcept
+	{
+		const std::uint32_t state = m_state.load(std::memory_order_acquire);
+		if((state & c_published) != 0)
+		{
+			// The UI hasn't taken the last lot yet.  Keep merging into this buffer.
+			return false;
+		}
+		const std::uint32_t rt_index = state & c_rt_index;
+		// Hand over our buffer and take the other, which the UI has finished with.
+		m_state.store((rt_index ^ 1) | c_published, std::memory_order_release);
+		m_rt_buffer = buffer(rt_index ^ 1);
+		std::fill_n(m_rt_buffer, m_num_channels, meter_values{});
+		return true;
+	}
+
+	///@}
+
+	/// @name UI thread
+	///@{
+
+	/**
+	 * If the RT thread has published since the last call, merge its readings into @p held (num_channels() of
+	 * them), and hand its buffer back.  Reset @p held yourself when your peak-hold time runs out.
+	 * @return true if there were new readings.
+	 */
+	bool read_and_merge(meter_values* held) noexcept
+	{
+		const std::uint32_t state = m_state.load(std::memory_order_acquire);
+		if((state & c_published) == 0)
+		{
+			return false;
+		}
+		// The published buffer is the one the RT thread doesn't own.
+		const meter_values* published = buffer((state & c_rt_index) ^ 1);
+		for(std::size_t i = 0; i < m_num_channels; ++i)
+		{
+			held[i].merge(published[i]);
+		}
+		// Release: the RT thread mustn't reset the buffer until we're done reading it.
+		m_state.store(state & c_rt_index, std::memory_order_release);
+		return true;
+	}
+
+	///@}
+
+private:
+	static constexpr std::uint32_t c_rt_index = 1;
+	static constexpr std::uint32_t c_published = 2;
+
+	/// A cache line's worth of unused channels after each buffer, so the two threads never share a line.
+	static constexpr std::size_t c_padding = grvslib::impl::cache_line_size / sizeof(meter_values) + 1;
+
+	meter_values* buffer(std::uint32_t index) const noexcept { return m_buffers[index].get(); }
+
+	/// Which buffer the RT thread owns (c_rt_index), and whether the other is published and unread (c_published).
+	alignas(grvslib::impl::cache_line_size) std::atomic<std::uint32_t> m_state {0};
+
+	const std::size_t m_num_channels;
+	std::unique_ptr<meter_values[]> m_buffers[2];
+	/// Only the RT thread touches this.  Starts as buffer 0, per m_state.
+	meter_values* m_rt_buffer;
+};
+
 #endif //GRVSLIB_REALTIME_H
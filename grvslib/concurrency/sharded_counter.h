@@ -0,0 +1,118 @@
+/*
+ * Copyright 2024 Gary R. Van Sickle (grvs@users.sourceforge.net).
+ *
+ * This file is part of grvslib.
+ *
+ * grvslib is free software: you can redistribute it and/or modify it under the
+ * terms of version 3 of the GNU General Public License as published by the Free
+ * Software Foundation.
+ *
+ * grvslib is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * grvslib.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file Sharded counters, for counting things on hot paths without the counter itself becoming a point of contention.
+ */
+
+#ifndef GRVSLIB_SHARDED_COUNTER_H
+#define GRVSLIB_SHARDED_COUNTER_H
+
+// Std C++
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// Ours.
+#include "cache_line.h"
+
+namespace grvslib::impl
+{
+/**
+ * A small, stable, per-thread number, handed out round-robin the first time each thread asks for it.  Used to pick
+ * a shard.  We use per-thread rather than per-CPU shards since getting the current CPU isn't free everywhere, and a
+ * thread migrating mid-increment would make the per-CPU slot shared anyway.
+ */
+inline std::size_t this_thread_shard_index() noexcept
+{
+	static std::atomic<std::size_t> s_next_index {0};
+	thread_local const std::size_t t_index = s_next_index.fetch_add(1, std::memory_order_relaxed);
+	return t_index;
+}
+}
+
+/**
+ * A counter split into @p NumShards cache-line-sized slots.  Each thread adds to its own slot, so concurrent add()s
+ * from different threads don't bounce a cache line between cores the way a single shared std::atomic would.  Reading
+ * sums the slots, so it's comparatively slow; that's the right trade for metrics, which are written constantly and
+ * read occasionally.
+ *
+ * Slot updates are relaxed atomic RMWs, so it stays correct when more than @p NumShards threads share slots.
+ *
+ * @tparam ValueType  The counter type.  Use a signed type for gauges which go up and down.
+ * @tparam NumShards  Number of slots.  Must be a power of two.
+ */
+template<typename ValueType, std::size_t NumShards = 16>
+class basic_sharded_counter
+{
+	static_assert((NumShards & (NumShards - 1)) == 0, "NumShards must be a power of two");
+
+public:
+	static constexpr bool is_always_lock_free = std::atomic<ValueType>::is_always_lock_free;
+
+	void add(ValueType n = 1) noexcept
+	{
+		my_shard().fetch_add(n, std::memory_order_relaxed);
+	}
+
+	void sub(ValueType n = 1) noexcept
+	{
+		my_shard().fetch_sub(n, std::memory_order_relaxed);
+	}
+
+	/// The sum over all shards.  Not a snapshot: adds that race with the read may or may not be included.
+	ValueType read() const noexcept
+	{
+		ValueType sum {0};
+		for(const auto& shard : m_shards)
+		{
+			sum += shard.m_value.load(std::memory_order_relaxed);
+		}
+		return sum;
+	}
+
+	/// Zero all shards.  Like read(), not atomic with respect to concurrent add()s.
+	void reset() noexcept
+	{
+		for(auto& shard : m_shards)
+		{
+			shard.m_value.store(0, std::memory_order_relaxed);
+		}
+	}
+
+private:
+	std::atomic<ValueType>& my_shard() noexcept
+	{
+		return m_shards[grvslib::impl::this_thread_shard_index() & (NumShards - 1)].m_value;
+	}
+
+	struct alignas(grvslib::impl::cache_line_size) shard
+	{
+		std::atomic<ValueType> m_value {0};
+	};
+
+	std::array<shard, NumShards> m_shards {};
+};
+
+/// A monotonic event counter.
+using sharded_counter = basic_sharded_counter<std::uint64_t>;
+
+/// A counter which can go up and down, e.g. "number of threads currently waiting".
+using sharded_gauge = basic_sharded_counter<std::int64_t>;
+
+#endif //GRVSLIB_SHARDED_COUNTER_H
@@ -0,0 +1,138 @@
+/*
+ * Copyright 2024 Gary R. Van Sickle (grvs@users.sourceforge.net).
+ *
+ * This file is part of grvslib.
+ *
+ * grvslib is free software: you can redistribute it and/or modify it under the
+ * terms of version 3 of the GNU General Public License as published by the Free
+ * Software Foundation.
+ *
+ * grvslib is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * grvslib.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "shared_memory.h"
+
+#ifdef GRVSLIB_HAVE_SHARED_MEMORY
+
+// Std C++
+#include <cerrno>
+#include <system_error>
+
+// POSIX
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace
+{
+
+[[noreturn]] void throw_errno(int err, const std::string& what)
+{
+	throw std::system_error(err, std::system_category(), what);
+}
+
+/// Maps all @p size bytes of @p fd and closes it, which doesn't affect the mapping.
+void* map_and_close(int fd, std::size_t size, const std::string& name)
+{
+	void* data = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	const int err = errno;
+	::close(fd);
+	if(data == MAP_FAILED)
+	{
+		throw_errno(err, "shared_memory_segment: mmap " + name);
+	}
+	return data;
+}
+
+}
+
+shared_memory_segment shared_memory_segment::create(const std::string& name, std::size_t size)
+{
+	const int fd = ::shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+	if(fd < 0)
+	{
+		throw_errno(errno, "shared_memory_segment: create " + name);
+	}
+	if(::ftruncate(fd, static_cast<off_t>(size)) != 0)
+	{
+		const int err = errno;
+		::close(fd);
+		::shm_unlink(name.c_str());
+		throw_errno(err, "shared_memory_segment: ftruncate " + name);
+	}
+	try
+	{
+		return shared_memory_segment(name, map_and_close(fd, size, name), size);
+	}
+	catch(...)
+	{
+		::shm_unlink(name.c_str());
+		throw;
+	}
+}
+
+shared_memory_segment shared_memory_segment::open(const std::string& name)
+{
+	const int fd = ::shm_open(name.c_str(), O_RDWR, 0);
+	if(fd < 0)
+	{
+		throw_errno(errno, "shared_memory_segment: open " + name);
+	}
+	struct stat st {};
+	if(::fstat(fd, &st) != 0)
+	{
+		const int err = errno;
+		::close(fd);
+		throw_errno(err, "shared_memory_segment: fstat " + name);
+	}
+	const auto size = static_cast<std::size_t>(st.st_size);
+	if(size == 0)
+	{
+		// Creator hasn't ftruncate()d it yet, and mmap() would fail anyway.
+		::close(fd);
+		throw_errno(EAGAIN, "shared_memory_segment: open " + name);
+	}
+	return shared_memory_segment(name, map_and_close(fd, size, name), size);
+}
+
+bool shared_memory_segment::unlink(const std::string& name) noexcept
+{
+	return ::shm_unlink(name.c_str()) == 0;
+}
+
+shared_memory_segment::shared_memory_segment(shared_memory_segment&& other) noexcept
+	: m_name(std::move(other.m_name)), m_data(std::exchange(other.m_data, nullptr)),
+	  m_size(std::exchange(other.m_size, 0))
+{
+}
+
+shared_memory_segment& shared_memory_segment::operator=(shared_memory_segment&& other) noexcept
+{
+	if(this != &other)
+	{
+		if(m_data != nullptr)
+		{
+			::munmap(m_data, m_size);
+		}
+		m_name = std::move(other.m_name);
+		m_data = std::exchange(other.m_data, nullptr);
+		m_size = std::exchange(other.m_size, 0);
+	}
+	return *this;
+}
+
+shared_memory_segment::~shared_memory_segment()
+{
+	if(m_data != nullptr)
+	{
+		::munmap(m_data, m_size);
+	}
+}
+
+#endif // GRVSLIB_HAVE_SHARED_MEMORY
@@ -0,0 +1,174 @@
+/*
+ * Copyright 2024 Gary R. Van Sickle (grvs@users.sourceforge.net).
+ *
+ * This file is part of grvslib.
+ *
+ * grvslib is free software: you can redistribute it and/or modify it under the
+ * terms of version 3 of the GNU General Public License as published by the Free
+ * Software Foundation.
+ *
+ * grvslib is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * grvslib.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file POSIX shared memory segments, and objects constructed in them.
+ */
+
+#ifndef GRVSLIB_SHARED_MEMORY_H
+#define GRVSLIB_SHARED_MEMORY_H
+
+// Std C++
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+#if __has_include(<sys/mman.h>) && __has_include(<fcntl.h>)
+#define GRVSLIB_HAVE_SHARED_MEMORY 1
+#endif
+
+// Ours.
+#include "cache_line.h"
+#include "futex.h"
+
+#ifdef GRVSLIB_HAVE_SHARED_MEMORY
+
+/**
+ * A named POSIX shared memory segment (shm_open() + mmap()), mapped read/write for as long as this object lives.
+ *
+ * Destroying the object unmaps the segment but doesn't remove the name; call unlink() for that once every process
+ * which needs it has open()ed it.
+ */
+class shared_memory_segment
+{
+public:
+	/**
+	 * Create a new segment of @p size bytes, zero-filled.
+	 * @param name  A POSIX shm name, e.g. "/myapp-params".
+	 * @throws std::system_error if it already exists, or on any other failure.
+	 */
+	static shared_memory_segment create(const std::string& name, std::size_t size);
+
+	/**
+	 * Map an existing segment, at its full size.
+	 * @throws std::system_error if it doesn't exist, or on any other failure.
+	 */
+	static shared_memory_segment open(const std::string& name);
+
+	/// Remove @p name.  Existing mappings stay valid.  @return false if there was no such segment.
+	static bool unlink(const std::string& name) noexcept;
+
+	shared_memory_segment(shared_memory_segment&& other) noexcept;
+	shared_memory_segment& operator=(shared_memory_segment&& other) noexcept;
+	~shared_memory_segment();
+
+	void* data() const noexcept { return m_data; }
+	std::size_t size() const noexcept { return m_size; }
+	const std::string& name() const noexcept { return m_name; }
+
+private:
+	shared_memory_segment(std::string name, void* data, std::size_t size) noexcept
+		: m_name(std::move(name)), m_data(data), m_size(size) {}
+
+	std::string m_name;
+	void* m_data {nullptr};
+	std::size_t m_size {0};
+};
+
+/**
+ * A @p T constructed in its own shared memory segment, so that several processes can use it at once.
+ *
+ * One process create()s it, which constructs the T; the others open() it.  @p T must not contain pointers (each
+ * process may map the segment at a different address), and must be trivially destructible, since nobody can know
+ * when the last process is done with it.  Anything built from lock-free atomics, futex_mutex and plain data fits.
+ */
+template<typename T>
+class shared_object
+{
+	static_assert(std::is_trivially_destructible_v<T>, "shared_object<T> never runs ~T(), so T must not need it");
+
+	/// Precedes the T in the segment.  Lets open() tell whether create() has finished constructing it.
+	struct header
+	{
+		std::atomic<std::uint32_t> m_state;
+		std::uint32_t m_sizeof_T;
+	};
+	static constexpr std::uint32_t c_constructed = 0x67727673;  // "grvs"
+	static constexpr std::size_t c_offset = std::max(alignof(T), grvslib::impl::cache_line_size);
+
+public:
+	/**
+	 * Create the segment @p name and construct a T in it from @p args.
+	 * @throws std::system_error as shared_memory_segment::create(), or whatever T's constructor throws.
+	 */
+	template<typename... Args>
+	static shared_object create(const std::string& name, Args&&... args)
+	{
+		auto segment = shared_memory_segment::create(name, c_offset + sizeof(T));
+		auto* h = ::new(segment.data()) header{{0}, static_cast<std::uint32_t>(sizeof(T))};
+		T* object = ::new(static_cast<std::byte*>(segment.data()) + c_offset) T(std::forward<Args>(args)...);
+		h->m_state.store(c_constructed, std::memory_order_release);
+		grvslib::impl::futex_wake(&h->m_state);
+		return shared_object(std::move(segment), object);
+	}
+
+	/**
+	 * Map the existing segment @p name.  If another process is still in create(), waits up to @p timeout for it.
+	 * @throws std::system_error as shared_memory_segment::open().
+	 * @throws std::runtime_error if the segment doesn't hold a constructed T.
+	 */
+	static shared_object open(const std::string& name, std::chrono::nanoseconds timeout = std::chrono::seconds(1))
+	{
+		auto segment = shared_memory_segment::open(name);
+		if(segment.size() < c_offset + sizeof(T))
+		{
+			throw std::runtime_error("shared_object: segment " + name + " is too small");
+		}
+		auto* h = static_cast<header*>(segment.data());
+		const auto deadline = std::chrono::steady_clock::now() + timeout;
+		std::uint32_t state;
+		while((state = h->m_state.load(std::memory_order_acquire)) != c_constructed)
+		{
+			const auto remaining = deadline - std::chrono::steady_clock::now();
+			if(remaining <= std::chrono::nanoseconds::zero())
+			{
+				throw std::runtime_error("shared_object: segment " + name + " was never initialized");
+			}
+			grvslib::impl::futex_wait(&h->m_state, state,
+									  std::chrono::duration_cast<std::chrono::nanoseconds>(remaining).count());
+		}
+		if(h->m_sizeof_T != sizeof(T))
+		{
+			throw std::runtime_error("shared_object: segment " + name + " holds a different type");
+		}
+		T* object = std::launder(reinterpret_cast<T*>(static_cast<std::byte*>(segment.data()) + c_offset));
+		return shared_object(std::move(segment), object);
+	}
+
+	T* get() const noexcept { return m_object; }
+	T* operator->() const noexcept { return m_object; }
+	T& operator*() const noexcept { return *m_object; }
+	const shared_memory_segment& segment() const noexcept { return m_segment; }
+
+private:
+	shared_object(shared_memory_segment segment, T* object) noexcept
+		: m_segment(std::move(segment)), m_object(object) {}
+
+	shared_memory_segment m_segment;
+	T* m_object;
+};
+
+#endif // GRVSLIB_HAVE_SHARED_MEMORY
+
+#endif //GRVSLIB_SHARED_MEMORY_H
@@ -0,0 +1,193 @@
+/*
+ * Copyright 2024 Gary R. Van Sickle (grvs@users.sourceforge.net).
+ *
+ * This file is part of grvslib.
+ *
+ * grvslib is free software: you can redistribute it and/or modify it under the
+ * terms of version 3 of the GNU General Public License as published by the Free
+ * Software Foundation.
+ *
+ * grvslib is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * grvslib.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file An atomic_notifying_parameter which works between processes.
+ */
+
+#ifndef GRVSLIB_SHARED_NOTIFYING_PARAMETER_H
+#define GRVSLIB_SHARED_NOTIFYING_PARAMETER_H
+
+// Std C++
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+// Ours.
+#include "cache_line.h"
+#include "futex.h"
+
+/**
+ * The same contract as atomic_notifying_parameter (any number of producers, one consumer which only wants the latest
+ * value), but usable between processes: put it in shared memory, e.g. with shared_object<>, and have the UI
+ * process store_and_set() while the engine process calls load_and_clear_if_set().
+ *
+ * atomic_notifying_parameter itself can't do that for non-atomic payloads, because std::atomic_flag::wait() and
+ * notify_all() are only guaranteed to work within one process.  So this is a seqlock instead:
+ *
+ * - The payload is stored as an array of relaxed std::atomic<std::uint64_t> words, so copying it in and out is never
+ *   a data race, and it's never locked against the consumer.
+ * - A sequence number is odd while a store is in progress and bumped by two per store.  The consumer reads it before
+ *   and after copying the payload out, and throws the copy away if it changed or was odd.  A different value from the
+ *   last one the consumer took means there's something new.
+ * - Producers serialize among themselves with a futex_mutex, which only makes a syscall when they actually collide.
+ *
+ * So load_and_clear_if_set() is lock-free and never makes a syscall.  As with atomic_notifying_parameter, if it
+ * catches a store in progress it returns false, and the next call will pick the new value up.
+ *
+ * Non-RT consumers which would rather sleep than poll can call wait_for_update(), which blocks on a futex.
+ * store_and_set() only pays for a FUTEX_WAKE when somebody is actually waiting.
+ *
+ * Everything is inline in the object with no pointers, so it works wherever each process maps it.  If a producer
+ * process dies in the middle of store_and_set(), the parameter is stuck; see the note on futex_mutex.
+ *
+ * @tparam PayloadType  Must be trivially copyable.
+ */
+template<typename PayloadType>
+class shared_notifying_parameter
+{
+	static_assert(std::is_trivially_copyable_v<PayloadType>,
+				  "shared_notifying_parameter copies PayloadType a word at a time, so it must be trivially copyable");
+
+	static constexpr std::size_t c_num_words = (sizeof(PayloadType) + sizeof(std::uint64_t) - 1) / sizeof(std::uint64_t);
+
+public:
+	/// load_and_clear_if_set() is lock-free, and store_and_set() is as long as producers don't collide.
+	static constexpr bool is_always_lock_free = std::atomic<std::uint64_t>::is_always_lock_free
+			&& std::atomic<std::uint32_t>::is_always_lock_free;
+
+	/// The consumer sees @p initial as already consumed, i.e. load_and_clear_if_set() returns false until a store.
+	explicit shared_notifying_parameter(const PayloadType& initial = PayloadType{}) noexcept
+	{
+		store_words(initial);
+	}
+
+	shared_notifying_parameter(const shared_notifying_parameter&) = delete;
+	shared_notifying_parameter& operator=(const shared_notifying_parameter&) = delete;
+
+	/**
+	 * The consumer's half, as atomic_notifying_parameter::load_and_clear_if_set().  Never blocks or makes a syscall.
+	 * Only one thread, in one process, may call this (and wait_for_update()).
+	 *
+	 * @return true if there was a newly-stored value, which is now in @p reader_payload.
+	 */
+	bool load_and_clear_if_set(PayloadType* reader_payload)
+	{
+		const std::uint32_t seq = m_sequence.load(std::memory_order_acquire);
+		if(seq == m_consumed_sequence.load(std::memory_order_relaxed) || (seq & 1) != 0)
+		{
+			// Nothing new, or a store is in progress.
+			return false;
+		}
+
+		std::uint64_t words[c_num_words];
+		for(std::size_t i = 0; i < c_num_words; ++i)
+		{
+			words[i] = m_words[i].load(std::memory_order_relaxed);
+		}
+		// Keeps the payload loads above from sinking below the recheck.
+		std::atomic_thread_fence(std::memory_order_acquire);
+		if(m_sequence.load(std::memory_order_relaxed) != seq)
+		{
+			// Torn by a concurrent store.  Leave it for next time.
+			return false;
+		}
+
+		std::memcpy(reader_payload, words, sizeof(PayloadType));
+		m_consumed_sequence.store(seq, std::memory_order_relaxed);
+		return true;
+	}
+
+	/// The producers' half.  Any thread, in any process.
+	void store_and_set(const PayloadType& new_writer_payload)
+	{
+		m_producer_lock.lock();
+		const std::uint32_t seq = m_sequence.load(std::memory_order_relaxed);
+		m_sequence.store(seq + 1, std::memory_order_relaxed);
+		// Keeps the payload stores below from floating above the odd sequence number.
+		std::atomic_thread_fence(std::memory_order_release);
+		store_words(new_writer_payload);
+		// seq_cst rather than release: this and the m_num_waiters load below are the two halves of a Dekker handshake
+		// with wait_for_update().
+		m_sequence.store(seq + 2, std::memory_order_seq_cst);
+		m_producer_lock.unlock();
+
+		if(m_num_waiters.load(std::memory_order_seq_cst) != 0)
+		{
+			grvslib::impl::futex_wake(&m_sequence);
+		}
+	}
+
+	/**
+	 * For consumers which aren't RT: block until there's a value load_and_clear_if_set() hasn't returned yet, or
+	 * @p timeout passes.
+	 *
+	 * @return true if there's a new value to load.
+	 */
+	bool wait_for_update(std::chrono::nanoseconds timeout)
+	{
+		const auto deadline = std::chrono::steady_clock::now() + timeout;
+		const std::uint32_t consumed = m_consumed_sequence.load(std::memory_order_relaxed);
+		bool updated = false;
+
+		m_num_waiters.fetch_add(1, std::memory_order_seq_cst);
+		while(true)
+		{
+			const std::uint32_t seq = m_sequence.load(std::memory_order_seq_cst);
+			if(seq != consumed && (seq & 1) == 0)
+			{
+				updated = true;
+				break;
+			}
+			const auto remaining = deadline - std::chrono::steady_clock::now();
+			if(remaining <= std::chrono::nanoseconds::zero())
+			{
+				break;
+			}
+			grvslib::impl::futex_wait(&m_sequence, seq,
+									  std::chrono::duration_cast<std::chrono::nanoseconds>(remaining).count());
+		}
+		m_num_waiters.fetch_sub(1, std::memory_order_relaxed);
+		return updated;
+	}
+
+private:
+	void store_words(const PayloadType& payload) noexcept
+	{
+		std::uint64_t words[c_num_words] {};
+		std::memcpy(words, &payload, sizeof(PayloadType));
+		for(std::size_t i = 0; i < c_num_words; ++i)
+		{
+			m_words[i].store(words[i], std::memory_order_relaxed);
+		}
+	}
+
+	/// Odd while a store is in progress.  Also the futex wait_for_update() sleeps on.
+	alignas(grvslib::impl::cache_line_size) std::atomic<std::uint32_t> m_sequence {0};
+	std::atomic<std::uint32_t> m_num_waiters {0};
+	grvslib::impl::futex_mutex m_producer_lock;
+
+	/// The last sequence number the consumer took a value from.  Only touched by the consumer.
+	alignas(grvslib::impl::cache_line_size) std::atomic<std::uint32_t> m_consumed_sequence {0};
+
+	alignas(grvslib::impl::cache_line_size) std::atomic<std::uint64_t> m_words[c_num_words];
+};
+
+#endif //GRVSLIB_SHARED_NOTIFYING_PARAMETER_H
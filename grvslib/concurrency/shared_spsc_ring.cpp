@@ -0,0 +1,199 @@
+/*
+ * Copyright 2024 Gary R. Van Sickle (grvs@users.sourceforge.net).
+ *
+ * This file is part of grvslib.
+ *
+ * grvslib is free software: you can redistribute it and/or modify it under the
+ * terms of version 3 of the GNU General Public License as published by the Free
+ * Software Foundation.
+ *
+ * grvslib is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * grvslib.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "shared_spsc_ring.h"
+
+#ifdef GRVSLIB_HAVE_SHARED_MEMORY
+
+// Std C++
+#include <cerrno>
+#include <new>
+#include <stdexcept>
+#include <utility>
+
+// POSIX
+#include <signal.h>
+#include <unistd.h>
+
+namespace
+{
+
+constexpr std::uint32_t c_magic = 0x72696e67;  // "ring"
+
+constexpr std::size_t round_up(std::size_t n, std::size_t multiple)
+{
+	return (n + multiple - 1) / multiple * multiple;
+}
+
+/// Note that a zombie counts as alive: a parent has to waitpid() a dead child before taking over its role.
+bool process_alive(std::int32_t pid) noexcept
+{
+	return pid != 0 && (::kill(static_cast<pid_t>(pid), 0) == 0 || errno == EPERM);
+}
+
+}
+
+shared_spsc_ring shared_spsc_ring::create(const std::string& name, std::size_t record_size, std::size_t min_capacity,
+										  role r)
+{
+	if(record_size == 0 || min_capacity == 0)
+	{
+		throw std::invalid_argument("shared_spsc_ring: record size and capacity must be nonzero");
+	}
+	std::size_t capacity = 1;
+	while(capacity < min_capacity)
+	{
+		capacity *= 2;
+	}
+	const std::size_t stride = round_up(record_size, alignof(std::max_align_t));
+	const std::size_t records_offset = round_up(sizeof(control), grvslib::impl::cache_line_size);
+
+	auto segment = shared_memory_segment::create(name, records_offset + capacity * stride);
+	auto* c = ::new(segment.data()) control{};
+	c->m_record_size = static_cast<std::uint32_t>(record_size);
+	c->m_capacity = capacity;
+	c->m_record_stride = stride;
+	c->m_magic.store(c_magic, std::memory_order_release);
+	grvslib::impl::futex_wake(&c->m_magic);
+	return shared_spsc_ring(std::move(segment), r);
+}
+
+shared_spsc_ring shared_spsc_ring::open(const std::string& name, role r)
+{
+	auto segment = shared_memory_segment::open(name);
+	if(segment.size() < sizeof(control))
+	{
+		throw std::runtime_error("shared_spsc_ring: segment " + name + " is too small");
+	}
+
+	// Give a concurrent create() a moment to finish.
+	auto* c = static_cast<control*>(segment.data());
+	const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+	std::uint32_t magic;
+	while((magic = c->m_magic.load(std::memory_order_acquire)) != c_magic)
+	{
+		const auto remaining = deadline - std::chrono::steady_clock::now();
+		if(magic != 0 || remaining <= std::chrono::nanoseconds::zero())
+		{
+			throw std::runtime_error("shared_spsc_ring: segment " + name + " isn't a ring");
+		}
+		grvslib::impl::futex_wait(&c->m_magic, magic,
+								  std::chrono::duration_cast<std::chrono::nanoseconds>(remaining).count());
+	}
+	if(segment.size() < round_up(sizeof(control), grvslib::impl::cache_line_size) + c->m_capacity * c->m_record_stride)
+	{
+		throw std::runtime_error("shared_spsc_ring: segment " + name + " is too small");
+	}
+	return shared_spsc_ring(std::move(segment), r);
+}
+
+shared_spsc_ring::shared_spsc_ring(shared_memory_segment segment, role r)
+	: m_segment(std::move(segment)),
+	  m_control(static_cast<control*>(m_segment.data())),
+	  m_records(static_cast<std::byte*>(m_segment.data()) + round_up(sizeof(control), grvslib::impl::cache_line_size)),
+	  m_record_size(m_control->m_record_size),
+	  m_record_stride(m_control->m_record_stride),
+	  m_capacity(m_control->m_capacity),
+	  m_role(r)
+{
+	// Claim the role, unless a live process has it.
+	auto& pid_slot = m_role == role::producer ? m_control->m_producer_pid : m_control->m_consumer_pid;
+	const auto me = static_cast<std::int32_t>(::getpid());
+	std::int32_t holder = pid_slot.load(std::memory_order_acquire);
+	do
+	{
+		if(holder != 0 && process_alive(holder))
+		{
+			throw std::runtime_error(std::string("shared_spsc_ring: ") + m_segment.name() + " already has a "
+									 + (m_role == role::producer ? "producer" : "consumer"));
+		}
+	} while(!pid_slot.compare_exchange_weak(holder, me, std::memory_order_acq_rel, std::memory_order_acquire));
+
+	// The shared positions are all we need to resume; a dead predecessor can't have left them inconsistent.
+	const std::uint64_t head = m_control->m_head.load(std::memory_order_acquire);
+	const std::uint64_t tail = m_control->m_tail.load(std::memory_order_acquire);
+	if(tail - head > m_capacity)
+	{
+		pid_slot.store(0, std::memory_order_release);
+		throw std::runtime_error("shared_spsc_ring: " + m_segment.name() + " is corrupt");
+	}
+	m_cached_position = m_role == role::producer ? head : tail;
+	if(m_role == role::consumer)
+	{
+		m_control->m_consumer_waiting.store(0, std::memory_order_relaxed);
+	}
+}
+
+shared_spsc_ring::shared_spsc_ring(shared_spsc_ring&& other) noexcept
+	: m_segment(std::move(other.m_segment)),
+	  m_control(std::exchange(other.m_control, nullptr)),
+	  m_records(other.m_records),
+	  m_record_size(other.m_record_size),
+	  m_record_stride(other.m_record_stride),
+	  m_capacity(other.m_capacity),
+	  m_role(other.m_role),
+	  m_cached_position(other.m_cached_position)
+{
+}
+
+shared_spsc_ring::~shared_spsc_ring()
+{
+	if(m_control != nullptr)
+	{
+		auto& pid_slot = m_role == role::producer ? m_control->m_producer_pid : m_control->m_consumer_pid;
+		std::int32_t me = static_cast<std::int32_t>(::getpid());
+		pid_slot.compare_exchange_strong(me, 0, std::memory_order_acq_rel);
+	}
+}
+
+bool shared_spsc_ring::wait_for_data(std::chrono::nanoseconds timeout)
+{
+	const auto deadline = std::chrono::steady_clock::now() + timeout;
+	const std::uint64_t head = m_control->m_head.load(std::memory_order_relaxed);
+	bool ready = false;
+
+	m_control->m_consumer_waiting.store(1, std::memory_order_seq_cst);
+	while(true)
+	{
+		// Read the futex word before checking for data, so a commit() in between changes it and the wait falls
+		// straight through.
+		const std::uint32_t wakeups = m_control->m_wakeups.load(std::memory_order_seq_cst);
+		m_cached_position = m_control->m_tail.load(std::memory_order_seq_cst);
+		if(m_cached_position != head)
+		{
+			ready = true;
+			break;
+		}
+		const auto remaining = deadline - std::chrono::steady_clock::now();
+		if(remaining <= std::chrono::nanoseconds::zero())
+		{
+			break;
+		}
+		grvslib::impl::futex_wait(&m_control->m_wakeups, wakeups,
+								  std::chrono::duration_cast<std::chrono::nanoseconds>(remaining).count());
+	}
+	m_control->m_consumer_waiting.store(0, std::memory_order_relaxed);
+	return ready;
+}
+
+bool shared_spsc_ring::peer_attached() const noexcept
+{
+	const auto& pid_slot = m_role == role::producer ? m_control->m_consumer_pid : m_control->m_producer_pid;
+	return process_alive(pid_slot.load(std::memory_order_acquire));
+}
+
+#endif // GRVSLIB_HAVE_SHARED_MEMORY
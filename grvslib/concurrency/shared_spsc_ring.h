@@ -0,0 +1,221 @@
+/*
+ * Copyright 2024 Gary R. Van Sickle (grvs@users.sourceforge.net).
+ *
+ * This file is part of grvslib.
+ *
+ * grvslib is free software: you can redistribute it and/or modify it under the
+ * terms of version 3 of the GNU General Public License as published by the Free
+ * Software Foundation.
+ *
+ * grvslib is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * grvslib.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file A single-producer/single-consumer ring of fixed-size records in shared memory, for streaming between processes.
+ */
+
+#ifndef GRVSLIB_SHARED_SPSC_RING_H
+#define GRVSLIB_SHARED_SPSC_RING_H
+
+// Std C++
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+// Ours.
+#include "cache_line.h"
+#include "futex.h"
+#include "shared_memory.h"
+
+#ifdef GRVSLIB_HAVE_SHARED_MEMORY
+
+/**
+ * spsc_ring's design, in a named shared memory segment, carrying fixed-size records of raw bytes between two
+ * processes: typically meter or scope data from the engine to the UI.
+ *
+ * As in spsc_ring, the read and write positions are free-running counters on their own cache lines, and each side
+ * keeps a private cached copy of the other's, so in the steady state neither touches the other's cache line.
+ * Records are written and read in place with try_reserve()/commit() and front()/pop(); nothing is copied through the
+ * kernel.
+ *
+ * Waking up: by default the consumer polls.  A consumer which would rather sleep calls wait_for_data(), which blocks
+ * on a futex.  The producer only makes a FUTEX_WAKE syscall while a consumer is actually blocked there.
+ *
+ * Crash safety: each position is only ever written by one side, and only to publish a record which is already
+ * completely written (by the producer) or completely consumed (by the consumer).  So whenever either process dies,
+ * the shared state is consistent.  A record the producer was half-way through writing was never committed, and a
+ * record the consumer was half-way through reading is still there.  A replacement process just open()s the
+ * segment in the dead one's role and carries on.  The cached positions are process-private and rebuilt from the
+ * shared ones.  Each role records the pid holding it, so open() can refuse to attach a second live producer or
+ * consumer, but take over from a dead one.
+ */
+class shared_spsc_ring
+{
+public:
+	enum class role { producer, consumer };
+
+	/**
+	 * Create the segment @p name, holding at least @p min_capacity records of @p record_size bytes, and attach to it
+	 * as @p r.
+	 * @throws std::system_error as shared_memory_segment::create().
+	 * @throws std::invalid_argument if either size is zero.
+	 */
+	static shared_spsc_ring create(const std::string& name, std::size_t record_size, std::size_t min_capacity, role r);
+
+	/**
+	 * Attach to an existing ring as @p r, taking over from whoever held that role before if they've exited.
+	 * @throws std::system_error as shared_memory_segment::open().
+	 * @throws std::runtime_error if the segment isn't a ring, or a live process already holds @p r.
+	 */
+	static shared_spsc_ring open(const std::string& name, role r);
+
+	shared_spsc_ring(shared_spsc_ring&& other) noexcept;
+	shared_spsc_ring& operator=(shared_spsc_ring&&) = delete;
+	/// Gives up the role, so a later open() doesn't have to wait for this process to exit.
+	~shared_spsc_ring();
+
+	/// @name Producer side
+	///@{
+
+	/**
+	 * @return The next free record to fill in place, or nullptr if the ring is full.  Holds stale data.
+	 */
+	void* try_reserve() noexcept
+	{
+		const std::uint64_t tail = m_control->m_tail.load(std::memory_order_relaxed);
+		if(tail - m_cached_position >= m_capacity)
+		{
+			m_cached_position = m_control->m_head.load(std::memory_order_acquire);
+			if(tail - m_cached_position >= m_capacity)
+			{
+				return nullptr;
+			}
+		}
+		return record(tail);
+	}
+
+	/// Publish the record from the last try_reserve(), and wake the consumer if it's waiting.
+	void commit() noexcept
+	{
+		// seq_cst rather than release: this and the m_consumer_waiting load are a Dekker handshake with
+		// wait_for_data().
+		m_control->m_tail.store(m_control->m_tail.load(std::memory_order_relaxed) + 1, std::memory_order_seq_cst);
+		if(m_control->m_consumer_waiting.load(std::memory_order_seq_cst) != 0)
+		{
+			m_control->m_wakeups.fetch_add(1, std::memory_order_seq_cst);
+			grvslib::impl::futex_wake(&m_control->m_wakeups);
+		}
+	}
+
+	/// Copy record_size() bytes from @p data into the ring.  @return false if it was full.
+	bool try_push(const void* data) noexcept
+	{
+		void* r = try_reserve();
+		if(r == nullptr)
+		{
+			return false;
+		}
+		std::memcpy(r, data, m_record_size);
+		commit();
+		return true;
+	}
+
+	///@}
+
+	/// @name Consumer side
+	///@{
+
+	/// @return The oldest record, or nullptr if there isn't one.  Valid until pop().
+	const void* front() noexcept
+	{
+		const std::uint64_t head = m_control->m_head.load(std::memory_order_relaxed);
+		if(head == m_cached_position)
+		{
+			m_cached_position = m_control->m_tail.load(std::memory_order_acquire);
+			if(head == m_cached_position)
+			{
+				return nullptr;
+			}
+		}
+		return record(head);
+	}
+
+	/// Hand the record from front() back to the producer.
+	void pop() noexcept
+	{
+		m_control->m_head.store(m_control->m_head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+	}
+
+	/// @return The number of records ready to read.
+	std::size_t read_available() noexcept
+	{
+		m_cached_position = m_control->m_tail.load(std::memory_order_acquire);
+		return static_cast<std::size_t>(m_cached_position - m_control->m_head.load(std::memory_order_relaxed));
+	}
+
+	/**
+	 * Block until there's a record to read or @p timeout passes.  Not for RT threads.
+	 * @return true if there's a record.
+	 */
+	bool wait_for_data(std::chrono::nanoseconds timeout);
+
+	///@}
+
+	/// Whether the process on the other end is attached and still running.
+	bool peer_attached() const noexcept;
+
+	std::size_t record_size() const noexcept { return m_record_size; }
+	std::size_t capacity() const noexcept { return m_capacity; }
+
+private:
+	/// At the start of the segment.  The records follow, starting on a cache line.
+	struct control
+	{
+		/// Set last by create(), so open() can tell the rest is initialized.
+		std::atomic<std::uint32_t> m_magic;
+		std::uint32_t m_record_size;
+		std::uint64_t m_capacity;
+		std::uint64_t m_record_stride;
+		std::atomic<std::int32_t> m_producer_pid;
+		std::atomic<std::int32_t> m_consumer_pid;
+
+		/// Read position.  Written only by the consumer.
+		alignas(grvslib::impl::cache_line_size) std::atomic<std::uint64_t> m_head;
+		/// Nonzero while the consumer is in wait_for_data().
+		std::atomic<std::uint32_t> m_consumer_waiting;
+
+		/// Write position.  Written only by the producer.
+		alignas(grvslib::impl::cache_line_size) std::atomic<std::uint64_t> m_tail;
+		/// The futex wait_for_data() sleeps on.  Bumped by the producer when it wakes the consumer.
+		std::atomic<std::uint32_t> m_wakeups;
+	};
+
+	shared_spsc_ring(shared_memory_segment segment, role r);
+
+	void* record(std::uint64_t position) const noexcept
+	{
+		return m_records + (position & (m_capacity - 1)) * m_record_stride;
+	}
+
+	shared_memory_segment m_segment;
+	control* m_control;
+	std::byte* m_records;
+	std::size_t m_record_size;
+	std::size_t m_record_stride;
+	std::size_t m_capacity;
+	role m_role;
+	/// The producer's copy of m_head, or the consumer's copy of m_tail.  Process-private.
+	std::uint64_t m_cached_position {0};
+};
+
+#endif // GRVSLIB_HAVE_SHARED_MEMORY
+
+#endif //GRVSLIB_SHARED_SPSC_RING_H
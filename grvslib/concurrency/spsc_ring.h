@@ -0,0 +1,242 @@
+/*
+ * Copyright 2024 Gary R. Van Sickle (grvs@users.sourceforge.net).
+ *
+ * This file is part of grvslib.
+ *
+ * grvslib is free software: you can redistribute it and/or modify it under the
+ * terms of version 3 of the GNU General Public License as published by the Free
+ * Software Foundation.
+ *
+ * grvslib is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * grvslib.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file A bounded, lock-free, single-producer/single-consumer ring buffer.
+ */
+
+#ifndef GRVSLIB_SPSC_RING_H
+#define GRVSLIB_SPSC_RING_H
+
+// Std C++
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+// Ours.
+#include "cache_line.h"
+
+/**
+ * A bounded single-producer/single-consumer FIFO.  Both ends are wait-free.
+ *
+ * The read and write positions are free-running counters on their own cache lines, and each side keeps a private
+ * cached copy of the other side's position.  That means the producer only touches the consumer's cache line when the
+ * ring looks full, and the consumer only touches the producer's when it looks empty.
+ *
+ * All storage is allocated by the constructor; nothing after that allocates.
+ *
+ * @tparam T  The element type.  Must be default-constructible and copy- or move-assignable.
+ */
+template<typename T>
+class spsc_ring
+{
+	static_assert(std::is_default_constructible_v<T>, "spsc_ring requires a default-constructible T");
+
+public:
+	static constexpr bool is_always_lock_free = std::atomic<std::size_t>::is_always_lock_free;
+
+	/**
+	 * @param min_capacity  The ring will hold at least this many elements.  Rounded up to a power of two.
+	 */
+	explicit spsc_ring(std::size_t min_capacity)
+	{
+		if(min_capacity == 0)
+		{
+			throw std::invalid_argument("spsc_ring capacity must be nonzero");
+		}
+		std::size_t capacity = 1;
+		while(capacity < min_capacity)
+		{
+			capacity *= 2;
+		}
+		m_mask = capacity - 1;
+		m_buffer = std::make_unique<T[]>(capacity);
+	}
+
+	/**
+	 * As above, but every slot starts out as a copy of @p prototype.  Use this to preallocate slots which own memory
+	 * (e.g. a std::vector of samples), so that a producer using try_reserve() never has to.
+	 */
+	spsc_ring(std::size_t min_capacity, const T& prototype) : spsc_ring(min_capacity)
+	{
+		for(std::size_t i = 0; i < capacity(); ++i)
+		{
+			m_buffer[i] = prototype;
+		}
+	}
+
+	spsc_ring(const spsc_ring&) = delete;
+	spsc_ring& operator=(const spsc_ring&) = delete;
+
+	/// @name Producer side
+	///@{
+
+	/**
+	 * Append @p value.
+	 * @return false if the ring was full, in which case nothing was written.
+	 */
+	template<typename U>
+	bool try_push(U&& value)
+	{
+		const std::size_t tail = m_tail.load(std::memory_order_relaxed);
+		if(tail - m_cached_head > m_mask)
+		{
+			m_cached_head = m_head.load(std::memory_order_acquire);
+			if(tail - m_cached_head > m_mask)
+			{
+				return false;
+			}
+		}
+		m_buffer[tail & m_mask] = std::forward<U>(value);
+		m_tail.store(tail + 1, std::memory_order_release);
+		return true;
+	}
+
+	/**
+	 * Append as many of the @p count elements at @p values as will fit, publishing them all with a single store.
+	 * @return The number of elements appended.
+	 */
+	std::size_t try_push_n(const T* values, std::size_t count)
+	{
+		const std::size_t tail = m_tail.load(std::memory_order_relaxed);
+		std::size_t free_slots = capacity() - (tail - m_cached_head);
+		if(free_slots < count)
+		{
+			m_cached_head = m_head.load(std::memory_order_acquire);
+			free_slots = capacity() - (tail - m_cached_head);
+		}
+		const std::size_t n = count < free_slots ? count : free_slots;
+		for(std::size_t i = 0; i < n; ++i)
+		{
+			m_buffer[(tail + i) & m_mask] = values[i];
+		}
+		if(n != 0)
+		{
+			m_tail.store(tail + n, std::memory_order_release);
+		}
+		return n;
+	}
+
+	/**
+	 * Zero-copy alternative to try_push(): get the next free slot, fill it in place, then commit() it.  The slot
+	 * still holds whatever was last written to it.
+	 *
+	 * @return The slot, or nullptr if the ring is full.  Call this again or commit() before reserving another.
+	 */
+	T* try_reserve()
+	{
+		const std::size_t tail = m_tail.load(std::memory_order_relaxed);
+		if(tail - m_cached_head > m_mask)
+		{
+			m_cached_head = m_head.load(std::memory_order_acquire);
+			if(tail - m_cached_head > m_mask)
+			{
+				return nullptr;
+			}
+		}
+		return &m_buffer[tail & m_mask];
+	}
+
+	/// Publish the slot returned by the last try_reserve().  Only call this after it has returned non-null.
+	void commit()
+	{
+		m_tail.store(m_tail.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+	}
+
+	///@}
+
+	/// @name Consumer side
+	///@{
+
+	/**
+	 * @return A pointer to the oldest element, or nullptr if the ring is empty.  The element stays valid until pop().
+	 */
+	T* front()
+	{
+		const std::size_t head = m_head.load(std::memory_order_relaxed);
+		if(head == m_cached_tail)
+		{
+			m_cached_tail = m_tail.load(std::memory_order_acquire);
+			if(head == m_cached_tail)
+			{
+				return nullptr;
+			}
+		}
+		return &m_buffer[head & m_mask];
+	}
+
+	/**
+	 * @return The number of elements ready to be read.  Reloads the producer's position, so elements published after
+	 *         this call aren't counted; handy for consuming a consistent batch.
+	 */
+	std::size_t read_available()
+	{
+		m_cached_tail = m_tail.load(std::memory_order_acquire);
+		return m_cached_tail - m_head.load(std::memory_order_relaxed);
+	}
+
+	/// Discard the oldest element.  Only call this after front() has returned non-null.
+	void pop()
+	{
+		m_head.store(m_head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+	}
+
+	/**
+	 * Move the oldest element into @p value.
+	 * @return false if the ring was empty, in which case @p value is untouched.
+	 */
+	bool try_pop(T& value)
+	{
+		T* f = front();
+		if(f == nullptr)
+		{
+			return false;
+		}
+		value = std::move(*f);
+		pop();
+		return true;
+	}
+
+	///@}
+
+	/// Approximate; only exact when called from one side while the other is idle.
+	bool empty() const
+	{
+		return m_head.load(std::memory_order_acquire) == m_tail.load(std::memory_order_acquire);
+	}
+
+	std::size_t capacity() const noexcept { return m_mask + 1; }
+
+private:
+	/// Read position.  Written only by the consumer.
+	alignas(grvslib::impl::cache_line_size) std::atomic<std::size_t> m_head {0};
+	/// The consumer's copy of m_tail.
+	std::size_t m_cached_tail {0};
+
+	/// Write position.  Written only by the producer.
+	alignas(grvslib::impl::cache_line_size) std::atomic<std::size_t> m_tail {0};
+	/// The producer's copy of m_head.
+	std::size_t m_cached_head {0};
+
+	alignas(grvslib::impl::cache_line_size) std::size_t m_mask {0};
+	std::unique_ptr<T[]> m_buffer;
+};
+
+#endif //GRVSLIB_SPSC_RING_H
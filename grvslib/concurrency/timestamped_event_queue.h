@@ -0,0 +1,185 @@
+/*
+ * Copyright 2024 Gary R. Van Sickle (grvs@users.sourceforge.net).
+ *
+ * This file is part of grvslib.
+ *
+ * grvslib is free software: you can redistribute it and/or modify it under the
+ * terms of version 3 of the GNU General Public License as published by the Free
+ * Software Foundation.
+ *
+ * grvslib is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * grvslib.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file A multi-producer, single-consumer queue of timestamped parameter-change events, for sample-accurate
+ *       parameter automation.
+ */
+
+#ifndef GRVSLIB_TIMESTAMPED_EVENT_QUEUE_H
+#define GRVSLIB_TIMESTAMPED_EVENT_QUEUE_H
+
+// Std C++
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// Ours.
+#include "spsc_ring.h"
+
+/**
+ * One parameter change, to take effect at sample @a m_sample_time.
+ */
+template<typename ValueType = float>
+struct timestamped_parameter_event
+{
+	std::int64_t m_sample_time;
+	std::uint32_t m_param_id;
+	ValueType m_value;
+};
+
+/**
+ * Where atomic_notifying_parameter only ever hands the consumer the latest value, this hands it every change, with
+ * the sample time it should happen at.  That lets the consumer split each block at the change points instead of
+ * applying everything at the block boundary (and getting zipper noise).
+ *
+ * Each producer thread gets its own lane (an spsc_ring), so producers never contend with each other.  Each producer
+ * must push its events in nondecreasing sample-time order.  The consumer then merges the lanes' already-sorted
+ * streams: with the handful of producers this is meant for, that's a linear scan of the lane heads per event, with no
+ * sorting and no allocation.  Events with equal times are delivered in lane order.
+ *
+ * Each drain() works on a snapshot of what the lanes held when it started: one acquire load per lane per block.  An
+ * event published while a drain() is running waits for the next one, which keeps every drain()'s output in time
+ * order even while producers are pushing.
+ *
+ * Producers should prefer push_batch(), which publishes a whole batch with one release store.
+ *
+ * Events older than the block being processed (i.e. that arrived late) are delivered at the start of the block.
+ *
+ * @tparam ValueType  Type of the parameter values.
+ */
+template<typename ValueType = float>
+class timestamped_event_queue
+{
+public:
+	using event_type = timestamped_parameter_event<ValueType>;
+
+	/**
+	 * The producer end of one lane.  Only one thread may push to a given lane.
+	 */
+	class producer_lane
+	{
+	public:
+		explicit producer_lane(std::size_t capacity) : m_ring(capacity) {}
+
+		/// @return false if the lane is full.
+		bool push(const event_type& event) { return m_ring.try_push(event); }
+
+		/// @return The number of events queued, which is less than @p count if the lane filled up.
+		std::size_t push_batch(const event_type* events, std::size_t count) { return m_ring.try_push_n(events, count); }
+
+	private:
+		friend class timestamped_event_queue;
+		spsc_ring<event_type> m_ring;
+		/// Consumer-only: how many of this lane's events the current drain() may still take.
+		std::size_t m_num_in_snapshot {0};
+	};
+
+	/**
+	 * @param num_producers  Number of producer lanes.
+	 * @param lane_capacity  Minimum number of events each lane can hold.
+	 */
+	timestamped_event_queue(std::size_t num_producers, std::size_t lane_capacity)
+	{
+		m_lanes.reserve(num_producers);
+		for(std::size_t i = 0; i < num_producers; ++i)
+		{
+			m_lanes.push_back(std::make_unique<producer_lane>(lane_capacity));
+		}
+	}
+
+	/// The lane for producer number @p index.  Hand each producer thread its own.
+	producer_lane& producer(std::size_t index) { return *m_lanes[index]; }
+
+	std::size_t num_producers() const noexcept { return m_lanes.size(); }
+
+	/**
+	 * Consumer: deliver every queued event with a sample time before @p block_end, in time order, as
+	 * on_event(const event_type&).
+	 *
+	 * @return The number of events delivered.
+	 */
+	template<typename EventHandler>
+	std::size_t drain(std::int64_t block_end, EventHandler&& on_event)
+	{
+		for(auto& lane : m_lanes)
+		{
+			lane->m_num_in_snapshot = lane->m_ring.read_available();
+		}
+
+		std::size_t num_delivered = 0;
+		while(true)
+		{
+			event_type* earliest = nullptr;
+			producer_lane* earliest_lane = nullptr;
+			for(auto& lane : m_lanes)
+			{
+				event_type* e = lane->m_num_in_snapshot != 0 ? lane->m_ring.front() : nullptr;
+				if(e != nullptr && e->m_sample_time < block_end
+					&& (earliest == nullptr || e->m_sample_time < earliest->m_sample_time))
+				{
+					earliest = e;
+					earliest_lane = lane.get();
+				}
+			}
+			if(earliest == nullptr)
+			{
+				return num_delivered;
+			}
+			on_event(static_cast<const event_type&>(*earliest));
+			earliest_lane->m_ring.pop();
+			earliest_lane->m_num_in_snapshot--;
+			++num_delivered;
+		}
+	}
+
+	/**
+	 * Consumer: process the block of @p block_length samples starting at sample @p block_start, split at the events
+	 * which fall in it.  Calls:
+	 *
+	 * - on_segment(offset, length) for each run of samples with no parameter changes, and
+	 * - on_event(const event_type&, offset) for each event, between the segments before and after it.
+	 *
+	 * @a offset is relative to @p block_start.  The segments exactly tile the block.
+	 */
+	template<typename EventHandler, typename SegmentHandler>
+	void process_block(std::int64_t block_start, std::uint32_t block_length, EventHandler&& on_event,
+					   SegmentHandler&& on_segment)
+	{
+		const std::int64_t block_end = block_start + block_length;
+		std::int64_t cursor = block_start;
+		drain(block_end, [&](const event_type& event){
+			const std::int64_t at = event.m_sample_time > block_start ? event.m_sample_time : block_start;
+			if(at > cursor)
+			{
+				on_segment(static_cast<std::uint32_t>(cursor - block_start), static_cast<std::uint32_t>(at - cursor));
+				cursor = at;
+			}
+			on_event(event, static_cast<std::uint32_t>(at - block_start));
+		});
+		if(cursor < block_end)
+		{
+			on_segment(static_cast<std::uint32_t>(cursor - block_start), static_cast<std::uint32_t>(block_end - cursor));
+		}
+	}
+
+private:
+	std::vector<std::unique_ptr<producer_lane>> m_lanes;
+};
+
+#endif //GRVSLIB_TIMESTAMPED_EVENT_QUEUE_H
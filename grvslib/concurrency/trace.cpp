@@ -0,0 +1,270 @@
+/*
+ * Copyright 2024 Gary R. Van Sickle (grvs@users.sourceforge.net).
+ *
+ * This file is part of grvslib.
+ *
+ * grvslib is free software: you can redistribute it and/or modify it under the
+ * terms of version 3 of the GNU General Public License as published by the Free
+ * Software Foundation.
+ *
+ * grvslib is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * grvslib.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "trace.h"
+
+// Std C++
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+
+namespace grvslib::trace
+{
+
+namespace
+{
+
+/// Every registered thread buffer, for the drainer to find.
+struct buffer_registry
+{
+	std::mutex m_mutex;
+	std::vector<std::shared_ptr<thread_buffer>> m_buffers;
+	std::uint32_t m_next_thread_id {1};
+};
+
+buffer_registry& registry()
+{
+	static buffer_registry s_registry;
+	return s_registry;
+}
+
+/// Lets the drainer know when a registered thread has exited.
+struct thread_exit_marker
+{
+	std::shared_ptr<thread_buffer> m_buffer;
+
+	~thread_exit_marker()
+	{
+		if(m_buffer)
+		{
+			t_this_thread_buffer = nullptr;
+			m_buffer->m_thread_exited.store(true, std::memory_order_release);
+		}
+	}
+};
+
+thread_local thread_exit_marker t_exit_marker;
+
+void append_json_string(std::string& out, const char* s)
+{
+	out += '"';
+	for(; s != nullptr && *s != '\0'; ++s)
+	{
+		switch(*s)
+		{
+			case '"': out += "\\\""; break;
+			case '\\': out += "\\\\"; break;
+			case '\n': out += "\\n"; break;
+			default:
+				if(static_cast<unsigned char>(*s) < 0x20)
+				{
+					char buf[8];
+					std::snprintf(buf, sizeof(buf), "\\u%04x", static_cast<unsigned>(*s));
+					out += buf;
+				}
+				else
+				{
+					out += *s;
+				}
+		}
+	}
+	out += '"';
+}
+
+}
+
+thread_buffer* register_this_thread(const char* thread_name, std::size_t capacity)
+{
+	if(t_this_thread_buffer != nullptr)
+	{
+		return t_this_thread_buffer;
+	}
+
+	auto& reg = registry();
+	std::shared_ptr<thread_buffer> buffer;
+	{
+		std::lock_guard<std::mutex> lock(reg.m_mutex);
+		std::uint32_t id = reg.m_next_thread_id++;
+		std::string name = thread_name != nullptr ? std::string(thread_name) : "thread " + std::to_string(id);
+		buffer = std::make_shared<thread_buffer>(id, std::move(name), capacity);
+		reg.m_buffers.push_back(buffer);
+	}
+	t_exit_marker.m_buffer = buffer;
+	t_this_thread_buffer = buffer.get();
+	return t_this_thread_buffer;
+}
+
+trace_session::trace_session()
+	: m_start_ticks(now()), m_start_time(std::chrono::steady_clock::now())
+{
+}
+
+trace_session::~trace_session()
+{
+	stop();
+}
+
+void trace_session::start(std::chrono::milliseconds period)
+{
+	if(m_drainer.joinable())
+	{
+		return;
+	}
+	m_stop.store(false);
+	m_drainer = std::thread([this, period](){
+		while(!m_stop.load())
+		{
+			drain();
+			std::this_thread::sleep_for(period);
+		}
+	});
+}
+
+void trace_session::stop()
+{
+	if(m_drainer.joinable())
+	{
+		m_stop.store(true);
+		m_drainer.join();
+	}
+	drain();
+}
+
+std::size_t trace_session::drain()
+{
+	auto& reg = registry();
+	std::vector<std::shared_ptr<thread_buffer>> buffers;
+	{
+		std::lock_guard<std::mutex> lock(reg.m_mutex);
+		buffers = reg.m_buffers;
+	}
+
+	std::size_t num_drained = 0;
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_num_dropped += g_num_dropped_unregistered.exchange(0, std::memory_order_relaxed);
+	for(auto& buffer : buffers)
+	{
+		// Read the exit flag first, so that if it's set we're sure to drain everything the thread recorded.
+		bool exited = buffer->m_thread_exited.load(std::memory_order_acquire);
+
+		auto known = std::find_if(m_thread_names.begin(), m_thread_names.end(),
+			[&](const auto& p){ return p.first == buffer->m_thread_id; });
+		if(known == m_thread_names.end())
+		{
+			m_thread_names.emplace_back(buffer->m_thread_id, buffer->m_thread_name);
+		}
+
+		for(std::size_t n = buffer->m_ring.read_available(); n != 0; --n)
+		{
+			m_events.push_back({*buffer->m_ring.front(), buffer->m_thread_id});
+			buffer->m_ring.pop();
+			++num_drained;
+		}
+		m_num_dropped += buffer->m_num_dropped.exchange(0, std::memory_order_relaxed);
+
+		if(exited)
+		{
+			std::lock_guard<std::mutex> reg_lock(reg.m_mutex);
+			reg.m_buffers.erase(std::remove(reg.m_buffers.begin(), reg.m_buffers.end(), buffer), reg.m_buffers.end());
+		}
+	}
+	return num_drained;
+}
+
+std::uint64_t trace_session::num_dropped() const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_num_dropped;
+}
+
+std::size_t trace_session::size() const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_events.size();
+}
+
+std::string trace_session::chrome_json() const
+{
+	// Calibrate timestamp ticks against steady_clock over the life of the session.  Make sure that's long enough to
+	// give a usable ratio.
+	auto elapsed = std::chrono::steady_clock::now() - m_start_time;
+	if(elapsed < std::chrono::milliseconds(10))
+	{
+		std::this_thread::sleep_for(std::chrono::milliseconds(10) - elapsed);
+	}
+	const std::uint64_t end_ticks = now();
+	const double elapsed_us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - m_start_time).count();
+	const double ticks_per_us = static_cast<double>(end_ticks - m_start_ticks) / elapsed_us;
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+	std::string out = "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n";
+	bool first = true;
+	char buf[128];
+	for(const auto& [id, name] : m_thread_names)
+	{
+		out += first ? "" : ",\n";
+		first = false;
+		std::snprintf(buf, sizeof(buf), "{\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"name\":\"thread_name\",\"args\":{\"name\":",
+					  static_cast<unsigned>(id));
+		out += buf;
+		append_json_string(out, name.c_str());
+		out += "}}";
+	}
+	for(const auto& ce : m_events)
+	{
+		const auto& e = ce.m_event;
+		const double ts = static_cast<double>(static_cast<std::int64_t>(e.m_timestamp - m_start_ticks)) / ticks_per_us;
+		out += first ? "" : ",\n";
+		first = false;
+		out += "{\"name\":";
+		append_json_string(out, e.m_name);
+		std::snprintf(buf, sizeof(buf), ",\"ph\":\"%c\",\"ts\":%.3f,\"pid\":1,\"tid\":%u", static_cast<char>(e.m_phase), ts,
+					  static_cast<unsigned>(ce.m_thread_id));
+		out += buf;
+		if(e.m_phase == phase::instant)
+		{
+			out += ",\"s\":\"t\"";
+		}
+		if(e.m_phase == phase::counter)
+		{
+			out += ",\"args\":{";
+			append_json_string(out, e.m_name);
+			out += ':' + std::to_string(e.m_arg) + '}';
+		}
+		else if(e.m_arg != 0)
+		{
+			out += ",\"args\":{\"arg\":" + std::to_string(e.m_arg) + '}';
+		}
+		out += '}';
+	}
+	out += "\n]}\n";
+	return out;
+}
+
+bool trace_session::write_chrome_json(const std::string& path) const
+{
+	std::ofstream file(path, std::ios::binary | std::ios::trunc);
+	if(!file)
+	{
+		return false;
+	}
+	file << chrome_json();
+	return static_cast<bool>(file);
+}
+
+}
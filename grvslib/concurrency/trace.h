@@ -0,0 +1,229 @@
+/*
+ * Copyright 2024 Gary R. Van Sickle (grvs@users.sourceforge.net).
+ *
+ * This file is part of grvslib.
+ *
+ * grvslib is free software: you can redistribute it and/or modify it under the
+ * terms of version 3 of the GNU General Public License as published by the Free
+ * Software Foundation.
+ *
+ * grvslib is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * grvslib.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file A low-overhead, per-thread event trace recorder, with Chrome trace JSON export.
+ *
+ * Each thread records fixed-size events, stamped with the CPU timestamp counter where there is one, into its own
+ * spsc_ring.  Recording never locks or allocates once the thread is registered.  A trace_session drains the rings
+ * from a background thread and writes the result as Chrome trace-event JSON, which chrome://tracing and the Perfetto
+ * UI (ui.perfetto.dev) both load.
+ *
+ * The instrumentation in the other concurrency primitives is compiled in only if GRVSLIB_ENABLE_TRACING is defined to
+ * nonzero (the CMake option of the same name does that).  The recorder itself is always available for your own code.
+ */
+
+#ifndef GRVSLIB_TRACE_H
+#define GRVSLIB_TRACE_H
+
+// Std C++
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#define GRVSLIB_HAVE_RDTSC 1
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define GRVSLIB_HAVE_RDTSC 1
+#endif
+
+// Ours.
+#include "spsc_ring.h"
+
+#ifndef GRVSLIB_ENABLE_TRACING
+#define GRVSLIB_ENABLE_TRACING 0
+#endif
+
+namespace grvslib::trace
+{
+
+/// True if the primitives are instrumented.
+constexpr static bool enabled = (GRVSLIB_ENABLE_TRACING != 0);
+
+/// Chrome trace-event phases we record.
+enum class phase : char
+{
+	begin = 'B',
+	end = 'E',
+	instant = 'i',
+	counter = 'C',
+};
+
+/// One recorded event.  @a m_name must point to a string which outlives the trace_session, e.g. a literal.
+struct event
+{
+	std::uint64_t m_timestamp;
+	const char* m_name;
+	std::uint64_t m_arg;
+	phase m_phase;
+};
+
+/// The raw timestamp: the TSC where we have one, otherwise steady_clock nanoseconds.
+inline std::uint64_t now() noexcept
+{
+#ifdef GRVSLIB_HAVE_RDTSC
+	return __rdtsc();
+#else
+	return static_cast<std::uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+#endif
+}
+
+/**
+ * A thread's event buffer.  The owning thread is the producer, the trace_session's drainer the consumer.
+ */
+class thread_buffer
+{
+public:
+	thread_buffer(std::uint32_t thread_id, std::string thread_name, std::size_t capacity)
+		: m_ring(capacity), m_thread_id(thread_id), m_thread_name(std::move(thread_name)) {}
+
+	void push(const event& e) noexcept
+	{
+		if(!m_ring.try_push(e))
+		{
+			m_num_dropped.fetch_add(1, std::memory_order_relaxed);
+		}
+	}
+
+	spsc_ring<event> m_ring;
+	const std::uint32_t m_thread_id;
+	const std::string m_thread_name;
+	/// Events lost because the drainer didn't keep up.
+	std::atomic<std::uint64_t> m_num_dropped {0};
+	/// Set when the owning thread exits, so the buffer can be dropped once drained.
+	std::atomic<bool> m_thread_exited {false};
+};
+
+/// Default per-thread buffer capacity, in events.
+constexpr static std::size_t default_thread_buffer_capacity = 16384;
+
+/// This thread's buffer, or null if it hasn't been registered yet.
+inline thread_local thread_buffer* t_this_thread_buffer = nullptr;
+
+/// Events dropped because the recording thread had no buffer.
+inline std::atomic<std::uint64_t> g_num_dropped_unregistered {0};
+
+/**
+ * Give this thread a trace buffer.  This allocates and takes a lock, so RT threads should call it once when they
+ * start, before they go real-time.  Events recorded by threads which haven't are dropped.  Calling it again is a
+ * no-op.
+ *
+ * @param thread_name  Name to show for this thread's track in the trace viewer.
+ * @param capacity     Minimum number of events the buffer can hold between drains.
+ */
+thread_buffer* register_this_thread(const char* thread_name = nullptr,
+									std::size_t capacity = default_thread_buffer_capacity);
+
+/// Record an event on the calling thread.  Counted as dropped if the thread hasn't called register_this_thread().
+inline void record(const char* name, phase ph, std::uint64_t arg = 0) noexcept
+{
+	thread_buffer* buffer = t_this_thread_buffer;
+	if(buffer == nullptr)
+	{
+		g_num_dropped_unregistered.fetch_add(1, std::memory_order_relaxed);
+		return;
+	}
+	buffer->push(event{now(), name, arg, ph});
+}
+
+/// Record an instantaneous event.
+inline void instant(const char* name, std::uint64_t arg = 0) noexcept { record(name, phase::instant, arg); }
+
+/// Record a counter sample, shown as a graph track.
+inline void counter(const char* name, std::uint64_t value) noexcept { record(name, phase::counter, value); }
+
+/**
+ * Records a begin event on construction and the matching end event on destruction.
+ */
+class scope
+{
+public:
+	explicit scope(const char* name) noexcept : m_name(name) { record(m_name, phase::begin); }
+	~scope() { record(m_name, phase::end); }
+
+	scope(const scope&) = delete;
+	scope& operator=(const scope&) = delete;
+
+private:
+	const char* m_name;
+};
+
+/**
+ * Collects the events from every thread's buffer.  Only one trace_session may drain at a time.
+ *
+ * Either call drain() yourself from a non-RT thread, or start() a background thread which does it periodically.
+ */
+class trace_session
+{
+public:
+	trace_session();
+	~trace_session();
+
+	trace_session(const trace_session&) = delete;
+	trace_session& operator=(const trace_session&) = delete;
+
+	/// Start a background thread which calls drain() every @p period.
+	void start(std::chrono::milliseconds period = std::chrono::milliseconds(10));
+
+	/// Stop the background thread, if running, and do a final drain().
+	void stop();
+
+	/// Move all currently-buffered events into this session.  @return the number of events moved.
+	std::size_t drain();
+
+	/// Total events dropped on full thread buffers or by unregistered threads, over all threads.
+	std::uint64_t num_dropped() const;
+
+	/// Number of events collected so far.
+	std::size_t size() const;
+
+	/// The collected events as a Chrome trace-event JSON document.
+	std::string chrome_json() const;
+
+	/// Write chrome_json() to @p path.  @return false on I/O failure.
+	bool write_chrome_json(const std::string& path) const;
+
+private:
+	struct collected_event
+	{
+		event m_event;
+		std::uint32_t m_thread_id;
+	};
+
+	mutable std::mutex m_mutex;
+	std::vector<collected_event> m_events;
+	std::vector<std::pair<std::uint32_t, std::string>> m_thread_names;
+	std::uint64_t m_num_dropped {0};
+
+	std::uint64_t m_start_ticks;
+	std::chrono::steady_clock::time_point m_start_time;
+
+	std::thread m_drainer;
+	std::atomic<bool> m_stop {false};
+};
+
+}
+
+#endif //GRVSLIB_TRACE_H
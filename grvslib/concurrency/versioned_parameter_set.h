@@ -0,0 +1,211 @@
+/*
+ * Copyright 2024 Gary R. Van Sickle (grvs@users.sourceforge.net).
+ *
+ * This file is part of grvslib.
+ *
+ * grvslib is free software: you can redistribute it and/or modify it under the
+ * terms of version 3 of the GNU General Public License as published by the Free
+ * Software Foundation.
+ *
+ * grvslib is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * grvslib.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file Publishing a whole set of parameters at once, so the RT thread never sees it half-updated.
+ */
+
+#ifndef GRVSLIB_VERSIONED_PARAMETER_SET_H
+#define GRVSLIB_VERSIONED_PARAMETER_SET_H
+
+// Std C++
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <type_traits>
+#include <utility>
+
+// Ours.
+#include "cache_line.h"
+
+/**
+ * A set of parameters which must change together (filter type, frequency and Q, say), published as a unit.
+ *
+ * Separate atomic_notifying_parameter instances can each be picked up in a different block, so the RT thread can run
+ * a block with the new type but the old Q.  Here the whole set is one @p SetType, and producers change it in
+ * transactions: begin_transaction(), change any number of fields, commit().  Each commit publishes a complete new
+ * version of the set, and the RT thread switches from one complete version to the next.
+ *
+ * It's a triple buffer.  The consumer owns one copy of the set (the current one), the producers another (the one
+ * being published next), and the third is the most recently published one, held in an atomic "middle" index along
+ * with a "new" bit.  commit() fills the producers' copy and exchanges it into the middle; update() checks the new bit
+ * and, if it's set, exchanges the middle for the consumer's copy.  So the consumer is wait-free: one atomic load when
+ * nothing has changed, one exchange when something has.  It never copies, and never sees anything but whole versions.
+ * If several commits happen between two update()s, it goes straight to the latest.
+ *
+ * Producers serialize on a mutex, and each keeps a staging copy, so a transaction can be abandoned without anybody
+ * seeing it.
+ *
+ * @tparam SetType  Any copyable type; usually a struct of the parameters.
+ */
+template<typename SetType>
+class versioned_parameter_set
+{
+	static_assert(std::is_copy_assignable_v<SetType>, "versioned_parameter_set needs a copy-assignable SetType");
+
+public:
+	/**
+	 * A producer's pending changes.  Holds the producers' lock from begin_transaction() until commit() or
+	 * destruction, so keep it short-lived, and off the RT thread.  Destroying it without committing discards the
+	 * changes.
+	 */
+	class transaction
+	{
+	public:
+		transaction(transaction&&) noexcept = default;
+		transaction& operator=(transaction&&) = delete;
+
+		~transaction()
+		{
+			if(m_lock.owns_lock())
+			{
+				// Abandoned: put the staging copy back the way it was.
+				m_owner->m_staging = m_owner->m_committed;
+			}
+		}
+
+		/// The set as of the last commit plus this transaction's changes so far.
+		SetType& operator*() noexcept { return m_owner->m_staging; }
+		SetType* operator->() noexcept { return &m_owner->m_staging; }
+
+		/// Stage a change to one field.  Same as (*this)->field = value.
+		template<typename FieldType, typename ValueType>
+		transaction& set(FieldType SetType::* field, ValueType&& value)
+		{
+			m_owner->m_staging.*field = std::forward<ValueType>(value);
+			return *this;
+		}
+
+		/// Publish the changes as the next version, and release the producers' lock.
+		/// @return The new version number.
+		std::uint64_t commit()
+		{
+			const std::uint64_t version = m_owner->publish();
+			m_lock.unlock();
+			return version;
+		}
+
+	private:
+		friend class versioned_parameter_set;
+
+		explicit transaction(versioned_parameter_set* owner) : m_owner(owner), m_lock(owner->m_producer_mutex) {}
+
+		versioned_parameter_set* m_owner;
+		std::unique_lock<std::mutex> m_lock;
+	};
+
+	explicit versioned_parameter_set(const SetType& initial = SetType{})
+		: m_committed(initial), m_staging(initial), m_slots{{initial, 0}, {initial, 0}, {initial, 0}}
+	{
+	}
+
+	versioned_parameter_set(const versioned_parameter_set&) = delete;
+	versioned_parameter_set& operator=(const versioned_parameter_set&) = delete;
+
+	/// @name Producers.  Any thread but the RT one.
+	///@{
+
+	/// Start changing the set.  Blocks while another producer has a transaction open.
+	transaction begin_transaction() { return transaction(this); }
+
+	/// Replace the whole set in one transaction.  @return The new version number.
+	std::uint64_t store(const SetType& value)
+	{
+		auto t = begin_transaction();
+		*t = value;
+		return t.commit();
+	}
+
+	///@}
+
+	/// @name Consumer.  One thread.
+	///@{
+
+	/**
+	 * Switch current() to the latest committed version, if there's a newer one.  Wait-free.
+	 * @return true if current() changed.
+	 */
+	bool update() noexcept
+	{
+		if((m_middle.load(std::memory_order_relaxed) & c_new) == 0)
+		{
+			return false;
+		}
+		// Acquire pairs with commit()'s release, making the version we're taking visible.  Release hands the
+		// producers back the one we're done with.
+		m_current = m_middle.exchange(m_current, std::memory_order_acq_rel) & c_index;
+		return true;
+	}
+
+	/// The set as of the last update().  Valid until the next update().
+	const SetType& current() const noexcept { return m_slots[m_current].m_value; }
+
+	/// current()'s version: 0 for the initial set, then 1, 2, ... per commit().
+	std::uint64_t current_version() const noexcept { return m_slots[m_current].m_version; }
+
+	/// update(), and if there was a new version copy it to @p out.  @return Whether there was.
+	bool load_if_changed(SetType* out)
+	{
+		if(!update())
+		{
+			return false;
+		}
+		*out = current();
+		return true;
+	}
+
+	///@}
+
+private:
+	static constexpr std::uint32_t c_index = 3;
+	static constexpr std::uint32_t c_new = 4;
+
+	/// Called with the producers' lock held.
+	std::uint64_t publish()
+	{
+		m_committed = m_staging;
+		const std::uint64_t version = ++m_version;
+		slot& s = m_slots[m_producer_slot];
+		s.m_value = m_staging;
+		s.m_version = version;
+		m_producer_slot = m_middle.exchange(m_producer_slot | c_new, std::memory_order_acq_rel) & c_index;
+		return version;
+	}
+
+	struct alignas(grvslib::impl::cache_line_size) slot
+	{
+		SetType m_value;
+		std::uint64_t m_version;
+	};
+
+	/// Producers' state, all guarded by m_producer_mutex.
+	std::mutex m_producer_mutex;
+	SetType m_committed;
+	SetType m_staging;
+	std::uint64_t m_version {0};
+	std::uint32_t m_producer_slot {2};
+
+	/// The most recently published slot's index, plus c_new if the consumer hasn't taken it yet.
+	alignas(grvslib::impl::cache_line_size) std::atomic<std::uint32_t> m_middle {1};
+
+	/// The consumer's slot.  Only the consumer touches this.
+	alignas(grvslib::impl::cache_line_size) std::uint32_t m_current {0};
+
+	slot m_slots[3];
+};
+
+#endif //GRVSLIB_VERSIONED_PARAMETER_SET_H
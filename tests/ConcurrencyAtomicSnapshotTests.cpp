@@ -0,0 +1,120 @@
+/*
+ * Copyright 2024 Gary R. Van Sickle (grvs@users.sourceforge.net).
+ *
+ * This file is part of grvslib.
+ *
+ * grvslib is free software: you can redistribute it and/or modify it under the
+ * terms of version 3 of the GNU General Public License as published by the Free
+ * Software Foundation.
+ *
+ * grvslib is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * grvslib.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <gtest/gtest.h>
+
+// Std C++
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+// Ours.
+#include <grvslib/concurrency/atomic_snapshot.h>
+#include "realtime_stress.h"
+
+namespace
+{
+
+/// Counts live instances, so we can check nothing leaks or gets deleted twice.
+struct Config
+{
+	static inline std::atomic<int> s_num_live {0};
+
+	explicit Config(std::uint64_t version) : m_payload(grvslib::stress::checked_payload<6>::make(0, version))
+	{
+		s_num_live++;
+	}
+	Config(const Config& other) : m_payload(other.m_payload) { s_num_live++; }
+	~Config() { s_num_live--; }
+
+	grvslib::stress::checked_payload<6> m_payload;
+};
+
+}
+
+TEST(Concurrency, atomic_snapshot_basic)
+{
+	{
+		atomic_snapshot<Config> holder;
+		EXPECT_TRUE(holder.is_always_lock_free);
+		EXPECT_FALSE(holder.load());
+
+		holder.emplace(1);
+		auto s1 = holder.load();
+		ASSERT_TRUE(s1);
+		EXPECT_EQ(1, s1->m_payload.m_sequence);
+
+		holder.emplace(2);
+		auto s2 = holder.load();
+		// The old snapshot is unaffected by the update.
+		EXPECT_EQ(1, s1->m_payload.m_sequence);
+		EXPECT_EQ(2, s2->m_payload.m_sequence);
+		EXPECT_EQ(2, Config::s_num_live);
+
+		auto s1_copy = s1;
+		s1 = {};
+		EXPECT_EQ(2, Config::s_num_live);
+		s1_copy = {};
+		EXPECT_EQ(1, Config::s_num_live);
+	}
+	EXPECT_EQ(0, Config::s_num_live);
+}
+
+TEST(Concurrency, atomic_snapshot_readers_and_writers)
+{
+	constexpr int c_num_readers = 4;
+	constexpr std::uint64_t c_num_versions = 20'000;
+	{
+		atomic_snapshot<Config> holder(Config(0));
+		std::atomic<bool> done {false};
+		std::atomic<int> num_bad {0};
+
+		std::vector<std::thread> threads;
+		for(int i = 0; i < c_num_readers; ++i)
+		{
+			threads.emplace_back([&](){
+				std::uint64_t last = 0;
+				while(!done.load(std::memory_order_relaxed))
+				{
+					auto s = holder.load();
+					if(!s->m_payload.verify() || s->m_payload.m_sequence < last)
+					{
+						num_bad++;
+					}
+					last = s->m_payload.m_sequence;
+				}
+			});
+		}
+		// One writer, so readers should never see the version go backwards.
+		std::thread writer([&](){
+			for(std::uint64_t v = 1; v <= c_num_versions; ++v)
+			{
+				holder.emplace(v);
+			}
+		});
+		writer.join();
+		done = true;
+		for(auto& t : threads)
+		{
+			t.join();
+		}
+		EXPECT_EQ(0, num_bad);
+		EXPECT_EQ(c_num_versions, holder.load()->m_payload.m_sequence);
+	}
+	EXPECT_EQ(0, Config::s_num_live);
+}
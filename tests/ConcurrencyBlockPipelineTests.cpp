@@ -0,0 +1,182 @@
+/*
+ * Copyright 2024 Gary R. Van Sickle (grvs@users.sourceforge.net).
+ *
+ * This file is part of grvslib.
+ *
+ * grvslib is free software: you can redistribute it and/or modify it under the
+ * terms of version 3 of the GNU General Public License as published by the Free
+ * Software Foundation.
+ *
+ * grvslib is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * grvslib.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <gtest/gtest.h>
+
+// Std C++
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+// Ours.
+#include <grvslib/concurrency/block_pipeline.h>
+
+namespace
+{
+
+/// Source and sink on this thread: push @p num_blocks blocks whose samples are all their sequence number, and call
+/// @p check on each one which comes out.
+template<typename Check>
+void pump(block_pipeline& pipeline, std::uint64_t num_blocks, Check check)
+{
+	std::uint64_t num_in {0}, num_out {0};
+	while(num_out < num_blocks)
+	{
+		bool idle = true;
+		if(num_in < num_blocks)
+		{
+			if(block_pipeline::block* b = pipeline.try_reserve_input(); b != nullptr)
+			{
+				b->m_sequence = num_in;
+				for(auto& s : b->m_samples)
+				{
+					s = static_cast<float>(num_in);
+				}
+				pipeline.commit_input();
+				++num_in;
+				idle = false;
+			}
+		}
+		if(const block_pipeline::block* b = pipeline.try_front_output(); b != nullptr)
+		{
+			check(num_out, *b);
+			pipeline.pop_output();
+			++num_out;
+			idle = false;
+		}
+		if(idle)
+		{
+			std::this_thread::yield();
+		}
+	}
+}
+
+}
+
+TEST(Concurrency, block_pipeline_preserves_order)
+{
+	block_pipeline::options opts;
+	opts.m_block_samples = 64;
+	opts.m_blocks_per_link = 2;
+	opts.m_spin_iterations = 100;
+	block_pipeline pipeline(opts);
+
+	// Each stage adds one to every sample.
+	constexpr int c_num_stages = 4;
+	for(int i = 0; i < c_num_stages; ++i)
+	{
+		pipeline.add_stage([](const block_pipeline::block& in, block_pipeline::block& out){
+			for(std::size_t s = 0; s < in.m_samples.size(); ++s)
+			{
+				out.m_samples[s] = in.m_samples[s] + 1.0f;
+			}
+		}, "stage " + std::to_string(i));
+	}
+	pipeline.start();
+	EXPECT_THROW(pipeline.add_stage([](const block_pipeline::block&, block_pipeline::block&){}), std::logic_error);
+
+	constexpr std::uint64_t c_num_blocks = 2000;
+	int num_bad {0};
+	pump(pipeline, c_num_blocks, [&](std::uint64_t expected, const block_pipeline::block& b){
+		if(b.m_sequence != expected || b.m_samples.size() != 64
+		   || b.m_samples.front() != static_cast<float>(expected + c_num_stages)
+		   || b.m_samples.back() != static_cast<float>(expected + c_num_stages))
+		{
+			++num_bad;
+		}
+	});
+	EXPECT_EQ(0, num_bad);
+
+	pipeline.stop();
+	for(int i = 0; i < c_num_stages; ++i)
+	{
+		EXPECT_EQ(c_num_blocks, pipeline.blocks_processed(i));
+	}
+	EXPECT_EQ("stage 2", pipeline.name(2));
+}
+
+#if __cpp_lib_atomic_flag_test >= 201907L
+TEST(Concurrency, block_pipeline_parameter_stage)
+{
+	block_pipeline::options opts;
+	opts.m_block_samples = 8;
+	opts.m_spin_iterations = 100;
+	block_pipeline pipeline(opts);
+
+	atomic_notifying_parameter<float> gain;
+	pipeline.add_stage(gain, 1.0f, [](const block_pipeline::block& in, block_pipeline::block& out, float g){
+		for(std::size_t s = 0; s < in.m_samples.size(); ++s)
+		{
+			out.m_samples[s] = in.m_samples[s] * g;
+		}
+	});
+	pipeline.start();
+
+	// Gain is 1 until we change it, and then it's 2 from some block on.
+	std::uint64_t first_doubled = ~std::uint64_t(0);
+	int num_bad {0};
+	pump(pipeline, 1000, [&](std::uint64_t n, const block_pipeline::block& b){
+		if(n == 100)
+		{
+			gain.store_and_set(2.0f);
+		}
+		const float x = static_cast<float>(n);
+		if(b.m_samples[0] == 2.0f * x && n != 0)
+		{
+			if(first_doubled == ~std::uint64_t(0))
+			{
+				first_doubled = n;
+			}
+		}
+		else if(b.m_samples[0] != x || first_doubled != ~std::uint64_t(0))
+		{
+			++num_bad;
+		}
+	});
+	EXPECT_EQ(0, num_bad);
+	EXPECT_GT(first_doubled, 100u);
+	EXPECT_NE(~std::uint64_t(0), first_doubled);
+}
+
+TEST(Concurrency, block_pipeline_accumulating_parameter_stage)
+{
+	block_pipeline::options opts;
+	opts.m_block_samples = 8;
+	opts.m_spin_iterations = 100;
+	block_pipeline pipeline(opts);
+
+	// Nudges add up between blocks, and each one must be applied exactly once.
+	atomic_notifying_parameter<int, memory_order_policy_acq_rel, no_notification, merge_sum> nudge;
+	pipeline.add_stage(nudge, 0, [](const block_pipeline::block&, block_pipeline::block& out, int n){
+		out.m_samples[0] = static_cast<float>(n);
+	});
+	pipeline.start();
+
+	int num_nudges {0};
+	float total_applied {0.0f};
+	pump(pipeline, 1000, [&](std::uint64_t n, const block_pipeline::block& b){
+		if(n < 500 && n % 10 == 0)
+		{
+			nudge.store_and_set(1);
+			++num_nudges;
+		}
+		total_applied += b.m_samples[0];
+	});
+	EXPECT_EQ(static_cast<float>(num_nudges), total_applied);
+}
+#endif
@@ -0,0 +1,151 @@
+/*
+ * Copyright 2024 Gary R. Van Sickle (grvs@users.sourceforge.net).
+ *
+ * This file is part of grvslib.
+ *
+ * grvslib is free software: you can redistribute it and/or modify it under the
+ * terms of version 3 of the GNU General Public License as published by the Free
+ * Software Foundation.
+ *
+ * grvslib is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * grvslib.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <gtest/gtest.h>
+
+// Std C++
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <random>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+// Ours.
+#include <grvslib/concurrency/dag_executor.h>
+
+
+TEST(Concurrency, dag_executor_diamond)
+{
+	// a -> {b, c} -> d
+	dag_executor::options opts;
+	opts.m_num_workers = 2;
+	opts.m_spin_iterations = 100;
+	dag_executor dag(opts);
+
+	std::atomic<int> order {0};
+	int a_at {-1}, b_at {-1}, c_at {-1}, d_at {-1};
+	auto a = dag.add_node([&](){ a_at = order++; }, "a");
+	auto b = dag.add_node([&](){ b_at = order++; }, "b");
+	auto c = dag.add_node([&](){ c_at = order++; }, "c");
+	auto d = dag.add_node([&](){ d_at = order++; }, "d");
+	dag.add_edge(a, b);
+	dag.add_edge(a, c);
+	dag.add_edge(b, d);
+	dag.add_edge(c, d);
+	dag.finalize();
+	EXPECT_THROW(dag.add_node([](){}), std::logic_error);
+
+	for(int block = 0; block < 50; ++block)
+	{
+		order = 0;
+		dag.run();
+		EXPECT_EQ(0, a_at);
+		EXPECT_LT(a_at, b_at);
+		EXPECT_LT(a_at, c_at);
+		EXPECT_EQ(3, d_at);
+	}
+	EXPECT_EQ("c", dag.name(c));
+}
+
+TEST(Concurrency, dag_executor_random_graph)
+{
+	constexpr std::size_t num_nodes = 200;
+	constexpr int num_blocks = 100;
+
+	dag_executor::options opts;
+	opts.m_num_workers = 3;
+	opts.m_spin_iterations = 100;
+	dag_executor dag(opts);
+
+	// Each node checks that all its predecessors have run in this block before it did.
+	std::vector<std::vector<dag_executor::node_id>> predecessors(num_nodes);
+	std::vector<int> ran_in_block(num_nodes, -1);
+	std::atomic<int> violations {0};
+	int block = 0;
+
+	for(std::size_t i = 0; i < num_nodes; ++i)
+	{
+		dag.add_node([&, i](){
+			for(auto p : predecessors[i])
+			{
+				if(ran_in_block[p] != block)
+				{
+					++violations;
+				}
+			}
+			ran_in_block[i] = block;
+		});
+	}
+	// Only add edges from lower to higher indices, so it's acyclic by construction.
+	std::mt19937 rng(12345);
+	for(std::size_t j = 1; j < num_nodes; ++j)
+	{
+		std::uniform_int_distribution<std::size_t> pick(0, j - 1);
+		for(int e = 0; e < 3; ++e)
+		{
+			auto i = static_cast<dag_executor::node_id>(pick(rng));
+			dag.add_edge(i, static_cast<dag_executor::node_id>(j));
+			predecessors[j].push_back(i);
+		}
+	}
+	dag.finalize();
+
+	for(block = 0; block < num_blocks; ++block)
+	{
+		dag.run();
+		for(std::size_t i = 0; i < num_nodes; ++i)
+		{
+			ASSERT_EQ(block, ran_in_block[i]) << "node " << i;
+		}
+	}
+	EXPECT_EQ(0, violations.load());
+}
+
+TEST(Concurrency, dag_executor_critical_path)
+{
+	// A long chain x -> y -> z next to a short independent node w.
+	dag_executor dag;
+	auto sleep_ms = [](int ms){ return [ms](){ std::this_thread::sleep_for(std::chrono::milliseconds(ms)); }; };
+	auto x = dag.add_node(sleep_ms(2), "x");
+	auto y = dag.add_node(sleep_ms(2), "y");
+	auto z = dag.add_node(sleep_ms(2), "z");
+	auto w = dag.add_node(sleep_ms(1), "w");
+	dag.add_edge(x, y);
+	dag.add_edge(y, z);
+	dag.run();
+
+	std::uint64_t length_ns {0};
+	auto path = dag.critical_path(&length_ns);
+	EXPECT_EQ((std::vector<dag_executor::node_id>{x, y, z}), path);
+	EXPECT_GE(length_ns, 6'000'000u);
+	EXPECT_LE(dag.timing(y).m_end_ns, dag.timing(z).m_start_ns);
+	EXPECT_EQ(0u, dag.timing(w).m_worker);
+}
+
+TEST(Concurrency, dag_executor_rejects_cycles)
+{
+	dag_executor dag;
+	auto a = dag.add_node([](){});
+	auto b = dag.add_node([](){});
+	auto c = dag.add_node([](){});
+	dag.add_edge(a, b);
+	dag.add_edge(b, c);
+	dag.add_edge(c, b);
+	EXPECT_THROW(dag.finalize(), std::logic_error);
+}
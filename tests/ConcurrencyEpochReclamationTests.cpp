@@ -0,0 +1,160 @@
+/*
+ * Copyright 2024 Gary R. Van Sickle (grvs@users.sourceforge.net).
+ *
+ * This file is part of grvslib.
+ *
+ * grvslib is free software: you can redistribute it and/or modify it under the
+ * terms of version 3 of the GNU General Public License as published by the Free
+ * Software Foundation.
+ *
+ * grvslib is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * grvslib.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <gtest/gtest.h>
+
+// Std C++
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+
+// Ours.
+#include <grvslib/concurrency/epoch_reclamation.h>
+
+namespace
+{
+
+/// Never actually deleted during the test, so that a reader touching a "freed" one is a checkable failure, not UB.
+struct node
+{
+	explicit node(std::uint64_t value) : m_value(value) {}
+	std::uint64_t m_value;
+	std::atomic<bool> m_freed {false};
+};
+
+void mark_freed(void* p)
+{
+	static_cast<node*>(p)->m_freed.store(true, std::memory_order_relaxed);
+}
+
+}
+
+TEST(Concurrency, epoch_domain_grace_period)
+{
+	epoch_domain domain(4, 16);
+	auto reader = domain.register_thread();
+	auto writer = domain.register_thread();
+
+	node a(1);
+	reader.enter();
+	{
+		auto g = writer.pin();
+		EXPECT_TRUE(writer.retire(&a, mark_freed));
+	}
+
+	// The reader is still in its critical section, so however often we reclaim, a survives.
+	for(int i = 0; i < 10; ++i)
+	{
+		domain.reclaim();
+	}
+	EXPECT_FALSE(a.m_freed);
+	reader.exit();
+
+	std::size_t num_freed = 0;
+	for(int i = 0; i < 4; ++i)
+	{
+		num_freed += domain.reclaim();
+	}
+	EXPECT_EQ(1u, num_freed);
+	EXPECT_TRUE(a.m_freed);
+}
+
+TEST(Concurrency, epoch_domain_limbo_full_and_slots)
+{
+	// Declared before the domain, which marks whatever is still in limbo freed when it goes.
+	std::vector<std::unique_ptr<node>> nodes;
+	epoch_domain domain(1, 2);
+	{
+		auto p = domain.register_thread();
+		EXPECT_THROW(domain.register_thread(), std::runtime_error);
+
+		auto g = p.pin();
+		bool full = false;
+		for(std::uint64_t i = 0; i < 64 && !full; ++i)
+		{
+			nodes.push_back(std::make_unique<node>(i));
+			full = !p.retire(nodes.back().get(), mark_freed);
+		}
+		EXPECT_TRUE(full);
+	}
+	// The slot is free again once its participant is gone.
+	auto p = domain.register_thread();
+}
+
+TEST(Concurrency, epoch_domain_readers_never_see_freed)
+{
+	// A writer keeps replacing a shared node and retiring the old one; readers must never see one marked freed.
+	constexpr int c_num_readers = 2;
+	constexpr std::uint64_t c_num_updates = 20'000;
+	std::vector<std::unique_ptr<node>> all_nodes;
+	all_nodes.reserve(c_num_updates + 1);
+	epoch_domain domain(c_num_readers + 1, 256);
+	all_nodes.push_back(std::make_unique<node>(0));
+	std::atomic<node*> shared {all_nodes.back().get()};
+	std::atomic<bool> done {false};
+	std::atomic<int> num_bad {0};
+
+	std::vector<std::thread> readers;
+	for(int r = 0; r < c_num_readers; ++r)
+	{
+		readers.emplace_back([&](){
+			auto me = domain.register_thread();
+			std::uint64_t last = 0;
+			while(!done.load(std::memory_order_relaxed))
+			{
+				auto g = me.pin();
+				node* n = shared.load(std::memory_order_acquire);
+				num_bad += n->m_freed.load(std::memory_order_relaxed) || n->m_value < last;
+				last = n->m_value;
+			}
+		});
+	}
+
+	domain.start_reclaimer(std::chrono::milliseconds(1));
+	{
+		auto me = domain.register_thread();
+		for(std::uint64_t i = 1; i <= c_num_updates; ++i)
+		{
+			all_nodes.push_back(std::make_unique<node>(i));
+			node* old = shared.exchange(all_nodes.back().get(), std::memory_order_acq_rel);
+			while(true)
+			{
+				{
+					auto g = me.pin();
+					if(me.retire(old, mark_freed))
+					{
+						break;
+					}
+				}
+				// Limbo full: let the reclaimer catch up, outside the critical section so the epoch can move.
+				std::this_thread::yield();
+			}
+		}
+	}
+	done = true;
+	for(auto& t : readers)
+	{
+		t.join();
+	}
+	domain.stop_reclaimer();
+
+	EXPECT_EQ(0, num_bad.load());
+	EXPECT_GT(domain.epoch(), 0u);
+}
@@ -0,0 +1,109 @@
+/*
+ * Copyright 2024 Gary R. Van Sickle (grvs@users.sourceforge.net).
+ *
+ * This file is part of grvslib.
+ *
+ * grvslib is free software: you can redistribute it and/or modify it under the
+ * terms of version 3 of the GNU General Public License as published by the Free
+ * Software Foundation.
+ *
+ * grvslib is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * grvslib.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <gtest/gtest.h>
+
+// Std C++
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <thread>
+
+// Ours.
+#include <grvslib/concurrency/eventfd_notification.h>
+
+#if defined(GRVSLIB_HAVE_EVENTFD) && __cpp_lib_atomic_flag_test >= 201907L
+
+#include <sys/epoll.h>
+
+TEST(Concurrency, eventfd_notifying_parameter_coalesces)
+{
+	eventfd_notifying_parameter<int> param;
+	auto& n = param.notification();
+	EXPECT_EQ(0, n.acknowledge());
+
+	// A burst of stores is one notification.
+	for(int i = 1; i <= 100; ++i)
+	{
+		param.store_and_set(i);
+	}
+	EXPECT_EQ(1, n.acknowledge());
+	int value {0};
+	EXPECT_TRUE(param.load_and_clear_if_set(&value));
+	EXPECT_EQ(100, value);
+	EXPECT_EQ(0, n.acknowledge());
+
+	// Once it's been consumed, the next store notifies again.
+	param.store_and_set(101);
+	EXPECT_EQ(1, n.acknowledge());
+	EXPECT_TRUE(param.load_and_clear_if_set(&value));
+	EXPECT_EQ(101, value);
+}
+
+TEST(Concurrency, eventfd_notifying_parameter_epoll_loop)
+{
+	// A non-atomic payload, so this goes through the locked path.
+	using payload = std::array<std::uint64_t, 4>;
+	constexpr std::uint64_t c_last = 2000;
+	eventfd_notifying_parameter<payload> param;
+
+	const int epfd = ::epoll_create1(EPOLL_CLOEXEC);
+	ASSERT_GE(epfd, 0);
+	epoll_event ev {};
+	ev.events = EPOLLIN;
+	ASSERT_EQ(0, ::epoll_ctl(epfd, EPOLL_CTL_ADD, param.notification().fd(), &ev));
+
+	std::thread producer([&](){
+		for(std::uint64_t i = 1; i <= c_last; ++i)
+		{
+			param.store_and_set(payload{i, i, i, i});
+			if(i % 64 == 0)
+			{
+				std::this_thread::sleep_for(std::chrono::microseconds(100));
+			}
+		}
+	});
+
+	std::uint64_t last_seen {0};
+	int num_wakeups {0}, num_bad {0};
+	while(last_seen != c_last)
+	{
+		// The producer must get to c_last well within this, so a timeout means a lost notification.
+		if(::epoll_wait(epfd, &ev, 1, 5000) != 1)
+		{
+			break;
+		}
+		++num_wakeups;
+		param.notification().acknowledge();
+		payload p {};
+		if(param.load_and_clear_if_set(&p))
+		{
+			// A store whose flag lands after we've already read its payload makes us read it again, so equal is
+			// fine; going backwards or a torn payload isn't.
+			num_bad += (p[0] < last_seen || p[3] != p[0]);
+			last_seen = p[0];
+		}
+	}
+	producer.join();
+	::close(epfd);
+
+	EXPECT_EQ(c_last, last_seen);
+	EXPECT_EQ(0, num_bad);
+	EXPECT_GT(num_wakeups, 0);
+}
+
+#endif
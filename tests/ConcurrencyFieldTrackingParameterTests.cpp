@@ -0,0 +1,228 @@
+/*
+ * Copyright 2024 Gary R. Van Sickle (grvs@users.sourceforge.net).
+ *
+ * This file is part of grvslib.
+ *
+ * grvslib is free software: you can redistribute it and/or modify it under the
+ * terms of version 3 of the GNU General Public License as published by the Free
+ * Software Foundation.
+ *
+ * grvslib is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * grvslib.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <gtest/gtest.h>
+
+// Std C++
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <thread>
+#include <tuple>
+
+// Ours.
+#include <grvslib/concurrency/field_tracking_parameter.h>
+
+namespace
+{
+
+struct eq_band
+{
+	float m_frequency {1000.0f};
+	float m_gain {0.0f};
+	float m_q {0.707f};
+	float m_pad {0.0f};
+};
+
+struct eq_settings
+{
+	std::array<eq_band, 4> m_bands {};
+	float m_output_gain {1.0f};
+	int m_bypassed {0};
+	GRVSLIB_DESCRIBE_FIELDS(eq_settings, m_bands, m_output_gain, m_bypassed)
+};
+
+}
+
+TEST(Concurrency, field_tracking_parameter_described_struct)
+{
+	static_assert(field_tracking_parameter<eq_settings>::num_fields == 3);
+
+	field_tracking_parameter<eq_settings> param;
+	eq_settings reader;
+	reader.m_output_gain = -1.0f;
+	EXPECT_FALSE(param.load_and_clear_if_set(&reader));
+	EXPECT_EQ(-1.0f, reader.m_output_gain);
+
+	// The first load copies everything, even the fields the store didn't change.
+	param.store_field<2>(1);
+	EXPECT_TRUE(param.load_and_clear_if_set(&reader));
+	EXPECT_EQ(1.0f, reader.m_output_gain);
+	EXPECT_EQ(1, reader.m_bypassed);
+	EXPECT_FALSE(param.load_and_clear_if_set(&reader));
+
+	// After that, only changed fields are copied: scribble on the reader's copy and check it survives.
+	reader.m_bands[0].m_gain = 42.0f;
+	param.store_field<1>(0.5f);
+	EXPECT_TRUE(param.load_and_clear_if_set(&reader));
+	EXPECT_EQ(0.5f, reader.m_output_gain);
+	EXPECT_EQ(42.0f, reader.m_bands[0].m_gain);
+
+	// store_and_set() diffs against the current value.
+	eq_settings s;
+	s.m_output_gain = 0.5f;
+	s.m_bypassed = 1;
+	s.m_bands[3].m_q = 2.0f;
+	reader.m_output_gain = 42.0f;
+	param.store_and_set(s);
+	EXPECT_TRUE(param.load_and_clear_if_set(&reader));
+	EXPECT_EQ(2.0f, reader.m_bands[3].m_q);
+	EXPECT_EQ(0.0f, reader.m_bands[0].m_gain);
+	EXPECT_EQ(42.0f, reader.m_output_gain);
+}
+
+TEST(Concurrency, field_tracking_parameter_tuple_protocol)
+{
+	// Each element of a std::array is its own field.
+	using bands = std::array<eq_band, 100>;
+	static_assert(field_tracking_parameter<bands>::num_fields == 100);
+
+	field_tracking_parameter<bands> param;
+	bands reader {};
+	param.store_field<70>(eq_band{440.0f, 6.0f, 1.0f, 0.0f});
+	EXPECT_TRUE(param.load_and_clear_if_set(&reader));
+	EXPECT_EQ(440.0f, reader[70].m_frequency);
+
+	reader[69].m_gain = 42.0f;
+	param.store_field<99>(eq_band{880.0f, 3.0f, 1.0f, 0.0f});
+	EXPECT_TRUE(param.load_and_clear_if_set(&reader));
+	EXPECT_EQ(880.0f, reader[99].m_frequency);
+	EXPECT_EQ(42.0f, reader[69].m_gain);
+
+	field_tracking_parameter<std::tuple<int, double>> t {{1, 2.0}};
+	std::tuple<int, double> tr;
+	t.store_field<1>(3.0);
+	EXPECT_TRUE(t.load_and_clear_if_set(&tr));
+	EXPECT_EQ(std::make_tuple(1, 3.0), tr);
+}
+
+TEST(Concurrency, field_tracking_parameter_never_torn)
+{
+	// The producer stores payloads whose fields are all derived from one number; the consumer must never see a mix.
+	using payload = std::array<std::uint64_t, 16>;
+	constexpr std::uint64_t c_num_stores = 50'000;
+	field_tracking_parameter<payload> param;
+	std::atomic<bool> done {false};
+
+	std::thread producer([&](){
+		for(std::uint64_t i = 1; i <= c_num_stores; ++i)
+		{
+			payload p;
+			for(std::size_t j = 0; j < p.size(); ++j)
+			{
+				p[j] = i * (j + 1);
+			}
+			param.store_and_set(p);
+			if(i % 64 == 0)
+			{
+				std::this_thread::yield();
+			}
+		}
+		done = true;
+	});
+
+	payload reader {};
+	int num_torn {0};
+	while(!done.load())
+	{
+		if(param.load_and_clear_if_set(&reader))
+		{
+			for(std::size_t j = 0; j < reader.size(); ++j)
+			{
+				num_torn += (reader[j] != reader[0] * (j + 1));
+			}
+		}
+	}
+	producer.join();
+	param.load_and_clear_if_set(&reader);
+
+	EXPECT_EQ(0, num_torn);
+	EXPECT_EQ(c_num_stores, reader[0]);
+	EXPECT_EQ(c_num_stores * 16, reader[15]);
+}
+
+namespace
+{
+
+/// A field whose copy can be made to hold the copier inside the parameter's lock for a while.
+struct slow_field
+{
+	static inline std::atomic<bool> s_stall_next_copy {false};
+	static inline std::atomic<bool> s_copy_in_progress {false};
+
+	slow_field() = default;
+	slow_field(const slow_field&) = default;
+	slow_field& operator=(const slow_field& other)
+	{
+		m_value = other.m_value;
+		if(s_stall_next_copy.exchange(false))
+		{
+			s_copy_in_progress = true;
+			// Long enough for the producer to give up spinning and park.
+			std::this_thread::sleep_for(std::chrono::milliseconds(200));
+		}
+		return *this;
+	}
+
+	int m_value {0};
+};
+
+struct stalling_payload
+{
+	slow_field m_slow;
+	int m_other {0};
+	GRVSLIB_DESCRIBE_FIELDS(stalling_payload, m_slow, m_other)
+};
+
+}
+
+TEST(Concurrency, field_tracking_parameter_producer_not_stranded)
+{
+	// The consumer holds the lock while the only producer tries to store, so the producer parks.  Only the
+	// consumer's unlock can wake it.
+	field_tracking_parameter<stalling_payload> param;
+	stalling_payload reader;
+	param.store_field<0>(slow_field{});
+	std::atomic<bool> done {false};
+
+	slow_field::s_stall_next_copy = true;
+	std::thread producer([&](){
+		while(!slow_field::s_copy_in_progress.load())
+		{
+			std::this_thread::yield();
+		}
+		param.store_field<1>(1);
+		done = true;
+	});
+	EXPECT_TRUE(param.load_and_clear_if_set(&reader));
+
+	const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+	while(!done.load() && std::chrono::steady_clock::now() < deadline)
+	{
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+	EXPECT_TRUE(done.load()) << "producer stranded in lock()";
+	if(!done.load())
+	{
+		// Unstick it so we can join: a producer's unlock does notify.
+		param.store_field<1>(2);
+	}
+	producer.join();
+	EXPECT_TRUE(param.load_and_clear_if_set(&reader));
+	EXPECT_NE(0, reader.m_other);
+}
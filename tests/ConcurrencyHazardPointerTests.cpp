@@ -0,0 +1,172 @@
+/*
+ * Copyright 2024 Gary R. Van Sickle (grvs@users.sourceforge.net).
+ *
+ * This file is part of grvslib.
+ *
+ * grvslib is free software: you can redistribute it and/or modify it under the
+ * terms of version 3 of the GNU General Public License as published by the Free
+ * Software Foundation.
+ *
+ * grvslib is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * grvslib.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <gtest/gtest.h>
+
+// Std C++
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+
+// Ours.
+#include <grvslib/concurrency/hazard_pointer.h>
+
+namespace
+{
+
+struct node;
+
+/// Marks rather than deletes, so that a reader touching a "freed" node is a checkable failure, not UB.
+struct mark_freed
+{
+	void operator()(node* n) const noexcept;
+};
+
+struct node : hazard_pointer_obj_base<node, mark_freed>
+{
+	explicit node(std::uint64_t value) : m_value(value) {}
+	std::uint64_t m_value;
+	std::atomic<bool> m_freed {false};
+};
+
+void mark_freed::operator()(node* n) const noexcept
+{
+	n->m_freed.store(true, std::memory_order_relaxed);
+}
+
+struct counted : hazard_pointer_obj_base<counted>
+{
+	explicit counted(std::atomic<int>& live) : m_live(live) { ++m_live; }
+	~counted() { --m_live; }
+	std::atomic<int>& m_live;
+};
+
+}
+
+TEST(Concurrency, hazard_pointer_protects)
+{
+	// Declared before the domain, which reclaims whatever is left when it goes.
+	node a(1), b(2);
+	hazard_pointer_domain domain(4, 100);
+	std::atomic<node*> src {&a};
+
+	hazard_pointer empty;
+	EXPECT_TRUE(empty.empty());
+
+	auto hp = make_hazard_pointer(domain);
+	EXPECT_FALSE(hp.empty());
+	EXPECT_EQ(&a, hp.protect(src));
+
+	src = &b;
+	a.retire(mark_freed{}, domain);
+	EXPECT_EQ(1u, domain.num_retired());
+	EXPECT_EQ(0u, domain.reclaim());
+	EXPECT_FALSE(a.m_freed);
+
+	// try_protect() fails if the source has moved on, and hands back the new value.
+	node* p = &a;
+	EXPECT_FALSE(hp.try_protect(p, src));
+	EXPECT_EQ(&b, p);
+	EXPECT_TRUE(hp.try_protect(p, src));
+
+	EXPECT_EQ(1u, domain.reclaim());
+	EXPECT_TRUE(a.m_freed);
+	EXPECT_EQ(0u, domain.num_retired());
+
+	hp.reset_protection();
+	auto hp2 = std::move(hp);
+	EXPECT_TRUE(hp.empty());
+	EXPECT_FALSE(hp2.empty());
+}
+
+TEST(Concurrency, hazard_pointer_bounded_and_default_deleter)
+{
+	// Retiring past the threshold scans on the retiring thread, so however many we retire, at most threshold + the
+	// number of hazard pointers are ever outstanding.
+	std::atomic<int> live {0};
+	{
+		hazard_pointer_domain domain(2, 8);
+		auto hp = make_hazard_pointer(domain);
+		auto* pinned = new counted(live);
+		std::atomic<counted*> src {pinned};
+		hp.protect(src);
+		pinned->retire({}, domain);
+
+		std::size_t max_retired = 0;
+		for(int i = 0; i < 1000; ++i)
+		{
+			(new counted(live))->retire({}, domain);
+			max_retired = std::max(max_retired, domain.num_retired());
+		}
+		EXPECT_LE(max_retired, 8u + 2u);
+		EXPECT_GE(live.load(), 1);
+
+		auto hp2 = make_hazard_pointer(domain);
+		EXPECT_THROW(make_hazard_pointer(domain), std::runtime_error);
+	}
+	EXPECT_EQ(0, live.load());
+}
+
+TEST(Concurrency, hazard_pointer_readers_never_see_freed)
+{
+	constexpr int c_num_readers = 2;
+	constexpr std::uint64_t c_num_updates = 20'000;
+	std::vector<std::unique_ptr<node>> all_nodes;
+	all_nodes.reserve(c_num_updates + 1);
+	hazard_pointer_domain domain(8, 64);
+	all_nodes.push_back(std::make_unique<node>(0));
+	std::atomic<node*> shared {all_nodes.back().get()};
+	std::atomic<bool> done {false};
+	std::atomic<int> num_bad {0};
+
+	std::vector<std::thread> readers;
+	for(int r = 0; r < c_num_readers; ++r)
+	{
+		readers.emplace_back([&](){
+			auto hp = make_hazard_pointer(domain);
+			std::uint64_t last = 0;
+			while(!done.load(std::memory_order_relaxed))
+			{
+				node* n = hp.protect(shared);
+				num_bad += n->m_freed.load(std::memory_order_relaxed) || n->m_value < last;
+				last = n->m_value;
+				hp.reset_protection();
+			}
+		});
+	}
+
+	for(std::uint64_t i = 1; i <= c_num_updates; ++i)
+	{
+		all_nodes.push_back(std::make_unique<node>(i));
+		shared.exchange(all_nodes.back().get(), std::memory_order_acq_rel)->retire(mark_freed{}, domain);
+		if(i % 64 == 0)
+		{
+			std::this_thread::yield();
+		}
+	}
+	done = true;
+	for(auto& t : readers)
+	{
+		t.join();
+	}
+
+	EXPECT_EQ(0, num_bad.load());
+	EXPECT_LE(domain.num_retired(), 64u + 8u);
+}
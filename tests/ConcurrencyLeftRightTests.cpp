@@ -0,0 +1,94 @@
+/*
+ * Copyright 2024 Gary R. Van Sickle (grvs@users.sourceforge.net).
+ *
+ * This file is part of grvslib.
+ *
+ * grvslib is free software: you can redistribute it and/or modify it under the
+ * terms of version 3 of the GNU General Public License as published by the Free
+ * Software Foundation.
+ *
+ * grvslib is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * grvslib.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <gtest/gtest.h>
+
+// Std C++
+#include <atomic>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Ours.
+#include <grvslib/concurrency/left_right.h>
+
+TEST(Concurrency, left_right_basics)
+{
+	left_right<std::map<std::string, int>> presets;
+	EXPECT_TRUE(presets.read([](const auto& m){ return m.empty(); }));
+
+	presets.modify([](auto& m){ m["warm"] = 1; m["bright"] = 2; });
+	EXPECT_EQ(2u, presets.read([](const auto& m){ return m.size(); }));
+	EXPECT_EQ(2, presets.read([](const auto& m){ return m.at("bright"); }));
+
+	// Both instances got the mutation, whichever side readers are on now.
+	presets.modify([](auto& m){ m.erase("warm"); });
+	presets.modify([](auto& m){ m["dark"] = 3; });
+	EXPECT_EQ(2u, presets.read([](const auto& m){ return m.size(); }));
+	EXPECT_EQ(0u, presets.read([](const auto& m){ return m.count("warm"); }));
+
+	left_right<std::vector<int>> v(4, 7);
+	EXPECT_EQ(28, v.read([](const auto& x){ int s = 0; for(int i : x) { s += i; } return s; }));
+}
+
+TEST(Concurrency, left_right_readers_see_whole_mutations)
+{
+	// The writer grows a routing table one entry at a time, each mapping i -> i * 2.  Readers must always see a table
+	// which is exactly 0..size-1, however the modifies and reads interleave.
+	constexpr int c_num_readers = 2;
+	constexpr int c_num_routes = 2'000;
+	left_right<std::map<int, int>> routes;
+	std::atomic<bool> done {false};
+	std::atomic<int> num_bad {0};
+
+	std::vector<std::thread> readers;
+	for(int r = 0; r < c_num_readers; ++r)
+	{
+		readers.emplace_back([&](){
+			std::size_t last_size = 0;
+			while(!done.load(std::memory_order_relaxed))
+			{
+				const bool ok = routes.read([&](const std::map<int, int>& m){
+					const bool consistent = m.size() >= last_size && (m.empty()
+							|| (m.begin()->first == 0 && m.rbegin()->first == int(m.size()) - 1
+								&& m.rbegin()->second == m.rbegin()->first * 2));
+					last_size = m.size();
+					return consistent;
+				});
+				num_bad += !ok;
+			}
+		});
+	}
+
+	for(int i = 0; i < c_num_routes; ++i)
+	{
+		routes.modify([i](std::map<int, int>& m){ m[i] = i * 2; });
+		if(i % 64 == 0)
+		{
+			std::this_thread::yield();
+		}
+	}
+	done = true;
+	for(auto& t : readers)
+	{
+		t.join();
+	}
+
+	EXPECT_EQ(0, num_bad.load());
+	EXPECT_EQ(std::size_t(c_num_routes), routes.read([](const auto& m){ return m.size(); }));
+}
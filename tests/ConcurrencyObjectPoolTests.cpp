@@ -0,0 +1,154 @@
+/*
+ * Copyright 2024 Gary R. Van Sickle (grvs@users.sourceforge.net).
+ *
+ * This file is part of grvslib.
+ *
+ * grvslib is free software: you can redistribute it and/or modify it under the
+ * terms of version 3 of the GNU General Public License as published by the Free
+ * Software Foundation.
+ *
+ * grvslib is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * grvslib.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <gtest/gtest.h>
+
+// Std C++
+#include <atomic>
+#include <set>
+#include <thread>
+#include <vector>
+
+// Ours.
+#include <grvslib/concurrency/object_pool.h>
+#include <grvslib/concurrency/realtime.h>
+
+
+TEST(Concurrency, lock_free_object_pool_basic)
+{
+	lock_free_object_pool<int> pool(4);
+	EXPECT_TRUE(pool.is_always_lock_free);
+	EXPECT_EQ(4, pool.capacity());
+
+	std::set<int*> handed_out;
+	for(int i = 0; i < 4; ++i)
+	{
+		int* p = pool.acquire();
+		ASSERT_NE(nullptr, p);
+		EXPECT_TRUE(pool.owns(p));
+		EXPECT_EQ(p, pool.at(pool.index_of(p)));
+		handed_out.insert(p);
+	}
+	// All distinct, and the pool is now exhausted.
+	EXPECT_EQ(4, handed_out.size());
+	EXPECT_EQ(nullptr, pool.acquire());
+	EXPECT_EQ(pool.npos, pool.acquire_index());
+
+	pool.release(*handed_out.begin());
+	EXPECT_EQ(*handed_out.begin(), pool.acquire());
+}
+
+TEST(Concurrency, lock_free_object_pool_mlock)
+{
+	lock_free_object_pool<double> pool(1024, true);
+
+	// mlock() may legitimately fail without privileges, but the pool has to work either way.
+	double* p = pool.acquire();
+	ASSERT_NE(nullptr, p);
+	*p = 1.0;
+	pool.release(p);
+}
+
+TEST(Concurrency, lock_free_object_pool_multithreaded)
+{
+	// Each object records how many threads think they own it.  That must never be anything but 0 or 1.
+	struct Message
+	{
+		std::atomic<int> m_owners {0};
+	};
+
+	constexpr int c_num_threads = 4;
+	constexpr int c_iterations = 100'000;
+	lock_free_object_pool<Message> pool(c_num_threads * 2);
+	std::atomic<int> num_double_owned {0};
+
+	auto churn = [&](){
+		std::vector<Message*> held;
+		for(int i = 0; i < c_iterations; ++i)
+		{
+			if(Message* m = pool.acquire(); m != nullptr)
+			{
+				if(m->m_owners.fetch_add(1, std::memory_order_relaxed) != 0)
+				{
+					num_double_owned++;
+				}
+				held.push_back(m);
+			}
+			if(held.size() > 2 || (i % 3) == 0)
+			{
+				for(Message* m : held)
+				{
+					m->m_owners.fetch_sub(1, std::memory_order_relaxed);
+					pool.release(m);
+				}
+				held.clear();
+			}
+		}
+		for(Message* m : held)
+		{
+			m->m_owners.fetch_sub(1, std::memory_order_relaxed);
+			pool.release(m);
+		}
+	};
+
+	std::vector<std::thread> threads;
+	for(int i = 0; i < c_num_threads; ++i)
+	{
+		threads.emplace_back(churn);
+	}
+	for(auto& t : threads)
+	{
+		t.join();
+	}
+
+	EXPECT_EQ(0, num_double_owned);
+
+	// Everything should have come back.
+	int count = 0;
+	while(pool.acquire() != nullptr)
+	{
+		++count;
+	}
+	EXPECT_EQ(c_num_threads * 2, count);
+}
+
+#if __cpp_lib_atomic_flag_test >= 201907L
+TEST(Concurrency, lock_free_object_pool_with_atomic_notifying_parameter)
+{
+	struct Coefficients
+	{
+		double m_b[3];
+		double m_a[3];
+	};
+
+	lock_free_object_pool<Coefficients> pool(3);
+	atomic_notifying_parameter<lock_free_object_pool<Coefficients>::index_type> handoff;
+	EXPECT_TRUE(handoff.is_always_lock_free);
+
+	// Producer fills a pooled object and publishes its index.
+	auto index = pool.acquire_index();
+	ASSERT_NE(pool.npos, index);
+	pool.at(index)->m_b[0] = 0.5;
+	handoff.store_and_set(index);
+
+	// Consumer picks it up.
+	lock_free_object_pool<Coefficients>::index_type current = pool.npos;
+	ASSERT_TRUE(handoff.load_and_clear_if_set(&current));
+	EXPECT_EQ(0.5, pool.at(current)->m_b[0]);
+	pool.release_index(current);
+}
+#endif //__cpp_lib_atomic_flag_test >= 201907L
@@ -0,0 +1,140 @@
+/*
+ * Copyright 2024 Gary R. Van Sickle (grvs@users.sourceforge.net).
+ *
+ * This file is part of grvslib.
+ *
+ * grvslib is free software: you can redistribute it and/or modify it under the
+ * terms of version 3 of the GNU General Public License as published by the Free
+ * Software Foundation.
+ *
+ * grvslib is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * grvslib.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <gtest/gtest.h>
+
+// Std C++
+#include <atomic>
+#include <cstdint>
+#include <thread>
+
+// Ours.
+#include <grvslib/concurrency/packed_parameter_group.h>
+
+namespace
+{
+
+enum class filter_type : std::uint8_t { lowpass, highpass, bandpass, notch };
+
+using channel_strip = packed_parameter_group<
+		packed_field<bool, 1>,              // mute
+		packed_field<filter_type, 2>,       // filter
+		packed_field<std::uint8_t, 8>,      // preset
+		packed_field<std::int8_t, 7>>;      // pan, -64..63
+
+}
+
+TEST(Concurrency, packed_parameter_group_fields)
+{
+	static_assert(channel_strip::num_words == 1);
+
+	channel_strip strip;
+	channel_strip::snapshot s;
+	EXPECT_FALSE(strip.load_if_changed(&s));
+
+	strip.store<1, 3>(filter_type::notch, -64);
+	EXPECT_TRUE(strip.load_if_changed(&s));
+	EXPECT_FALSE(s.get<0>());
+	EXPECT_EQ(filter_type::notch, s.get<1>());
+	EXPECT_EQ(0, s.get<2>());
+	EXPECT_EQ(-64, s.get<3>());
+	EXPECT_FALSE(strip.load_if_changed(&s));
+
+	strip.store<0>(true);
+	strip.store<2>(255);
+	EXPECT_TRUE(strip.load_if_changed(&s));
+	EXPECT_TRUE(s.get<0>());
+	EXPECT_EQ(255, s.get<2>());
+	EXPECT_EQ(filter_type::notch, s.get<1>());
+	EXPECT_EQ(63, (strip.store<3>(63), strip.load<3>()));
+
+	// Storing what's already there isn't a change.
+	strip.load_if_changed(&s);
+	strip.store<0>(true);
+	EXPECT_FALSE(strip.load_if_changed(&s));
+
+	channel_strip initial(true, filter_type::bandpass, 7, -1);
+	auto i = initial.load();
+	EXPECT_TRUE(i.get<0>());
+	EXPECT_EQ(filter_type::bandpass, i.get<1>());
+	EXPECT_EQ(7, i.get<2>());
+	EXPECT_EQ(-1, i.get<3>());
+}
+
+TEST(Concurrency, packed_parameter_group_two_words)
+{
+	// 40 + 40 bits: the second field starts the second word.
+	packed_parameter_group<packed_field<std::uint64_t, 40>, packed_field<std::int64_t, 40>, packed_field<bool, 1>> g;
+	static_assert(decltype(g)::num_words == 2);
+	g.store<0, 1, 2>(0xFF'FFFF'FFFFull, -(std::int64_t(1) << 39), true);
+	auto s = g.load();
+	EXPECT_EQ(0xFF'FFFF'FFFFull, s.get<0>());
+	EXPECT_EQ(-(std::int64_t(1) << 39), s.get<1>());
+	EXPECT_TRUE(s.get<2>());
+}
+
+TEST(Concurrency, packed_parameter_group_multi_field_stores_are_atomic)
+{
+	// Producers store preset and pan together, always equal (mod their widths); the consumer must never see them
+	// differ.  A third producer flips mute alone, which mustn't disturb them.
+	constexpr int c_num_stores = 50'000;
+	channel_strip strip;
+	std::atomic<int> num_running {3};
+
+	auto pair_producer = [&](int offset){
+		for(int i = 0; i < c_num_stores; ++i)
+		{
+			const int v = (i + offset) % 64;
+			strip.store<2, 3>(v, v);
+			if(i % 64 == 0)
+			{
+				std::this_thread::yield();
+			}
+		}
+		num_running--;
+	};
+	std::thread a(pair_producer, 0), b(pair_producer, 32);
+	std::thread c([&](){
+		for(int i = 0; i < c_num_stores; ++i)
+		{
+			strip.store<0>(i % 2 == 0);
+			if(i % 64 == 0)
+			{
+				std::this_thread::yield();
+			}
+		}
+		num_running--;
+	});
+
+	channel_strip::snapshot s;
+	int num_torn {0};
+	while(num_running.load() != 0)
+	{
+		if(strip.load_if_changed(&s))
+		{
+			num_torn += (s.get<2>() != s.get<3>());
+		}
+	}
+	a.join();
+	b.join();
+	c.join();
+
+	EXPECT_EQ(0, num_torn);
+	s = strip.load();
+	EXPECT_EQ(s.get<2>(), s.get<3>());
+	EXPECT_FALSE(s.get<0>());
+}
@@ -0,0 +1,117 @@
+/*
+ * Copyright 2024 Gary R. Van Sickle (grvs@users.sourceforge.net).
+ *
+ * This file is part of grvslib.
+ *
+ * grvslib is free software: you can redistribute it and/or modify it under the
+ * terms of version 3 of the GNU General Public License as published by the Free
+ * Software Foundation.
+ *
+ * grvslib is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * grvslib.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <gtest/gtest.h>
+
+// Std C++
+#include <deque>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Ours.
+#include <grvslib/concurrency/parameter_registry.h>
+#include <grvslib/concurrency/realtime.h>
+
+
+TEST(Concurrency, frozen_parameter_registry_basic)
+{
+	int a {1}, b {2};
+	frozen_parameter_registry<int>::builder builder;
+	builder.add(10, "cutoff", &a).add(11, "resonance", &b);
+	auto registry = builder.freeze();
+
+	EXPECT_EQ(2, registry.size());
+	EXPECT_EQ(&a, registry.find(10));
+	EXPECT_EQ(&b, registry.find(11));
+	EXPECT_EQ(&a, registry.find("cutoff"));
+	EXPECT_EQ(&b, registry.find("resonance"));
+	EXPECT_EQ(nullptr, registry.find(12));
+	EXPECT_EQ(nullptr, registry.find("gain"));
+
+	// Precomputed hashes.
+	constexpr auto c_resonance_hash = parameter_name_hash("resonance");
+	EXPECT_EQ(&b, registry.find("resonance", c_resonance_hash));
+}
+
+TEST(Concurrency, frozen_parameter_registry_empty)
+{
+	frozen_parameter_registry<int> registry;
+	EXPECT_EQ(0, registry.size());
+	EXPECT_EQ(nullptr, registry.find(0));
+	EXPECT_EQ(nullptr, registry.find(""));
+}
+
+TEST(Concurrency, frozen_parameter_registry_duplicates)
+{
+	int a {1};
+	frozen_parameter_registry<int>::builder builder;
+	builder.add(1, "one", &a);
+	EXPECT_THROW(builder.add(1, "uno", &a), std::invalid_argument);
+	EXPECT_THROW(builder.add(2, "one", &a), std::invalid_argument);
+	EXPECT_THROW(builder.add(3, "three", nullptr), std::invalid_argument);
+}
+
+#if __cpp_lib_atomic_flag_test >= 201907L
+TEST(Concurrency, frozen_parameter_registry_many_parameters_many_threads)
+{
+	constexpr int c_num_params = 500;
+	std::deque<atomic_notifying_parameter<float>> params(c_num_params);
+
+	frozen_parameter_registry<atomic_notifying_parameter<float>>::builder builder;
+	for(int i = 0; i < c_num_params; ++i)
+	{
+		builder.add(1000 + i * 7, "param_" + std::to_string(i), &params[i]);
+	}
+	const auto registry = builder.freeze();
+	EXPECT_EQ(c_num_params, registry.size());
+	// With a load factor <= 0.5 probe sequences should stay short.
+	EXPECT_LT(registry.max_probe_length(), 32);
+
+	std::vector<std::thread> threads;
+	std::vector<int> num_mismatches(4, 0);
+	for(int t = 0; t < 4; ++t)
+	{
+		threads.emplace_back([&, t](){
+			for(int i = 0; i < c_num_params; ++i)
+			{
+				auto* by_id = registry.find(static_cast<std::uint32_t>(1000 + i * 7));
+				auto* by_name = registry.find("param_" + std::to_string(i));
+				if(by_id != &params[i] || by_name != &params[i])
+				{
+					num_mismatches[t]++;
+				}
+			}
+		});
+	}
+	for(auto& t : threads)
+	{
+		t.join();
+	}
+	for(int n : num_mismatches)
+	{
+		EXPECT_EQ(0, n);
+	}
+
+	// And the looked-up parameter is usable.
+	registry.find("param_42")->store_and_set(4.2f);
+	float value {0};
+	EXPECT_TRUE(params[42].load_and_clear_if_set(&value));
+	EXPECT_FLOAT_EQ(4.2f, value);
+}
+#endif //__cpp_lib_atomic_flag_test >= 201907L
@@ -0,0 +1,182 @@
+/*
+ * Copyright 2024 Gary R. Van Sickle (grvs@users.sourceforge.net).
+ *
+ * This file is part of grvslib.
+ *
+ * grvslib is free software: you can redistribute it and/or modify it under the
+ * terms of version 3 of the GNU General Public License as published by the Free
+ * Software Foundation.
+ *
+ * grvslib is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * grvslib.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <gtest/gtest.h>
+
+// Std C++
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+
+// Ours.
+#include <grvslib/concurrency/priority_inheritance_mutex.h>
+#include <grvslib/concurrency/double_checked_lock.h>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+
+TEST(Concurrency, priority_inheritance_mutex_is_lockable)
+{
+	priority_inheritance_mutex mutex;
+	{
+		std::lock_guard<priority_inheritance_mutex> lock(mutex);
+		EXPECT_FALSE(mutex.try_lock());
+	}
+	EXPECT_TRUE(mutex.try_lock());
+	mutex.unlock();
+
+	// Works as DoubleCheckedLock's MutexType.
+	static int s_the_value {7};
+	std::atomic<int*> cached {nullptr};
+	auto retval = DoubleCheckedLock<int*, nullptr, std::atomic<int*>, int*(*)(), priority_inheritance_mutex>(
+		cached, mutex, [](){ return &s_the_value; });
+	EXPECT_EQ(&s_the_value, retval);
+}
+
+#if defined(__linux__) && __cpp_lib_atomic_wait >= 201907L
+
+namespace
+{
+
+/// Put the calling thread on @p cpu at SCHED_FIFO @p priority.  Returns false if we aren't allowed to.
+bool make_this_thread_fifo(int cpu, int priority)
+{
+	cpu_set_t set;
+	CPU_ZERO(&set);
+	CPU_SET(cpu, &set);
+	if(pthread_setaffinity_np(pthread_self(), sizeof(set), &set) != 0)
+	{
+		return false;
+	}
+	sched_param param {};
+	param.sched_priority = priority;
+	return pthread_setschedparam(pthread_self(), SCHED_FIFO, &param) == 0;
+}
+
+/*
+ * The threads hand off to each other by blocking, not spinning.  A SCHED_FIFO thread spin-waiting on a single CPU
+ * would starve everything at lower priority, including whichever thread it's waiting for.
+ */
+void advance_to(std::atomic<int>& stage, int value)
+{
+	stage.store(value);
+	stage.notify_all();
+}
+
+void wait_for_stage(std::atomic<int>& stage, int value)
+{
+	for(int current = stage.load(); current < value; current = stage.load())
+	{
+		stage.wait(current);
+	}
+}
+
+void spin_for(std::chrono::milliseconds duration)
+{
+	auto end = std::chrono::steady_clock::now() + duration;
+	while(std::chrono::steady_clock::now() < end) {}
+}
+
+/**
+ * The classic three-thread inversion, all on one CPU:
+ * - Low takes the mutex and needs a little CPU time before it releases it.
+ * - High blocks on the mutex.
+ * - Medium, which doesn't touch the mutex, hogs the CPU for a long time.
+ *
+ * Without priority inheritance Medium starves Low, so High only gets the mutex after Medium is done.  With it, Low
+ * runs at High's priority, so High gets the mutex while Medium is still spinning.
+ *
+ * @return true if High got the mutex before Medium finished, false if not.  Skips the calling test if SCHED_FIFO
+ *         isn't permitted.
+ */
+template<typename MutexType>
+bool high_priority_thread_got_mutex_first(bool& skipped)
+{
+	const int cpu = sched_getcpu() >= 0 ? sched_getcpu() : 0;
+	MutexType mutex;
+	std::atomic<bool> permitted {true};
+	std::atomic<int> stage {0};
+	std::atomic<std::chrono::steady_clock::rep> high_acquired {0}, medium_done {0};
+	auto now = [](){ return std::chrono::steady_clock::now().time_since_epoch().count(); };
+
+	std::thread low([&](){
+		if(!make_this_thread_fifo(cpu, 10))
+		{
+			permitted = false;
+		}
+		std::unique_lock<MutexType> lock(mutex);
+		advance_to(stage, 1);
+		// Wait until High is blocked on the mutex and Medium is running, then do our bit of work.
+		wait_for_stage(stage, 3);
+		spin_for(std::chrono::milliseconds(5));
+	});
+	wait_for_stage(stage, 1);
+
+	std::thread high([&](){
+		if(!make_this_thread_fifo(cpu, 30))
+		{
+			permitted = false;
+		}
+		advance_to(stage, 2);
+		std::unique_lock<MutexType> lock(mutex);
+		high_acquired = now();
+	});
+	wait_for_stage(stage, 2);
+	// Give High a moment to actually block.
+	std::this_thread::sleep_for(std::chrono::milliseconds(5));
+
+	std::thread medium([&](){
+		if(!make_this_thread_fifo(cpu, 20))
+		{
+			permitted = false;
+		}
+		advance_to(stage, 3);
+		spin_for(std::chrono::milliseconds(60));
+		medium_done = now();
+	});
+
+	low.join();
+	high.join();
+	medium.join();
+
+	skipped = !permitted;
+	return high_acquired.load() < medium_done.load();
+}
+
+}
+
+TEST(Concurrency, priority_inheritance_mutex_prevents_inversion)
+{
+	if(!priority_inheritance_mutex::has_priority_inheritance)
+	{
+		GTEST_SKIP() << "No priority-inheriting mutex on this platform";
+	}
+
+	bool skipped = false;
+	bool pi_ok = high_priority_thread_got_mutex_first<priority_inheritance_mutex>(skipped);
+	if(skipped)
+	{
+		GTEST_SKIP() << "Not permitted to use SCHED_FIFO / CPU affinity";
+	}
+	EXPECT_TRUE(pi_ok);
+}
+
+#endif // __linux__ && __cpp_lib_atomic_wait >= 201907L
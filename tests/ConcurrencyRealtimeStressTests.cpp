@@ -0,0 +1,113 @@
+/*
+ * Copyright 2024 Gary R. Van Sickle (grvs@users.sourceforge.net).
+ *
+ * This file is part of grvslib.
+ *
+ * grvslib is free software: you can redistribute it and/or modify it under the
+ * terms of version 3 of the GNU General Public License as published by the Free
+ * Software Foundation.
+ *
+ * grvslib is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * grvslib.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file Randomized stress tests for the realtime.h primitives.  See realtime_stress.h for the knobs.
+ */
+
+#include <gtest/gtest.h>
+
+// Std C++
+#include <cstdint>
+#include <string>
+
+// Ours.
+#include <grvslib/concurrency/realtime.h>
+#include "realtime_stress.h"
+
+
+#if __cpp_lib_atomic_flag_test >= 201907L
+// atomic_notifying_parameter needs C++20 std::atomic_flag.
+
+namespace
+{
+
+template<typename Policy>
+grvslib::stress::result stress_scalar(const grvslib::stress::config& c)
+{
+	using grvslib::stress::packed_scalar_payload;
+	atomic_notifying_parameter<std::uint64_t, Policy> param;
+	return grvslib::stress::run<decltype(param), std::uint64_t>(param, c,
+		[](std::uint64_t p, std::uint64_t seq){ return packed_scalar_payload::make(p, seq); },
+		[](const std::uint64_t& v, std::uint64_t& p, std::uint64_t& seq){
+			p = packed_scalar_payload::producer_of(v);
+			seq = packed_scalar_payload::sequence_of(v);
+			return packed_scalar_payload::verify(v);
+		});
+}
+
+template<typename Policy, std::size_t NumWords>
+grvslib::stress::result stress_struct(const grvslib::stress::config& c)
+{
+	using payload = grvslib::stress::checked_payload<NumWords>;
+	atomic_notifying_parameter<payload, Policy> param;
+	return grvslib::stress::run<decltype(param), payload>(param, c,
+		[](std::uint64_t p, std::uint64_t seq){ return payload::make(p, seq); },
+		[](const payload& v, std::uint64_t& p, std::uint64_t& seq){
+			p = v.m_producer;
+			seq = v.m_sequence;
+			return v.verify();
+		});
+}
+
+void expect_clean(const grvslib::stress::result& r, const grvslib::stress::config& c)
+{
+	::testing::Test::RecordProperty("seed", std::to_string(c.m_seed));
+	::testing::Test::RecordProperty("producers", c.m_num_producers);
+	::testing::Test::RecordProperty("stores", std::to_string(r.m_num_stores));
+	::testing::Test::RecordProperty("loads", std::to_string(r.m_num_loads));
+	::testing::Test::RecordProperty("pickups", std::to_string(r.m_num_pickups));
+	::testing::Test::RecordProperty("ops_per_second", std::to_string(static_cast<std::uint64_t>(r.ops_per_second())));
+
+	SCOPED_TRACE("GRVSLIB_STRESS_SEED=" + std::to_string(c.m_seed));
+	EXPECT_EQ(0, r.m_num_torn);
+	EXPECT_EQ(0, r.m_num_regressions);
+	EXPECT_FALSE(r.m_lost_final_update);
+	EXPECT_GT(r.m_num_pickups, 0);
+}
+
+}
+
+TEST(ConcurrencyStress, atomic_notifying_parameter_scalar_acq_rel)
+{
+	auto c = grvslib::stress::config::from_environment(2);
+	auto r = stress_scalar<memory_order_policy_acq_rel>(c);
+	expect_clean(r, c);
+}
+
+TEST(ConcurrencyStress, atomic_notifying_parameter_scalar_seq_cst)
+{
+	auto c = grvslib::stress::config::from_environment(2);
+	auto r = stress_scalar<memory_order_policy_seq_cst>(c);
+	expect_clean(r, c);
+}
+
+TEST(ConcurrencyStress, atomic_notifying_parameter_struct_single_producer)
+{
+	auto c = grvslib::stress::config::from_environment(1);
+	auto r = stress_struct<memory_order_policy_acq_rel, 8>(c);
+	expect_clean(r, c);
+}
+
+TEST(ConcurrencyStress, atomic_notifying_parameter_struct_multi_producer)
+{
+	auto c = grvslib::stress::config::from_environment(3);
+	auto r = stress_struct<memory_order_policy_acq_rel, 8>(c);
+	expect_clean(r, c);
+}
+
+#endif //__cpp_lib_atomic_flag_test >= 201907L
@@ -18,8 +18,14 @@
 #include <gtest/gtest.h>
 
 // Std C++
+#include <algorithm>
+#include <array>
+#include <atomic>
 #include <chrono>
+#include <cstdint>
 #include <thread>
+#include <utility>
+#include <vector>
 
 // Ours.
 #include <grvslib/concurrency/realtime.h>
@@ -43,6 +49,22 @@ TEST(Concurrency, atomic_notifying_parameter_int)
 	EXPECT_EQ(5, retreived_value);
 }
 
+TEST(Concurrency, atomic_notifying_parameter_seq_cst_policy)
+{
+	atomic_notifying_parameter<int, memory_order_policy_seq_cst> the_parameter;
+	EXPECT_TRUE(the_parameter.is_always_lock_free);
+
+	int retreived_value {0};
+	EXPECT_FALSE(the_parameter.load_and_clear_if_set(&retreived_value));
+
+	the_parameter.store_and_set(5);
+	the_parameter.store_and_set(6);
+
+	EXPECT_TRUE(the_parameter.load_and_clear_if_set(&retreived_value));
+	EXPECT_EQ(6, retreived_value);
+	EXPECT_FALSE(the_parameter.load_and_clear_if_set(&retreived_value));
+}
+
 TEST(Concurrency, atomic_notifying_parameter_atomic_int)
 {
 	atomic_notifying_parameter<std::atomic<int>> the_parameter;
@@ -131,4 +153,373 @@ TEST(Concurrency, atomic_notifying_parameter_big_struct)
 	}
 }
 
+TEST(Concurrency, atomic_notifying_parameter_merge_policies)
+{
+	accumulating_parameter<float, merge_max> peak;
+	accumulating_parameter<std::uint64_t, merge_sum> count;
+	accumulating_parameter<std::uint32_t, merge_bitwise_or> status;
+	EXPECT_TRUE(peak.is_always_lock_free);
+
+	for(float v : {0.25f, 0.9f, 0.5f})
+	{
+		peak.store_and_set(v);
+	}
+	count.store_and_set(3);
+	count.store_and_set(4);
+	status.store_and_set(0x1);
+	status.store_and_set(0x8);
+
+	float p {0};
+	std::uint64_t c {0};
+	std::uint32_t s {0};
+	EXPECT_TRUE(peak.load_and_clear_if_set(&p));
+	EXPECT_EQ(0.9f, p);
+	EXPECT_TRUE(count.load_and_clear_if_set(&c));
+	EXPECT_EQ(7, c);
+	EXPECT_TRUE(status.load_and_clear_if_set(&s));
+	EXPECT_EQ(0x9, s);
+
+	// Loading reset them.
+	peak.store_and_set(-3.0f);
+	EXPECT_TRUE(peak.load_and_clear_if_set(&p));
+	EXPECT_EQ(-3.0f, p);
+	count.store_and_set(1);
+	EXPECT_TRUE(count.load_and_clear_if_set(&c));
+	EXPECT_EQ(1, c);
+	EXPECT_FALSE(status.load_and_clear_if_set(&s));
+}
+
+namespace
+{
+
+/// A struct of our own, with a policy which knows how to merge it.
+struct channel_meter
+{
+	float m_peak;
+	std::uint32_t m_clip_count;
+};
+
+struct channel_meter_merge : merge_max
+{
+	static void merge(channel_meter& accumulated, const channel_meter& value)
+	{
+		accumulated.m_peak = std::max(accumulated.m_peak, value.m_peak);
+		accumulated.m_clip_count += value.m_clip_count;
+	}
+	static void reset(channel_meter& accumulated)
+	{
+		accumulated = channel_meter{0.0f, 0};
+	}
+};
+
+}
+
+TEST(Concurrency, atomic_notifying_parameter_merge_structs)
+{
+	// std::array and std::pair are merged element by element.
+	accumulating_parameter<std::array<std::pair<float, std::uint32_t>, 2>, merge_max> per_field;
+	per_field.store_and_set({{{1.0f, 5}, {0.0f, 1}}});
+	per_field.store_and_set({{{0.5f, 7}, {2.0f, 0}}});
+	std::array<std::pair<float, std::uint32_t>, 2> a {};
+	EXPECT_TRUE(per_field.load_and_clear_if_set(&a));
+	EXPECT_EQ(1.0f, a[0].first);
+	EXPECT_EQ(7, a[0].second);
+	EXPECT_EQ(2.0f, a[1].first);
+	EXPECT_EQ(1, a[1].second);
+
+	accumulating_parameter<channel_meter, channel_meter_merge> meter;
+	meter.store_and_set({0.5f, 1});
+	meter.store_and_set({0.75f, 2});
+	channel_meter m {};
+	EXPECT_TRUE(meter.load_and_clear_if_set(&m));
+	EXPECT_EQ(0.75f, m.m_peak);
+	EXPECT_EQ(3, m.m_clip_count);
+	meter.store_and_set({0.1f, 0});
+	EXPECT_TRUE(meter.load_and_clear_if_set(&m));
+	EXPECT_EQ(0.1f, m.m_peak);
+	EXPECT_EQ(0, m.m_clip_count);
+}
+
+TEST(Concurrency, atomic_notifying_parameter_merge_sum_is_exact)
+{
+	// Several producers add while the consumer repeatedly loads and resets.  Nothing may be lost or counted twice.
+	constexpr int c_num_producers = 3;
+	constexpr std::uint64_t c_per_producer = 100'000;
+	accumulating_parameter<std::uint64_t, merge_sum> counter;
+	accumulating_parameter<std::array<std::uint64_t, 3>, merge_sum> struct_counter;
+
+	std::atomic<int> num_running {c_num_producers};
+	std::vector<std::thread> producers;
+	for(int t = 0; t < c_num_producers; ++t)
+	{
+		producers.emplace_back([&](){
+			for(std::uint64_t i = 0; i < c_per_producer; ++i)
+			{
+				counter.store_and_set(1);
+				if(i % 16 == 0)
+				{
+					struct_counter.store_and_set({1, 2, 3});
+				}
+			}
+			num_running--;
+		});
+	}
+
+	std::uint64_t total {0};
+	std::array<std::uint64_t, 3> struct_total {};
+	bool more = true;
+	while(more)
+	{
+		// Check before loading, so that the last pass happens after all producers are done.
+		more = num_running.load() != 0;
+		std::uint64_t c;
+		if(counter.load_and_clear_if_set(&c))
+		{
+			total += c;
+		}
+		std::array<std::uint64_t, 3> sc;
+		if(struct_counter.load_and_clear_if_set(&sc))
+		{
+			for(int i = 0; i < 3; ++i)
+			{
+				struct_total[i] += sc[i];
+			}
+		}
+		std::this_thread::yield();
+	}
+	for(auto& t : producers)
+	{
+		t.join();
+	}
+
+	EXPECT_EQ(c_num_producers * c_per_producer, total);
+	const std::uint64_t num_struct_stores = c_num_producers * ((c_per_producer + 15) / 16);
+	EXPECT_EQ(num_struct_stores, struct_total[0]);
+	EXPECT_EQ(2 * num_struct_stores, struct_total[1]);
+	EXPECT_EQ(3 * num_struct_stores, struct_total[2]);
+}
+
+#ifdef GRVSLIB_HAVE_DWCAS
+TEST(Concurrency, atomic_notifying_parameter_16_byte_payloads)
+{
+	// 9 to 16 bytes: lock-free via a 16-byte CAS rather than the spinlock path.
+	struct stereo_pair
+	{
+		double m_left {0.0};
+		double m_right {0.0};
+	};
+	struct frequency_gain
+	{
+		double m_frequency {1000.0};
+		float m_gain {1.0f};
+	};
+	static_assert(atomic_notifying_parameter<stereo_pair>::is_always_lock_free);
+	static_assert(atomic_notifying_parameter<frequency_gain>::is_always_lock_free);
+	// Accumulating ones still merge under the lock.
+	static_assert(!atomic_notifying_parameter<std::array<double, 2>, memory_order_policy_acq_rel, no_notification,
+			merge_sum>::is_always_lock_free);
+
+	{
+		atomic_notifying_parameter<frequency_gain> the_parameter;
+		frequency_gain value {0.0, 0.0f};
+		EXPECT_FALSE(the_parameter.load_and_clear_if_set(&value));
+		the_parameter.store_and_set(frequency_gain{440.0, 0.5f});
+		EXPECT_TRUE(the_parameter.load_and_clear_if_set(&value));
+		EXPECT_EQ(440.0, value.m_frequency);
+		EXPECT_EQ(0.5f, value.m_gain);
+	}
+
+	// Two producers storing pairs whose halves are always equal; the consumer must never see them differ.
+	constexpr int c_num_stores = 50'000;
+	atomic_notifying_parameter<stereo_pair> the_parameter;
+	std::atomic<int> num_running {2};
+	auto producer = [&](double sign){
+		for(int i = 1; i <= c_num_stores; ++i)
+		{
+			the_parameter.store_and_set(stereo_pair{sign * i, sign * i});
+			if(i % 64 == 0)
+			{
+				std::this_thread::yield();
+			}
+		}
+		num_running--;
+	};
+	std::thread a(producer, 1.0), b(producer, -1.0);
+	int num_torn {0};
+	stereo_pair value;
+	while(num_running.load() != 0)
+	{
+		if(the_parameter.load_and_clear_if_set(&value))
+		{
+			num_torn += (value.m_left != value.m_right);
+		}
+	}
+	a.join();
+	b.join();
+	EXPECT_EQ(0, num_torn);
+}
+#endif
+
 #endif //__cpp_lib_atomic_flag_test >= 201907L
+
+#if __cpp_lib_atomic_wait >= 201907L
+
+namespace
+{
+
+/**
+ * Run @p num_threads threads through @p num_phases phases.  In each phase every thread bumps its own counter, then
+ * checks after the barrier that everybody else's counter has caught up.
+ * @return The number of times a thread saw a counter which hadn't.
+ */
+int run_phases(spin_phaser& phaser, int num_threads, int num_phases)
+{
+	std::vector<std::atomic<int>> counters(num_threads);
+	std::atomic<int> num_errors {0};
+	std::vector<std::thread> threads;
+	for(int t = 0; t < num_threads; ++t)
+	{
+		threads.emplace_back([&, t](){
+			for(int phase = 0; phase < num_phases; ++phase)
+			{
+				counters[t].store(phase + 1, std::memory_order_relaxed);
+				phaser.arrive_and_wait(t);
+				for(auto& c : counters)
+				{
+					if(c.load(std::memory_order_relaxed) < phase + 1)
+					{
+						num_errors++;
+					}
+				}
+				// Second barrier so nobody races ahead into the next phase's store while others are still checking.
+				phaser.arrive_and_wait(t);
+			}
+		});
+	}
+	for(auto& t : threads)
+	{
+		t.join();
+	}
+	return num_errors;
+}
+
+}
+
+TEST(Concurrency, spin_phaser_spinning)
+{
+	constexpr int c_num_threads = 4;
+	spin_phaser phaser(c_num_threads);
+	EXPECT_EQ(0, run_phases(phaser, c_num_threads, 300));
+	for(int t = 0; t < c_num_threads; ++t)
+	{
+		auto s = phaser.stats(t);
+		EXPECT_EQ(600, s.m_num_waits);
+		EXPECT_GE(s.m_max_wait_ns, s.m_last_wait_ns);
+		EXPECT_GE(s.m_total_wait_ns, s.m_max_wait_ns);
+	}
+}
+
+TEST(Concurrency, spin_phaser_parking)
+{
+	// Spin limit of one: everybody but the last arriver parks.
+	constexpr int c_num_threads = 3;
+	spin_phaser phaser(c_num_threads, 1);
+	EXPECT_EQ(0, run_phases(phaser, c_num_threads, 500));
+	std::uint64_t num_parks = 0;
+	for(int t = 0; t < c_num_threads; ++t)
+	{
+		num_parks += phaser.stats(t).m_num_parks;
+	}
+	EXPECT_GT(num_parks, 0);
+
+	phaser.reset_stats();
+	EXPECT_EQ(0, phaser.stats(0).m_num_waits);
+}
+
+#endif //__cpp_lib_atomic_wait >= 201907L
+
+TEST(Concurrency, meter_bank_basic)
+{
+	meter_bank bank(4);
+	std::vector<meter_values> held(4);
+	EXPECT_FALSE(bank.read_and_merge(held.data()));
+
+	bank.update(1, 0.5f, 0.25f, 1);
+	EXPECT_TRUE(bank.publish());
+	// The UI hasn't taken the first lot, so this one is held back, and merged with the next.
+	bank.update(1, 0.75f, 0.125f);
+	EXPECT_FALSE(bank.publish());
+	bank.update(1, 0.25f, 0.0f, 2);
+
+	EXPECT_TRUE(bank.read_and_merge(held.data()));
+	EXPECT_EQ(0.5f, held[1].m_peak);
+	EXPECT_EQ(1, held[1].m_clip_count);
+	EXPECT_FALSE(bank.read_and_merge(held.data()));
+
+	EXPECT_TRUE(bank.publish());
+	EXPECT_TRUE(bank.read_and_merge(held.data()));
+	EXPECT_EQ(0.75f, held[1].m_peak);
+	EXPECT_EQ(0.25f, held[1].m_rms);
+	EXPECT_EQ(3, held[1].m_clip_count);
+	EXPECT_EQ(0.0f, held[0].m_peak);
+
+	// Each published buffer starts from scratch.
+	held.assign(4, meter_values{});
+	bank.update(2, 0.1f, 0.1f);
+	EXPECT_TRUE(bank.publish());
+	EXPECT_TRUE(bank.read_and_merge(held.data()));
+	EXPECT_EQ(0.0f, held[1].m_peak);
+	EXPECT_EQ(0, held[1].m_clip_count);
+	EXPECT_EQ(0.1f, held[2].m_peak);
+}
+
+TEST(Concurrency, meter_bank_two_threads)
+{
+	// Every block, channel c peaks at some value and clips once.  The UI must end up with every channel's overall
+	// peak and every clip, however the two threads interleave.
+	constexpr std::size_t c_num_channels = 128;
+	constexpr std::uint32_t c_num_blocks = 20'000;
+	meter_bank bank(c_num_channels);
+	std::atomic<bool> rt_done {false};
+
+	std::thread rt([&](){
+		for(std::uint32_t block = 0; block < c_num_blocks; ++block)
+		{
+			for(std::size_t c = 0; c < c_num_channels; ++c)
+			{
+				const float peak = static_cast<float>((block * 7919 + c * 104729) % 10007) / 10007.0f;
+				bank.update(c, peak, peak / 2, 1);
+			}
+			bank.publish();
+		}
+		// Make sure the last blocks get out.
+		while(!bank.publish())
+		{
+			std::this_thread::yield();
+		}
+		rt_done = true;
+	});
+
+	std::vector<meter_values> held(c_num_channels);
+	while(!rt_done.load())
+	{
+		bank.read_and_merge(held.data());
+		std::this_thread::yield();
+	}
+	rt.join();
+	// The RT thread's final publish(), unless the loop above already got it.
+	bank.read_and_merge(held.data());
+
+	int num_bad {0};
+	for(std::size_t c = 0; c < c_num_channels; ++c)
+	{
+		float expected_peak = 0.0f;
+		for(std::uint32_t block = 0; block < c_num_blocks; ++block)
+		{
+			expected_peak = std::max(expected_peak,
+									 static_cast<float>((block * 7919 + c * 104729) % 10007) / 10007.0f);
+		}
+		num_bad += (held[c].m_peak != expected_peak || held[c].m_clip_count != c_num_blocks);
+	}
+	EXPECT_EQ(0, num_bad);
+}
@@ -0,0 +1,102 @@
+/*
+ * Copyright 2024 Gary R. Van Sickle (grvs@users.sourceforge.net).
+ *
+ * This file is part of grvslib.
+ *
+ * grvslib is free software: you can redistribute it and/or modify it under the
+ * terms of version 3 of the GNU General Public License as published by the Free
+ * Software Foundation.
+ *
+ * grvslib is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * grvslib.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <gtest/gtest.h>
+
+// Std C++
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Ours.
+#include <grvslib/concurrency/sharded_counter.h>
+#include <grvslib/concurrency/metrics.h>
+#include <grvslib/concurrency/realtime.h>
+#include <grvslib/concurrency/double_checked_lock.h>
+
+
+TEST(Concurrency, sharded_counter_multithreaded)
+{
+	constexpr int c_num_threads = 8;
+	constexpr std::uint64_t c_adds_per_thread = 100'000;
+	sharded_counter counter;
+	EXPECT_TRUE(counter.is_always_lock_free);
+
+	std::vector<std::thread> threads;
+	for(int i = 0; i < c_num_threads; ++i)
+	{
+		threads.emplace_back([&](){
+			for(std::uint64_t j = 0; j < c_adds_per_thread; ++j)
+			{
+				counter.add();
+			}
+		});
+	}
+	for(auto& t : threads)
+	{
+		t.join();
+	}
+
+	EXPECT_EQ(c_num_threads * c_adds_per_thread, counter.read());
+	counter.reset();
+	EXPECT_EQ(0, counter.read());
+}
+
+TEST(Concurrency, sharded_gauge)
+{
+	sharded_gauge gauge;
+	std::thread t1([&](){ gauge.add(5); });
+	std::thread t2([&](){ gauge.sub(7); });
+	t1.join();
+	t2.join();
+	EXPECT_EQ(-2, gauge.read());
+}
+
+#if __cpp_lib_atomic_flag_test >= 201907L
+TEST(Concurrency, metrics_realtime_and_double_checked_lock)
+{
+	if constexpr(!grvslib::metrics::enabled)
+	{
+		GTEST_SKIP() << "Built without GRVSLIB_ENABLE_METRICS";
+	}
+
+	auto stored_before = grvslib::metrics::realtime.m_updates_stored.read();
+	auto applied_before = grvslib::metrics::realtime.m_updates_applied.read();
+
+	atomic_notifying_parameter<int> param;
+	int value {0};
+	param.store_and_set(1);
+	param.store_and_set(2);
+	param.load_and_clear_if_set(&value);
+	param.load_and_clear_if_set(&value);
+
+	EXPECT_EQ(2, grvslib::metrics::realtime.m_updates_stored.read() - stored_before);
+	EXPECT_EQ(1, grvslib::metrics::realtime.m_updates_applied.read() - applied_before);
+
+	auto fills_before = grvslib::metrics::double_checked_lock.m_cache_fills.read();
+	std::atomic<int*> cached {nullptr};
+	std::mutex mutex;
+	static int s_the_value {3};
+	for(int i = 0; i < 3; ++i)
+	{
+		DoubleCheckedLock<int*, nullptr>(cached, mutex, [](){ return &s_the_value; });
+	}
+	EXPECT_EQ(1, grvslib::metrics::double_checked_lock.m_cache_fills.read() - fills_before);
+}
+#endif //__cpp_lib_atomic_flag_test >= 201907L
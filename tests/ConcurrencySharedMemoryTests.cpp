@@ -0,0 +1,293 @@
+/*
+ * Copyright 2024 Gary R. Van Sickle (grvs@users.sourceforge.net).
+ *
+ * This file is part of grvslib.
+ *
+ * grvslib is free software: you can redistribute it and/or modify it under the
+ * terms of version 3 of the GNU General Public License as published by the Free
+ * Software Foundation.
+ *
+ * grvslib is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * grvslib.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <gtest/gtest.h>
+
+// Std C++
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <system_error>
+#include <thread>
+
+// Ours.
+#include <grvslib/concurrency/shared_memory.h>
+#include <grvslib/concurrency/shared_notifying_parameter.h>
+#include <grvslib/concurrency/shared_spsc_ring.h>
+
+#ifdef GRVSLIB_HAVE_SHARED_MEMORY
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+using namespace std::chrono_literals;
+
+namespace
+{
+
+/// Several words which can only be consistent with each other if they were copied as a unit.
+struct checked_words
+{
+	std::uint64_t m_value;
+	std::uint64_t m_check[5];
+
+	static checked_words make(std::uint64_t value)
+	{
+		checked_words w {value, {}};
+		for(std::uint64_t i = 0; i < 5; ++i)
+		{
+			w.m_check[i] = (value * (i + 3)) ^ 0x5a5a5a5a5a5a5a5aull;
+		}
+		return w;
+	}
+
+	bool is_consistent() const { return make(m_value).m_check[4] == m_check[4] && make(m_value).m_check[0] == m_check[0]; }
+};
+
+}
+
+TEST(Concurrency, shared_notifying_parameter_in_process)
+{
+	shared_notifying_parameter<checked_words> param(checked_words::make(7));
+	EXPECT_TRUE(param.is_always_lock_free);
+
+	checked_words w {};
+	EXPECT_FALSE(param.load_and_clear_if_set(&w));
+	EXPECT_FALSE(param.wait_for_update(1ms));
+
+	param.store_and_set(checked_words::make(8));
+	param.store_and_set(checked_words::make(9));
+	EXPECT_TRUE(param.wait_for_update(0ns));
+	EXPECT_TRUE(param.load_and_clear_if_set(&w));
+	EXPECT_EQ(9, w.m_value);
+	EXPECT_FALSE(param.load_and_clear_if_set(&w));
+
+	std::thread producer([&](){
+		std::this_thread::sleep_for(10ms);
+		param.store_and_set(checked_words::make(10));
+	});
+	EXPECT_TRUE(param.wait_for_update(10s));
+	EXPECT_TRUE(param.load_and_clear_if_set(&w));
+	EXPECT_EQ(10, w.m_value);
+	producer.join();
+}
+
+#ifdef GRVSLIB_HAVE_SHARED_MEMORY
+
+TEST(Concurrency, shared_memory_segment_create_open)
+{
+	const std::string name = "/grvslib-test-segment-" + std::to_string(::getpid());
+	auto created = shared_memory_segment::create(name, 1000);
+	EXPECT_THROW(shared_memory_segment::create(name, 1000), std::system_error);
+	static_cast<char*>(created.data())[999] = 'x';
+
+	auto opened = shared_memory_segment::open(name);
+	EXPECT_EQ(1000, opened.size());
+	EXPECT_EQ('x', static_cast<char*>(opened.data())[999]);
+
+	EXPECT_TRUE(shared_memory_segment::unlink(name));
+	EXPECT_FALSE(shared_memory_segment::unlink(name));
+	EXPECT_THROW(shared_memory_segment::open(name), std::system_error);
+}
+
+TEST(Concurrency, shared_notifying_parameter_across_fork)
+{
+	using param_type = shared_notifying_parameter<checked_words>;
+	constexpr std::uint64_t c_last = 50'000;
+	const std::string name = "/grvslib-test-param-" + std::to_string(::getpid());
+
+	auto param = shared_object<param_type>::create(name, checked_words::make(0));
+	EXPECT_THROW(shared_object<std::uint64_t>::open(name), std::runtime_error);
+
+	const pid_t child = ::fork();
+	ASSERT_NE(-1, child);
+	if(child == 0)
+	{
+		// The producer.  Opens the segment by name, so it gets its own mapping.
+		int status = 0;
+		try
+		{
+			auto p = shared_object<param_type>::open(name);
+			for(std::uint64_t i = 1; i <= c_last; ++i)
+			{
+				p->store_and_set(checked_words::make(i));
+			}
+		}
+		catch(...)
+		{
+			status = 1;
+		}
+		::_exit(status);
+	}
+
+	// The consumer.
+	std::uint64_t last_seen {0};
+	int num_inconsistent {0}, num_backwards {0};
+	const auto give_up = std::chrono::steady_clock::now() + 30s;
+	while(last_seen != c_last && std::chrono::steady_clock::now() < give_up)
+	{
+		checked_words w {};
+		if(param->load_and_clear_if_set(&w))
+		{
+			num_inconsistent += !w.is_consistent();
+			num_backwards += (w.m_value <= last_seen);
+			last_seen = w.m_value;
+		}
+		else
+		{
+			param->wait_for_update(1ms);
+		}
+	}
+
+	int status = -1;
+	ASSERT_EQ(child, ::waitpid(child, &status, 0));
+	EXPECT_TRUE(WIFEXITED(status));
+	EXPECT_EQ(0, WEXITSTATUS(status));
+	EXPECT_EQ(c_last, last_seen);
+	EXPECT_EQ(0, num_inconsistent);
+	EXPECT_EQ(0, num_backwards);
+	shared_memory_segment::unlink(name);
+}
+
+TEST(Concurrency, shared_spsc_ring_across_fork)
+{
+	constexpr std::uint64_t c_count = 100'000;
+	const std::string name = "/grvslib-test-ring-" + std::to_string(::getpid());
+
+	auto consumer = shared_spsc_ring::create(name, sizeof(checked_words), 64, shared_spsc_ring::role::consumer);
+	EXPECT_EQ(64, consumer.capacity());
+	EXPECT_THROW(shared_spsc_ring::open(name, shared_spsc_ring::role::consumer), std::runtime_error);
+
+	const pid_t child = ::fork();
+	ASSERT_NE(-1, child);
+	if(child == 0)
+	{
+		int status = 0;
+		try
+		{
+			auto producer = shared_spsc_ring::open(name, shared_spsc_ring::role::producer);
+			for(std::uint64_t i = 0; i < c_count; )
+			{
+				if(void* r = producer.try_reserve(); r != nullptr)
+				{
+					*static_cast<checked_words*>(r) = checked_words::make(i++);
+					producer.commit();
+				}
+				else
+				{
+					std::this_thread::yield();
+				}
+			}
+		}
+		catch(...)
+		{
+			status = 1;
+		}
+		::_exit(status);
+	}
+
+	std::uint64_t expected {0};
+	int num_bad {0};
+	const auto give_up = std::chrono::steady_clock::now() + 30s;
+	while(expected < c_count && std::chrono::steady_clock::now() < give_up)
+	{
+		if(!consumer.wait_for_data(10ms))
+		{
+			continue;
+		}
+		while(const void* r = consumer.front())
+		{
+			const auto& w = *static_cast<const checked_words*>(r);
+			num_bad += (w.m_value != expected || !w.is_consistent());
+			expected = w.m_value + 1;
+			consumer.pop();
+		}
+	}
+
+	int status = -1;
+	ASSERT_EQ(child, ::waitpid(child, &status, 0));
+	EXPECT_TRUE(WIFEXITED(status));
+	EXPECT_EQ(0, WEXITSTATUS(status));
+	EXPECT_EQ(c_count, expected);
+	EXPECT_EQ(0, num_bad);
+	shared_memory_segment::unlink(name);
+}
+
+TEST(Concurrency, shared_spsc_ring_producer_crash_recovery)
+{
+	const std::string name = "/grvslib-test-ring-crash-" + std::to_string(::getpid());
+	auto consumer = shared_spsc_ring::create(name, sizeof(checked_words), 32, shared_spsc_ring::role::consumer);
+
+	// A producer which commits ten records, then dies half-way through the eleventh without cleaning up.
+	const pid_t child = ::fork();
+	ASSERT_NE(-1, child);
+	if(child == 0)
+	{
+		int status = 0;
+		try
+		{
+			auto producer = shared_spsc_ring::open(name, shared_spsc_ring::role::producer);
+			for(std::uint64_t i = 0; i < 10; ++i)
+			{
+				const auto w = checked_words::make(i);
+				status |= !producer.try_push(&w);
+			}
+			if(auto* torn = static_cast<checked_words*>(producer.try_reserve()); torn != nullptr)
+			{
+				torn->m_value = 999;
+			}
+			else
+			{
+				status = 1;
+			}
+		}
+		catch(...)
+		{
+			status = 1;
+		}
+		::_exit(status);
+	}
+	int status = -1;
+	ASSERT_EQ(child, ::waitpid(child, &status, 0));
+	EXPECT_TRUE(WIFEXITED(status));
+	EXPECT_EQ(0, WEXITSTATUS(status));
+	EXPECT_FALSE(consumer.peer_attached());
+
+	// Its replacement takes over and carries on.
+	auto producer = shared_spsc_ring::open(name, shared_spsc_ring::role::producer);
+	EXPECT_TRUE(consumer.peer_attached());
+	for(std::uint64_t i = 10; i < 20; ++i)
+	{
+		const auto w = checked_words::make(i);
+		EXPECT_TRUE(producer.try_push(&w));
+	}
+
+	EXPECT_EQ(20, consumer.read_available());
+	for(std::uint64_t i = 0; i < 20; ++i)
+	{
+		const auto* w = static_cast<const checked_words*>(consumer.front());
+		ASSERT_NE(nullptr, w);
+		EXPECT_EQ(i, w->m_value);
+		EXPECT_TRUE(w->is_consistent());
+		consumer.pop();
+	}
+	EXPECT_EQ(nullptr, consumer.front());
+	EXPECT_FALSE(consumer.wait_for_data(1ms));
+	shared_memory_segment::unlink(name);
+}
+
+#endif // GRVSLIB_HAVE_SHARED_MEMORY
@@ -0,0 +1,133 @@
+/*
+ * Copyright 2024 Gary R. Van Sickle (grvs@users.sourceforge.net).
+ *
+ * This file is part of grvslib.
+ *
+ * grvslib is free software: you can redistribute it and/or modify it under the
+ * terms of version 3 of the GNU General Public License as published by the Free
+ * Software Foundation.
+ *
+ * grvslib is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * grvslib.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <gtest/gtest.h>
+
+// Std C++
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+// Ours.
+#include <grvslib/concurrency/spsc_ring.h>
+
+
+TEST(Concurrency, spsc_ring_basic)
+{
+	spsc_ring<int> ring(3);
+	EXPECT_TRUE(ring.is_always_lock_free);
+	EXPECT_EQ(4, ring.capacity());
+	EXPECT_TRUE(ring.empty());
+	EXPECT_EQ(nullptr, ring.front());
+
+	for(int i = 0; i < 4; ++i)
+	{
+		EXPECT_TRUE(ring.try_push(i));
+	}
+	EXPECT_FALSE(ring.try_push(99));
+
+	int value {-1};
+	EXPECT_TRUE(ring.try_pop(value));
+	EXPECT_EQ(0, value);
+	ASSERT_NE(nullptr, ring.front());
+	EXPECT_EQ(1, *ring.front());
+
+	const int batch[] = {10, 11, 12};
+	EXPECT_EQ(1, ring.try_push_n(batch, 3));
+	for(int expected : {1, 2, 3, 10})
+	{
+		EXPECT_TRUE(ring.try_pop(value));
+		EXPECT_EQ(expected, value);
+	}
+	EXPECT_FALSE(ring.try_pop(value));
+}
+
+TEST(Concurrency, spsc_ring_two_threads)
+{
+	constexpr std::uint64_t c_count = 1'000'000;
+	spsc_ring<std::uint64_t> ring(256);
+	std::uint64_t num_out_of_order {0};
+
+	std::thread consumer([&](){
+		std::uint64_t expected = 0;
+		while(expected < c_count)
+		{
+			std::uint64_t value;
+			if(ring.try_pop(value))
+			{
+				if(value != expected)
+				{
+					num_out_of_order++;
+				}
+				expected = value + 1;
+			}
+			else
+			{
+				std::this_thread::yield();
+			}
+		}
+	});
+	std::thread producer([&](){
+		for(std::uint64_t i = 0; i < c_count; )
+		{
+			if(ring.try_push(i))
+			{
+				++i;
+			}
+			else
+			{
+				std::this_thread::yield();
+			}
+		}
+	});
+	producer.join();
+	consumer.join();
+
+	EXPECT_EQ(0, num_out_of_order);
+	EXPECT_TRUE(ring.empty());
+}
+
+TEST(Concurrency, spsc_ring_reserve_commit)
+{
+	spsc_ring<std::vector<int>> ring(2, std::vector<int>(16, -1));
+	EXPECT_EQ(2, ring.capacity());
+
+	// Slots come preallocated, and reserving doesn't publish anything.
+	std::vector<int>* slot = ring.try_reserve();
+	ASSERT_NE(nullptr, slot);
+	EXPECT_EQ(16, slot->size());
+	EXPECT_EQ(nullptr, ring.front());
+	(*slot)[0] = 1;
+	ring.commit();
+
+	slot = ring.try_reserve();
+	ASSERT_NE(nullptr, slot);
+	(*slot)[0] = 2;
+	ring.commit();
+	EXPECT_EQ(nullptr, ring.try_reserve());
+
+	ASSERT_NE(nullptr, ring.front());
+	EXPECT_EQ(1, ring.front()->at(0));
+	ring.pop();
+	EXPECT_EQ(2, ring.front()->at(0));
+
+	// The freed slot comes back with its old contents and capacity.
+	slot = ring.try_reserve();
+	ASSERT_NE(nullptr, slot);
+	EXPECT_EQ(1, (*slot)[0]);
+	EXPECT_EQ(16, slot->size());
+}
@@ -0,0 +1,133 @@
+/*
+ * Copyright 2024 Gary R. Van Sickle (grvs@users.sourceforge.net).
+ *
+ * This file is part of grvslib.
+ *
+ * grvslib is free software: you can redistribute it and/or modify it under the
+ * terms of version 3 of the GNU General Public License as published by the Free
+ * Software Foundation.
+ *
+ * grvslib is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * grvslib.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <gtest/gtest.h>
+
+// Std C++
+#include <cstdint>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Ours.
+#include <grvslib/concurrency/timestamped_event_queue.h>
+
+
+TEST(Concurrency, timestamped_event_queue_merges_in_time_order)
+{
+	timestamped_event_queue<float> queue(2, 16);
+	const timestamped_parameter_event<float> a[] = {{0, 1, 0.1f}, {5, 1, 0.5f}, {9, 1, 0.9f}};
+	const timestamped_parameter_event<float> b[] = {{3, 2, 3.0f}, {5, 2, 5.0f}, {70, 2, 7.0f}};
+	EXPECT_EQ(3, queue.producer(0).push_batch(a, 3));
+	EXPECT_EQ(3, queue.producer(1).push_batch(b, 3));
+
+	std::vector<std::pair<std::int64_t, std::uint32_t>> seen;
+	auto n = queue.drain(64, [&](const auto& e){ seen.emplace_back(e.m_sample_time, e.m_param_id); });
+
+	// The t=70 event belongs to a later block.  Ties go to the lower-numbered lane.
+	EXPECT_EQ(5, n);
+	const std::vector<std::pair<std::int64_t, std::uint32_t>> expected {{0, 1}, {3, 2}, {5, 1}, {5, 2}, {9, 1}};
+	EXPECT_EQ(expected, seen);
+
+	seen.clear();
+	EXPECT_EQ(1, queue.drain(128, [&](const auto& e){ seen.emplace_back(e.m_sample_time, e.m_param_id); }));
+	EXPECT_EQ(70, seen.at(0).first);
+}
+
+TEST(Concurrency, timestamped_event_queue_process_block_splits_at_events)
+{
+	timestamped_event_queue<float> queue(1, 16);
+	// One late event from before this block, two inside it.
+	queue.producer(0).push({60, 7, 1.0f});
+	queue.producer(0).push({70, 7, 2.0f});
+	queue.producer(0).push({100, 7, 3.0f});
+
+	std::vector<std::pair<std::uint32_t, std::uint32_t>> segments;
+	std::vector<std::uint32_t> event_offsets;
+	queue.process_block(64, 64,
+		[&](const auto&, std::uint32_t offset){ event_offsets.push_back(offset); },
+		[&](std::uint32_t offset, std::uint32_t length){ segments.emplace_back(offset, length); });
+
+	EXPECT_EQ((std::vector<std::uint32_t>{0, 6, 36}), event_offsets);
+	const std::vector<std::pair<std::uint32_t, std::uint32_t>> expected_segments {{0, 6}, {6, 30}, {36, 28}};
+	EXPECT_EQ(expected_segments, segments);
+
+	// No events: one segment covering the whole block.
+	segments.clear();
+	queue.process_block(128, 64, [](const auto&, std::uint32_t){},
+		[&](std::uint32_t offset, std::uint32_t length){ segments.emplace_back(offset, length); });
+	EXPECT_EQ((std::vector<std::pair<std::uint32_t, std::uint32_t>>{{0, 64}}), segments);
+}
+
+TEST(Concurrency, timestamped_event_queue_concurrent_producers)
+{
+	constexpr int c_num_producers = 3;
+	constexpr std::int64_t c_events_per_producer = 20'000;
+	constexpr std::uint32_t c_block_length = 64;
+	timestamped_event_queue<float> queue(c_num_producers, 128);
+
+	std::vector<std::thread> producers;
+	for(int p = 0; p < c_num_producers; ++p)
+	{
+		producers.emplace_back([&, p](){
+			auto& lane = queue.producer(p);
+			for(std::int64_t t = 0; t < c_events_per_producer; )
+			{
+				if(lane.push({t, static_cast<std::uint32_t>(p), static_cast<float>(t)}))
+				{
+					++t;
+				}
+				else
+				{
+					std::this_thread::yield();
+				}
+			}
+		});
+	}
+
+	// Consume as if processing blocks, but keep going until everything has been seen.
+	std::int64_t num_seen = 0;
+	std::int64_t num_out_of_order = 0;
+	std::int64_t block_start = 0;
+	while(num_seen < c_num_producers * c_events_per_producer)
+	{
+		std::int64_t last_time = -1;
+		auto n = queue.drain(block_start + c_block_length, [&](const auto& e){
+			if(e.m_sample_time < last_time)
+			{
+				num_out_of_order++;
+			}
+			last_time = e.m_sample_time;
+			num_seen++;
+		});
+		if(n == 0)
+		{
+			std::this_thread::yield();
+		}
+		if(block_start < c_events_per_producer)
+		{
+			block_start += c_block_length;
+		}
+	}
+	for(auto& t : producers)
+	{
+		t.join();
+	}
+
+	EXPECT_EQ(c_num_producers * c_events_per_producer, num_seen);
+	EXPECT_EQ(0, num_out_of_order);
+}
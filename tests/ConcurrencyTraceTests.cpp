@@ -0,0 +1,147 @@
+/*
+ * Copyright 2024 Gary R. Van Sickle (grvs@users.sourceforge.net).
+ *
+ * This file is part of grvslib.
+ *
+ * grvslib is free software: you can redistribute it and/or modify it under the
+ * terms of version 3 of the GNU General Public License as published by the Free
+ * Software Foundation.
+ *
+ * grvslib is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * grvslib.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <gtest/gtest.h>
+
+// Std C++
+#include <atomic>
+#include <string>
+#include <thread>
+
+// Ours.
+#include <grvslib/concurrency/trace.h>
+#include <grvslib/concurrency/realtime.h>
+
+
+TEST(Concurrency, trace_records_and_exports_chrome_json)
+{
+	using namespace grvslib::trace;
+
+	trace_session session;
+	session.drain();
+	const auto size_before = session.size();
+	const auto dropped_before = session.num_dropped();
+
+	std::thread rt_thread([](){
+		register_this_thread("rt thread");
+		for(int i = 0; i < 3; ++i)
+		{
+			scope block("process block");
+			instant("parameter picked up", 42);
+		}
+		counter("queue depth", 7);
+	});
+	rt_thread.join();
+
+	session.drain();
+	EXPECT_EQ(10, session.size() - size_before);
+	EXPECT_EQ(dropped_before, session.num_dropped());
+
+	std::string json = session.chrome_json();
+	EXPECT_NE(std::string::npos, json.find("\"traceEvents\""));
+	EXPECT_NE(std::string::npos, json.find("\"rt thread\""));
+	EXPECT_NE(std::string::npos, json.find("\"name\":\"process block\",\"ph\":\"B\""));
+	EXPECT_NE(std::string::npos, json.find("\"name\":\"process block\",\"ph\":\"E\""));
+	EXPECT_NE(std::string::npos, json.find("\"args\":{\"arg\":42}"));
+	EXPECT_NE(std::string::npos, json.find("\"args\":{\"queue depth\":7}"));
+}
+
+TEST(Concurrency, trace_counts_dropped_events)
+{
+	using namespace grvslib::trace;
+
+	trace_session session;
+	session.drain();
+	const auto dropped_before = session.num_dropped();
+	std::thread t([](){
+		register_this_thread("tiny buffer", 4);
+		for(int i = 0; i < 10; ++i)
+		{
+			instant("spam");
+		}
+	});
+	t.join();
+	session.drain();
+	EXPECT_EQ(6, session.num_dropped() - dropped_before);
+}
+
+TEST(Concurrency, trace_drops_events_from_unregistered_threads)
+{
+	using namespace grvslib::trace;
+
+	trace_session session;
+	session.drain();
+	const auto size_before = session.size();
+	const auto dropped_before = session.num_dropped();
+	std::thread t([](){
+		scope block("never registered");
+		instant("spam");
+	});
+	t.join();
+	session.drain();
+	EXPECT_EQ(size_before, session.size());
+	EXPECT_EQ(3, session.num_dropped() - dropped_before);
+}
+
+TEST(Concurrency, trace_background_drainer)
+{
+	using namespace grvslib::trace;
+
+	trace_session session;
+	session.drain();
+	const auto size_before = session.size();
+	const auto dropped_before = session.num_dropped();
+	session.start(std::chrono::milliseconds(1));
+	std::thread t([](){
+		register_this_thread("producer", 64);
+		// Many more events than the buffer holds, slowly enough for the drainer to keep up.
+		for(int i = 0; i < 256; ++i)
+		{
+			instant("tick");
+			if(i % 16 == 0)
+			{
+				std::this_thread::sleep_for(std::chrono::milliseconds(5));
+			}
+		}
+	});
+	t.join();
+	session.stop();
+	EXPECT_EQ(256, (session.size() - size_before) + (session.num_dropped() - dropped_before));
+	EXPECT_GT(session.size() - size_before, 64);
+}
+
+#if __cpp_lib_atomic_flag_test >= 201907L
+TEST(Concurrency, trace_instruments_atomic_notifying_parameter)
+{
+	if constexpr(!grvslib::trace::enabled)
+	{
+		GTEST_SKIP() << "Built without GRVSLIB_ENABLE_TRACING";
+	}
+
+	grvslib::trace::register_this_thread();
+	grvslib::trace::trace_session session;
+	atomic_notifying_parameter<int> param;
+	int value {0};
+	param.store_and_set(1);
+	param.load_and_clear_if_set(&value);
+	session.drain();
+
+	std::string json = session.chrome_json();
+	EXPECT_NE(std::string::npos, json.find("atomic_notifying_parameter store_and_set"));
+	EXPECT_NE(std::string::npos, json.find("atomic_notifying_parameter picked up"));
+}
+#endif //__cpp_lib_atomic_flag_test >= 201907L
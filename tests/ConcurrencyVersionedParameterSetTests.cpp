@@ -0,0 +1,145 @@
+/*
+ * Copyright 2024 Gary R. Van Sickle (grvs@users.sourceforge.net).
+ *
+ * This file is part of grvslib.
+ *
+ * grvslib is free software: you can redistribute it and/or modify it under the
+ * terms of version 3 of the GNU General Public License as published by the Free
+ * Software Foundation.
+ *
+ * grvslib is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * grvslib.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <gtest/gtest.h>
+
+// Std C++
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+// Ours.
+#include <grvslib/concurrency/versioned_parameter_set.h>
+
+namespace
+{
+
+enum class filter_type { lowpass, highpass, bandpass };
+
+struct filter_params
+{
+	filter_type m_type {filter_type::lowpass};
+	float m_frequency {1000.0f};
+	float m_q {0.707f};
+};
+
+}
+
+TEST(Concurrency, versioned_parameter_set_transactions)
+{
+	versioned_parameter_set<filter_params> params;
+	EXPECT_FALSE(params.update());
+	EXPECT_EQ(0, params.current_version());
+	EXPECT_EQ(1000.0f, params.current().m_frequency);
+
+	{
+		auto t = params.begin_transaction();
+		t.set(&filter_params::m_type, filter_type::bandpass).set(&filter_params::m_frequency, 440.0f);
+		t->m_q = 10.0f;
+		// Nothing is visible until the commit.
+		EXPECT_FALSE(params.update());
+		EXPECT_EQ(1, t.commit());
+	}
+	EXPECT_TRUE(params.update());
+	EXPECT_EQ(1, params.current_version());
+	EXPECT_EQ(filter_type::bandpass, params.current().m_type);
+	EXPECT_EQ(440.0f, params.current().m_frequency);
+	EXPECT_EQ(10.0f, params.current().m_q);
+	EXPECT_FALSE(params.update());
+
+	// An abandoned transaction leaves no trace, not even in the next one.
+	{
+		auto t = params.begin_transaction();
+		t->m_q = 99.0f;
+	}
+	{
+		auto t = params.begin_transaction();
+		EXPECT_EQ(10.0f, t->m_q);
+		t->m_frequency = 880.0f;
+		t.commit();
+	}
+
+	// Several commits between updates: the consumer goes straight to the latest.
+	params.store(filter_params{filter_type::highpass, 50.0f, 1.0f});
+	filter_params p;
+	EXPECT_TRUE(params.load_if_changed(&p));
+	EXPECT_EQ(3, params.current_version());
+	EXPECT_EQ(filter_type::highpass, p.m_type);
+	EXPECT_EQ(50.0f, p.m_frequency);
+	EXPECT_FALSE(params.load_if_changed(&p));
+}
+
+TEST(Concurrency, versioned_parameter_set_never_torn)
+{
+	// Producers commit sets whose fields are all derived from one number.  The consumer must never see a mix.
+	struct derived
+	{
+		std::uint64_t m_a {0};
+		std::uint64_t m_b {0};
+		std::uint64_t m_c {0};
+		std::uint64_t m_pad[5] {};
+	};
+	constexpr int c_num_producers = 2;
+	constexpr std::uint64_t c_commits_per_producer = 20'000;
+	versioned_parameter_set<derived> params;
+	std::atomic<int> num_running {c_num_producers};
+
+	std::vector<std::thread> producers;
+	for(int t = 0; t < c_num_producers; ++t)
+	{
+		producers.emplace_back([&, t](){
+			for(std::uint64_t i = 1; i <= c_commits_per_producer; ++i)
+			{
+				const std::uint64_t n = i * c_num_producers + t;
+				auto tx = params.begin_transaction();
+				tx->m_a = n;
+				tx->m_b = n * 2;
+				tx->m_c = n * 3;
+				tx.commit();
+				if(i % 64 == 0)
+				{
+					// Give the consumer a look in on a single core.
+					std::this_thread::yield();
+				}
+			}
+			num_running--;
+		});
+	}
+
+	int num_torn {0}, num_backwards {0};
+	std::uint64_t last_version {0};
+	while(num_running.load() != 0)
+	{
+		if(params.update())
+		{
+			const auto& p = params.current();
+			num_torn += (p.m_b != p.m_a * 2 || p.m_c != p.m_a * 3);
+			num_backwards += (params.current_version() <= last_version);
+			last_version = params.current_version();
+		}
+	}
+	for(auto& t : producers)
+	{
+		t.join();
+	}
+	params.update();
+
+	EXPECT_EQ(0, num_torn);
+	EXPECT_EQ(0, num_backwards);
+	EXPECT_EQ(c_num_producers * c_commits_per_producer, params.current_version());
+}
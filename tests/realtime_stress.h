@@ -0,0 +1,280 @@
+/*
+ * Copyright 2024 Gary R. Van Sickle (grvs@users.sourceforge.net).
+ *
+ * This file is part of grvslib.
+ *
+ * grvslib is free software: you can redistribute it and/or modify it under the
+ * terms of version 3 of the GNU General Public License as published by the Free
+ * Software Foundation.
+ *
+ * grvslib is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * grvslib.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file A randomized producer/consumer stress harness for atomic_notifying_parameter and friends.
+ *
+ * The defaults are sized to finish in a few seconds even under ThreadSanitizer.  For soak runs, set in the environment:
+ * - GRVSLIB_STRESS_ITERATIONS:  Stores per producer (default 200000).
+ * - GRVSLIB_STRESS_SECONDS:     Run for at least this long instead, ignoring GRVSLIB_STRESS_ITERATIONS.
+ * - GRVSLIB_STRESS_SEED:        PRNG seed, to replay a failing run.  The seed used is reported with any failure.
+ */
+
+#ifndef GRVSLIB_TESTS_REALTIME_STRESS_H
+#define GRVSLIB_TESTS_REALTIME_STRESS_H
+
+// Std C++
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <random>
+#include <thread>
+#include <vector>
+
+namespace grvslib::stress
+{
+
+struct config
+{
+	int m_num_producers {2};
+	std::uint64_t m_iterations_per_producer {200'000};
+	double m_min_seconds {0.0};
+	std::uint64_t m_seed {0};
+
+	/// The defaults, overridden from the environment as described above.
+	static config from_environment(int num_producers = 2)
+	{
+		config c;
+		c.m_num_producers = num_producers;
+		if(const char* s = std::getenv("GRVSLIB_STRESS_ITERATIONS"))
+		{
+			c.m_iterations_per_producer = std::strtoull(s, nullptr, 10);
+		}
+		if(const char* s = std::getenv("GRVSLIB_STRESS_SECONDS"))
+		{
+			c.m_min_seconds = std::strtod(s, nullptr);
+		}
+		if(const char* s = std::getenv("GRVSLIB_STRESS_SEED"))
+		{
+			c.m_seed = std::strtoull(s, nullptr, 10);
+		}
+		else
+		{
+			c.m_seed = std::random_device{}();
+		}
+		return c;
+	}
+};
+
+struct result
+{
+	std::uint64_t m_num_stores {0};
+	std::uint64_t m_num_loads {0};
+	std::uint64_t m_num_pickups {0};
+	/// Payloads whose checksum didn't match, i.e. torn reads.
+	std::uint64_t m_num_torn {0};
+	/// Pickups older than one already seen from the same producer.
+	std::uint64_t m_num_regressions {0};
+	/// True if the consumer's final value wasn't the last thing any producer stored.
+	bool m_lost_final_update {false};
+	double m_seconds {0.0};
+
+	std::uint64_t num_violations() const
+	{
+		return m_num_torn + m_num_regressions + (m_lost_final_update ? 1 : 0);
+	}
+
+	double ops_per_second() const
+	{
+		return m_seconds > 0.0 ? static_cast<double>(m_num_stores + m_num_loads) / m_seconds : 0.0;
+	}
+};
+
+/**
+ * A payload of @p NumWords 64-bit words, all derived from (producer, sequence number), plus a checksum over them.
+ * A read which mixes two writes will almost certainly fail verify().
+ */
+template<std::size_t NumWords>
+struct checked_payload
+{
+	std::uint64_t m_producer {0};
+	std::uint64_t m_sequence {0};
+	std::array<std::uint64_t, NumWords> m_words {};
+	std::uint64_t m_checksum {0};
+
+	static checked_payload make(std::uint64_t producer, std::uint64_t sequence)
+	{
+		checked_payload p;
+		p.m_producer = producer;
+		p.m_sequence = sequence;
+		std::uint64_t x = (producer << 48) ^ sequence;
+		for(auto& w : p.m_words)
+		{
+			x = x * 6364136223846793005ULL + 1442695040888963407ULL;
+			w = x;
+		}
+		p.m_checksum = p.compute_checksum();
+		return p;
+	}
+
+	std::uint64_t compute_checksum() const
+	{
+		std::uint64_t sum = m_producer * 31 + m_sequence;
+		for(auto w : m_words)
+		{
+			sum = (sum ^ w) * 1099511628211ULL;
+		}
+		return sum;
+	}
+
+	bool verify() const { return compute_checksum() == m_checksum; }
+};
+
+/**
+ * For arithmetic payloads: pack the producer into the top byte and the sequence number below it.  A scalar can't
+ * tear, so verify() only checks for the impossible-by-construction zero producer.
+ */
+struct packed_scalar_payload
+{
+	std::uint64_t m_value {0};
+
+	static std::uint64_t make(std::uint64_t producer, std::uint64_t sequence) { return ((producer + 1) << 56) | sequence; }
+	static std::uint64_t producer_of(std::uint64_t v) { return (v >> 56) - 1; }
+	static std::uint64_t sequence_of(std::uint64_t v) { return v & ((std::uint64_t(1) << 56) - 1); }
+	static bool verify(std::uint64_t v) { return (v >> 56) != 0; }
+};
+
+/**
+ * Random delays: mostly nothing, sometimes a short spin, occasionally a yield.
+ */
+class jitter
+{
+public:
+	explicit jitter(std::uint64_t seed) : m_rng(static_cast<std::uint32_t>(seed ^ (seed >> 32))) {}
+
+	void operator()()
+	{
+		auto r = m_rng();
+		if((r & 63) == 0)
+		{
+			std::this_thread::yield();
+		}
+		else if((r & 15) == 0)
+		{
+			for(unsigned i = 0, n = (r >> 8) & 255; i < n; ++i)
+			{
+				// Keeps the compiler from deleting the loop.
+				std::atomic_signal_fence(std::memory_order_seq_cst);
+			}
+		}
+	}
+
+private:
+	std::minstd_rand m_rng;
+};
+
+/**
+ * Run @p c.m_num_producers producer threads calling store_and_set() on @p param against one consumer thread polling
+ * load_and_clear_if_set(), with random jitter on both sides.
+ *
+ * @tparam Param    An atomic_notifying_parameter instantiation.
+ * @tparam Payload  Its payload type.
+ * @param make      (producer, sequence) -> Payload
+ * @param decode    (const Payload&, std::uint64_t& producer, std::uint64_t& sequence) -> bool checksum_ok
+ */
+template<typename Param, typename Payload, typename Make, typename Decode>
+result run(Param& param, const config& c, Make make, Decode decode)
+{
+	result r;
+	std::atomic<int> num_producers_running {c.m_num_producers};
+	std::vector<std::uint64_t> last_stored(c.m_num_producers, 0);
+	std::vector<std::uint64_t> stores_per_producer(c.m_num_producers, 0);
+
+	const auto start = std::chrono::steady_clock::now();
+	auto keep_going = [&](std::uint64_t i){
+		if(c.m_min_seconds > 0.0)
+		{
+			return (i & 1023) != 0
+				|| std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() < c.m_min_seconds;
+		}
+		return i < c.m_iterations_per_producer;
+	};
+
+	std::vector<std::thread> producers;
+	for(int p = 0; p < c.m_num_producers; ++p)
+	{
+		producers.emplace_back([&, p](){
+			jitter j(c.m_seed + 1 + p);
+			std::uint64_t seq = 1;
+			for(; keep_going(seq - 1); ++seq)
+			{
+				param.store_and_set(make(p, seq));
+				j();
+			}
+			last_stored[p] = seq - 1;
+			stores_per_producer[p] = seq - 1;
+			num_producers_running.fetch_sub(1, std::memory_order_release);
+		});
+	}
+
+	Payload value {};
+	std::vector<std::uint64_t> last_seen(c.m_num_producers, 0);
+	std::uint64_t last_producer = ~std::uint64_t(0);
+	std::uint64_t last_sequence = 0;
+	auto consume_once = [&](){
+		r.m_num_loads++;
+		if(param.load_and_clear_if_set(&value))
+		{
+			r.m_num_pickups++;
+			std::uint64_t producer, sequence;
+			if(!decode(value, producer, sequence) || producer >= last_seen.size())
+			{
+				r.m_num_torn++;
+				return;
+			}
+			if(sequence < last_seen[producer])
+			{
+				r.m_num_regressions++;
+			}
+			last_seen[producer] = sequence;
+			last_producer = producer;
+			last_sequence = sequence;
+		}
+	};
+
+	{
+		jitter j(c.m_seed);
+		while(num_producers_running.load(std::memory_order_acquire) != 0)
+		{
+			consume_once();
+			j();
+		}
+	}
+	for(auto& t : producers)
+	{
+		t.join();
+	}
+	// Drain whatever is left.  A non-atomic payload can report "busy" once, so give it a few tries.
+	for(int i = 0; i < 4; ++i)
+	{
+		consume_once();
+	}
+	r.m_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	for(auto n : stores_per_producer)
+	{
+		r.m_num_stores += n;
+	}
+	r.m_lost_final_update = (last_producer >= last_stored.size()) || (last_sequence != last_stored[last_producer]);
+	return r;
+}
+
+}
+
+#endif //GRVSLIB_TESTS_REALTIME_STRESS_H